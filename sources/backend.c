@@ -13,6 +13,8 @@
 #include <ctype.h>
 #include <inttypes.h>
 #include <assert.h>
+#include <errno.h>
+#include <pthread.h>
 #include <arpa/inet.h>
 
 #include <machinarium.h>
@@ -230,7 +232,8 @@ od_backend_startup(od_server_t *server, kiwi_params_t *params)
 static inline int
 od_backend_connect_to(od_server_t *server,
                       char *context,
-                      od_config_storage_t *server_config)
+                      od_config_storage_t *server_config,
+                      machine_tls_t *tls)
 {
 	od_instance_t *instance = server->global->instance;
 	assert(server->io == NULL);
@@ -252,11 +255,12 @@ od_backend_connect_to(od_server_t *server,
 		return -1;
 	}
 
-	/* set tls options */
-	if (server_config->tls_mode != OD_TLS_DISABLE) {
+	/* set tls options, unless shared route tls is used */
+	if (server_config->tls_mode != OD_TLS_DISABLE && tls == NULL) {
 		server->tls = od_tls_backend(server_config);
 		if (server->tls == NULL)
 			return -1;
+		tls = server->tls;
 	}
 
 	uint64_t time_connect_start = 0;
@@ -295,8 +299,19 @@ od_backend_connect_to(od_server_t *server,
 			char port[16];
 			od_snprintf(port, sizeof(port), "%d", server_config->port);
 
-			rc = machine_getaddrinfo(server_config->host, port, NULL, &ai, 0);
+			uint32_t timeout = instance->config.dns_timeout;
+			if (timeout == 0)
+				timeout = UINT32_MAX;
+			rc = machine_getaddrinfo(server_config->host, port, NULL, &ai,
+			                         timeout);
 			if (rc != 0) {
+				if (rc == -1 && machine_errno() == ETIMEDOUT) {
+					od_error(&instance->logger, context, NULL, server,
+					         "failed to resolve %s:%d: timed out",
+					         server_config->host,
+					         server_config->port);
+					return -1;
+				}
 				od_error(&instance->logger, context, NULL, server,
 				         "failed to resolve %s:%d",
 				         server_config->host,
@@ -324,7 +339,7 @@ od_backend_connect_to(od_server_t *server,
 	/* connect to server */
 	rc = machine_connect(server->io, saddr, UINT32_MAX);
 	if (ai)
-		freeaddrinfo(ai);
+		machine_freeaddrinfo(ai);
 	if (rc == -1) {
 		if (server_config->host) {
 			od_error(&instance->logger, context, server->client, server,
@@ -339,7 +354,8 @@ od_backend_connect_to(od_server_t *server,
 
 	/* do tls handshake */
 	if (server_config->tls_mode != OD_TLS_DISABLE) {
-		rc = od_tls_backend_connect(server, &instance->logger, server_config);
+		rc = od_tls_backend_connect(server, &instance->logger, server_config,
+		                            tls);
 		if (rc == -1)
 			return -1;
 	}
@@ -369,6 +385,30 @@ od_backend_connect_to(od_server_t *server,
 	return 0;
 }
 
+static inline machine_tls_t*
+od_backend_route_tls(od_route_t *route, od_config_storage_t *server_config)
+{
+	/* server connections of the route share tls context and
+	 * session, so reconnects are able to resume it.
+	 *
+	 * Route tls is created by the first connect outside of router
+	 * locks and published once, a concurrent copy is dropped. */
+	machine_tls_t *tls;
+	tls = __atomic_load_n(&route->tls, __ATOMIC_ACQUIRE);
+	if (tls || server_config->tls_mode == OD_TLS_DISABLE)
+		return tls;
+	tls = od_tls_backend(server_config);
+	if (tls == NULL)
+		return NULL;
+	machine_tls_t *prev;
+	prev = __sync_val_compare_and_swap(&route->tls, NULL, tls);
+	if (prev) {
+		machine_tls_free(tls);
+		tls = prev;
+	}
+	return tls;
+}
+
 int
 od_backend_connect(od_server_t *server, char *context)
 {
@@ -379,8 +419,10 @@ od_backend_connect(od_server_t *server, char *context)
 	server_config = route->config->storage;
 
 	/* connect to server */
+	machine_tls_t *tls;
+	tls = od_backend_route_tls(route, server_config);
 	int rc;
-	rc = od_backend_connect_to(server, context, server_config);
+	rc = od_backend_connect_to(server, context, server_config, tls);
 	if (rc == -1)
 		return -1;
 
@@ -407,7 +449,7 @@ od_backend_connect_cancel(od_server_t *server,
 	od_instance_t *instance = server->global->instance;
 	/* connect to server */
 	int rc;
-	rc = od_backend_connect_to(server, "cancel", server_config);
+	rc = od_backend_connect_to(server, "cancel", server_config, NULL);
 	if (rc == -1)
 		return -1;
 	/* send cancel request */
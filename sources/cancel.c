@@ -13,6 +13,7 @@
 #include <ctype.h>
 #include <inttypes.h>
 #include <assert.h>
+#include <pthread.h>
 
 #include <machinarium.h>
 #include <kiwi.h>
@@ -38,28 +39,104 @@ od_cancel(od_global_t *global,
 	return 0;
 }
 
+static inline od_hash_t
+od_cancel_hash(kiwi_key_t *key)
+{
+	return od_hash(key, sizeof(kiwi_key_t));
+}
+
+void
+od_cancel_index_init(od_cancel_index_t *index)
+{
+	index->buckets = NULL;
+	index->size    = 0;
+	index->count   = 0;
+}
+
+void
+od_cancel_index_free(od_cancel_index_t *index)
+{
+	if (index->buckets)
+		free(index->buckets);
+	od_cancel_index_init(index);
+}
+
 static inline int
-od_cancel_cmp(od_server_t *server, void *arg)
+od_cancel_index_resize(od_cancel_index_t *index, int size)
 {
-	kiwi_key_t *key = arg;
-	return kiwi_key_cmp(&server->key_client, key);
+	od_list_t *buckets;
+	buckets = malloc(sizeof(od_list_t) * size);
+	if (buckets == NULL)
+		return -1;
+	int i;
+	for (i = 0; i < size; i++)
+		od_list_init(&buckets[i]);
+	for (i = 0; i < index->size; i++) {
+		od_list_t *j, *n;
+		od_list_foreach_safe(&index->buckets[i], j, n) {
+			od_server_t *server;
+			server = od_container_of(j, od_server_t, link_cancel);
+			od_hash_t hash = od_cancel_hash(&server->key_client);
+			od_list_init(&server->link_cancel);
+			od_list_append(&buckets[hash & (size - 1)], &server->link_cancel);
+		}
+	}
+	if (index->buckets)
+		free(index->buckets);
+	index->buckets = buckets;
+	index->size = size;
+	return 0;
 }
 
-int od_cancel_find(od_route_pool_t *route_pool, kiwi_key_t *key,
+int
+od_cancel_index_add(od_cancel_index_t *index, od_server_t *server)
+{
+	/* keep load factor below one, but continue to use
+	 * current buckets if resize fails */
+	if (index->count >= index->size) {
+		int rc;
+		rc = od_cancel_index_resize(index, index->size ? index->size * 2 : 64);
+		if (rc == -1 && index->size == 0)
+			return -1;
+	}
+	od_hash_t hash = od_cancel_hash(&server->key_client);
+	od_list_append(&index->buckets[hash & (index->size - 1)],
+	               &server->link_cancel);
+	index->count++;
+	return 0;
+}
+
+void
+od_cancel_index_remove(od_cancel_index_t *index, od_server_t *server)
+{
+	if (od_list_empty(&server->link_cancel))
+		return;
+	assert(index->count > 0);
+	index->count--;
+	od_list_unlink(&server->link_cancel);
+	od_list_init(&server->link_cancel);
+}
+
+int od_cancel_find(od_cancel_index_t *index, kiwi_key_t *key,
                    od_router_cancel_t *cancel)
 {
-	/* match server by client key (forge) */
-	od_server_t *server;
-	server = od_route_pool_server_foreach(route_pool, OD_SERVER_ACTIVE,
-	                                      od_cancel_cmp,
-	                                      key);
-	if (server == NULL)
+	/* match active server by client key (forge) */
+	if (index->size == 0)
 		return -1;
-	od_route_t *route = server->route;
-	cancel->id = server->id;
-	cancel->config = od_config_storage_copy(route->config->storage);
-	if (cancel->config == NULL)
-		return -1;
-	cancel->key = server->key;
-	return 0;
+	od_hash_t hash = od_cancel_hash(key);
+	od_list_t *i;
+	od_list_foreach(&index->buckets[hash & (index->size - 1)], i) {
+		od_server_t *server;
+		server = od_container_of(i, od_server_t, link_cancel);
+		if (! kiwi_key_cmp(&server->key_client, key))
+			continue;
+		od_route_t *route = server->route;
+		cancel->id = server->id;
+		cancel->config = od_config_storage_copy(route->config->storage);
+		if (cancel->config == NULL)
+			return -1;
+		cancel->key = server->key;
+		return 0;
+	}
+	return -1;
 }
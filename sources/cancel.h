@@ -7,7 +7,22 @@
  * Scalable PostgreSQL connection pooler.
 */
 
+typedef struct od_cancel_index od_cancel_index_t;
+
+/* active servers hashed by assigned client key */
+struct od_cancel_index
+{
+	od_list_t *buckets;
+	int        size;
+	int        count;
+};
+
+void od_cancel_index_init(od_cancel_index_t*);
+void od_cancel_index_free(od_cancel_index_t*);
+int  od_cancel_index_add(od_cancel_index_t*, od_server_t*);
+void od_cancel_index_remove(od_cancel_index_t*, od_server_t*);
+
 int od_cancel(od_global_t*, od_config_storage_t*, kiwi_key_t*, od_id_t*);
-int od_cancel_find(od_route_pool_t*, kiwi_key_t*, od_router_cancel_t*);
+int od_cancel_find(od_cancel_index_t*, kiwi_key_t*, od_router_cancel_t*);
 
 #endif /* ODYSSEY_CANCEL_H */
@@ -44,11 +44,16 @@ struct od_client
 	od_config_listen_t *config_listen;
 	uint64_t            time_accept;
 	uint64_t            time_setup;
+	int                 is_startup_done;
 	kiwi_be_startup_t   startup;
 	kiwi_params_t       params;
 	kiwi_key_t          key;
 	od_server_t        *server;
 	void               *route;
+	int                 router_shard;
+	machine_channel_t  *router_reply;
+	machine_msg_t      *router_msg;
+	od_atomic_u32_t    *worker_load;
 	od_global_t        *global;
 	od_list_t           link_pool;
 	od_list_t           link;
@@ -61,14 +66,20 @@ od_client_init(od_client_t *client)
 	client->coroutine_id = 0;
 	client->coroutine_attacher_id = 0;
 	client->io = NULL;
+	client->io_notify = NULL;
 	client->tls = NULL;
 	client->config = NULL;
 	client->config_listen = NULL;
 	client->server = NULL;
 	client->route = NULL;
+	client->router_shard = -1;
+	client->router_reply = NULL;
+	client->router_msg = NULL;
+	client->worker_load = NULL;
 	client->global = NULL;
 	client->time_accept = 0;
 	client->time_setup = 0;
+	client->is_startup_done = 0;
 	client->ctl.op = OD_CLIENT_OP_NONE;
 	kiwi_be_startup_init(&client->startup);
 	kiwi_params_init(&client->params);
@@ -91,6 +102,12 @@ od_client_allocate(void)
 static inline void
 od_client_free(od_client_t *client)
 {
+	if (client->worker_load)
+		od_atomic_u32_dec(client->worker_load);
+	if (client->router_msg)
+		machine_msg_free(client->router_msg);
+	if (client->router_reply)
+		machine_channel_free(client->router_reply);
 	kiwi_be_startup_free(&client->startup);
 	kiwi_params_free(&client->params);
 	free(client);
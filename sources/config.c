@@ -13,6 +13,7 @@
 #include <ctype.h>
 #include <inttypes.h>
 #include <assert.h>
+#include <pthread.h>
 
 #include <machinarium.h>
 #include <kiwi.h>
@@ -45,14 +46,22 @@ od_config_init(od_config_t *config)
 	config->keepalive = 7200;
 	config->workers = 1;
 	config->resolvers = 1;
+	config->tls_workers = 0;
+	config->dns_ttl = 0;
+	config->dns_negative_ttl = 0;
+	config->dns_timeout = 10000;
 	config->client_max_set = 0;
 	config->client_max = 0;
 	config->cache_coroutine = 0;
 	config->cache_msg_gc_size = 0;
 	config->coroutine_stack_size = 4;
+	config->coroutine_stack_hugepages = 0;
+	config->coroutine_stack_guard = 1;
+	config->poll_backend = NULL;
 	od_list_init(&config->storages);
 	od_list_init(&config->routes);
 	od_list_init(&config->listen);
+	od_config_table_init(&config->routes_table);
 }
 
 static void
@@ -61,6 +70,7 @@ od_config_listen_free(od_config_listen_t*);
 void
 od_config_free(od_config_t *config)
 {
+	od_config_table_free(&config->routes_table);
 	od_list_t *i, *n;
 	od_list_foreach_safe(&config->routes, i, n) {
 		od_config_route_t *route;
@@ -84,6 +94,8 @@ od_config_free(od_config_t *config)
 		free(config->log_syslog_ident);
 	if (config->log_syslog_facility)
 		free(config->log_syslog_facility);
+	if (config->poll_backend)
+		free(config->poll_backend);
 }
 
 od_config_listen_t*
@@ -199,6 +211,7 @@ od_config_storage_copy(od_config_storage_t *storage)
 	}
 	copy->port = storage->port;
 	copy->tls_mode = storage->tls_mode;
+	copy->tls_ktls = storage->tls_ktls;
 	if (storage->tls) {
 		copy->tls = strdup(storage->tls);
 		if (copy->tls == NULL)
@@ -347,43 +360,7 @@ od_config_route_unref(od_config_route_t *route)
 od_config_route_t*
 od_config_route_forward(od_config_t *config, char *db_name, char *user_name)
 {
-	od_config_route_t *route_db_user = NULL;
-	od_config_route_t *route_db_default = NULL;
-	od_config_route_t *route_default_user = NULL;
-	od_config_route_t *route_default_default = NULL;
-
-	od_list_t *i;
-	od_list_foreach(&config->routes, i) {
-		od_config_route_t *route;
-		route = od_container_of(i, od_config_route_t, link);
-		if (route->obsolete)
-			continue;
-		if (route->db_is_default) {
-			if (route->user_is_default)
-				route_default_default = route;
-			else
-			if (strcmp(route->user_name, user_name) == 0)
-				route_default_user = route;
-		} else
-		if (strcmp(route->db_name, db_name) == 0) {
-			if (route->user_is_default)
-				route_db_default = route;
-			else
-			if (strcmp(route->user_name, user_name) == 0)
-				route_db_user = route;
-		}
-	}
-
-	if (route_db_user)
-		return route_db_user;
-
-	if (route_db_default)
-		return route_db_default;
-
-	if (route_default_user)
-		return route_default_user;
-
-	return route_default_default;
+	return od_config_table_forward(&config->routes_table, db_name, user_name);
 }
 
 od_config_route_t*
@@ -440,6 +417,10 @@ od_config_storage_compare(od_config_storage_t *a, od_config_storage_t *b)
 	if (a->tls_mode != b->tls_mode)
 		return 0;
 
+	/* tls_ktls */
+	if (a->tls_ktls != b->tls_ktls)
+		return 0;
+
 	/* tls_ca_file */
 	if (a->tls_ca_file && b->tls_ca_file) {
 		if (strcmp(a->tls_ca_file, b->tls_ca_file) != 0)
@@ -688,9 +669,22 @@ od_config_merge(od_config_t *config, od_logger_t *logger, od_config_t *src)
 	       count_new, count_deleted,
 	       count_mark);
 
+	/* recompile routes table */
+	int rc;
+	rc = od_config_compile(config);
+	if (rc == -1)
+		od_error(logger, "config", NULL, NULL,
+		         "failed to compile routes table");
+
 	return count_new + count_mark + count_deleted;
 }
 
+int
+od_config_compile(od_config_t *config)
+{
+	return od_config_table_build(&config->routes_table, &config->routes);
+}
+
 int
 od_config_validate(od_config_t *config, od_logger_t *logger)
 {
@@ -706,12 +700,46 @@ od_config_validate(od_config_t *config, od_logger_t *logger)
 		return -1;
 	}
 
+	/* tls_workers */
+	if (config->tls_workers < 0) {
+		od_error(logger, "config", NULL, NULL, "bad tls_workers number");
+		return -1;
+	}
+
+	/* dns_ttl */
+	if (config->dns_ttl < 0 || config->dns_negative_ttl < 0) {
+		od_error(logger, "config", NULL, NULL, "bad dns_ttl number");
+		return -1;
+	}
+
+	/* dns_timeout */
+	if (config->dns_timeout < 0) {
+		od_error(logger, "config", NULL, NULL, "bad dns_timeout number");
+		return -1;
+	}
+
 	/* coroutine_stack_size */
 	if (config->coroutine_stack_size < 4) {
 		od_error(logger, "config", NULL, NULL, "bad coroutine_stack_size number");
 		return -1;
 	}
 
+	/* coroutine_stack_hugepages */
+	if (config->coroutine_stack_hugepages && config->coroutine_stack_guard) {
+		od_error(logger, "config", NULL, NULL,
+		         "coroutine_stack_hugepages requires coroutine_stack_guard to be disabled");
+		return -1;
+	}
+
+	/* poll_backend */
+	if (config->poll_backend) {
+		if (strcmp(config->poll_backend, "epoll") != 0 &&
+		    strcmp(config->poll_backend, "io_uring") != 0) {
+			od_error(logger, "config", NULL, NULL, "unknown poll_backend");
+			return -1;
+		}
+	}
+
 	/* log format */
 	if (config->log_format == NULL) {
 		od_error(logger, "config", NULL, NULL, "log is not defined");
@@ -760,6 +788,11 @@ od_config_validate(od_config_t *config, od_logger_t *logger)
 				         "listen host is not set and no unix_socket_dir is specified");
 				return -1;
 			}
+			if (listen->reuseport) {
+				od_error(logger, "config", NULL, NULL,
+				         "listen reuseport is not supported for unix socket");
+				return -1;
+			}
 		}
 
 		/* tls */
@@ -1028,10 +1061,32 @@ od_config_print(od_config_t *config, od_logger_t *logger, int routes_only)
 	       "cache_coroutine      %d", config->cache_coroutine);
 	od_log(logger, "config", NULL, NULL,
 	       "coroutine_stack_size %d", config->coroutine_stack_size);
+	if (config->coroutine_stack_hugepages)
+		od_log(logger, "config", NULL, NULL,
+		       "coroutine_stack_hugepages %s",
+		       od_config_yes_no(config->coroutine_stack_hugepages));
+	if (! config->coroutine_stack_guard)
+		od_log(logger, "config", NULL, NULL,
+		       "coroutine_stack_guard %s",
+		       od_config_yes_no(config->coroutine_stack_guard));
+	if (config->poll_backend)
+		od_log(logger, "config", NULL, NULL,
+		       "poll_backend         %s", config->poll_backend);
 	od_log(logger, "config", NULL, NULL,
 	       "workers              %d", config->workers);
 	od_log(logger, "config", NULL, NULL,
 	       "resolvers            %d", config->resolvers);
+	if (config->tls_workers)
+		od_log(logger, "config", NULL, NULL,
+		       "tls_workers          %d", config->tls_workers);
+	if (config->dns_ttl) {
+		od_log(logger, "config", NULL, NULL,
+		       "dns_ttl              %d", config->dns_ttl);
+		od_log(logger, "config", NULL, NULL,
+		       "dns_negative_ttl     %d", config->dns_negative_ttl);
+	}
+	od_log(logger, "config", NULL, NULL,
+	       "dns_timeout          %d", config->dns_timeout);
 	od_log(logger, "config", NULL, NULL, "");
 	od_list_t *i;
 	od_list_foreach(&config->listen, i)
@@ -1045,6 +1100,9 @@ od_config_print(od_config_t *config, od_logger_t *logger, int routes_only)
 		       "  port             %d", listen->port);
 		od_log(logger, "config", NULL, NULL,
 		       "  backlog          %d", listen->backlog);
+		if (listen->reuseport)
+			od_log(logger, "config", NULL, NULL,
+			       "  reuseport        yes");
 		if (listen->tls)
 			od_log(logger, "config", NULL, NULL,
 			       "  tls              %s", listen->tls);
@@ -1060,6 +1118,9 @@ od_config_print(od_config_t *config, od_logger_t *logger, int routes_only)
 		if (listen->tls_protocols)
 			od_log(logger, "config", NULL, NULL,
 			       "  tls_protocols    %s", listen->tls_protocols);
+		if (listen->tls_ktls)
+			od_log(logger, "config", NULL, NULL,
+			       "  tls_ktls         yes");
 		od_log(logger, "config", NULL, NULL, "");
 	}
 log_routes:;
@@ -1137,6 +1198,9 @@ log_routes:;
 		if (route->storage->tls_protocols)
 			od_log(logger, "config", NULL, NULL,
 			       "  tls_protocols    %s", route->storage->tls_protocols);
+		if (route->storage->tls_ktls)
+			od_log(logger, "config", NULL, NULL,
+			       "  tls_ktls         yes");
 		if (route->storage_db)
 			od_log(logger, "config", NULL, NULL,
 			       "  storage_db       %s", route->storage_db);
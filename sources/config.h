@@ -57,6 +57,7 @@ struct od_config_storage
 	char              *tls_key_file;
 	char              *tls_cert_file;
 	char              *tls_protocols;
+	int                tls_ktls;
 	od_list_t          link;
 };
 
@@ -120,12 +121,14 @@ struct od_config_listen
 	char      *host;
 	int        port;
 	int        backlog;
+	int        reuseport;
 	od_tls_t   tls_mode;
 	char      *tls;
 	char      *tls_ca_file;
 	char      *tls_key_file;
 	char      *tls_cert_file;
 	char      *tls_protocols;
+	int        tls_ktls;
 	od_list_t  link;
 };
 
@@ -156,15 +159,23 @@ struct od_config
 	int        keepalive;
 	int        workers;
 	int        resolvers;
+	int        tls_workers;
+	int        dns_ttl;
+	int        dns_negative_ttl;
+	int        dns_timeout;
 	int        client_max_set;
 	int        client_max;
 	int        cache_coroutine;
 	int        cache_msg_gc_size;
 	int        coroutine_stack_size;
+	int        coroutine_stack_hugepages;
+	int        coroutine_stack_guard;
+	char      *poll_backend;
 	/* temprorary storages */
 	od_list_t  storages;
 	/* routes */
 	od_list_t  routes;
+	od_config_table_t routes_table;
 	/* listen servers */
 	od_list_t  listen;
 };
@@ -174,6 +185,7 @@ void od_config_free(od_config_t*);
 int  od_config_validate(od_config_t*, od_logger_t*);
 void od_config_print(od_config_t*, od_logger_t*, int);
 int  od_config_merge(od_config_t*, od_logger_t*, od_config_t*);
+int  od_config_compile(od_config_t*);
 
 /* listen */
 od_config_listen_t*
@@ -13,6 +13,7 @@
 #include <ctype.h>
 #include <inttypes.h>
 #include <assert.h>
+#include <pthread.h>
 
 #include <unistd.h>
 #include <fcntl.h>
@@ -50,19 +51,27 @@ enum
 	OD_LHOST,
 	OD_LPORT,
 	OD_LBACKLOG,
+	OD_LREUSEPORT,
 	OD_LNODELAY,
 	OD_LKEEPALIVE,
 	OD_LREADAHEAD,
 	OD_LWORKERS,
 	OD_LRESOLVERS,
+	OD_LTLS_WORKERS,
+	OD_LDNS_TTL,
+	OD_LDNS_NEGATIVE_TTL,
+	OD_LDNS_TIMEOUT,
 	OD_LPIPELINE,
 	OD_LPACKET_READ_SIZE,
 	OD_LPACKET_WRITE_QUEUE,
 	OD_LCACHE,
 	OD_LCACHE_CHUNK,
 	OD_LCACHE_MSG_GC_SIZE,
+	OD_LPOLL_BACKEND,
 	OD_LCACHE_COROUTINE,
 	OD_LCOROUTINE_STACK_SIZE,
+	OD_LCOROUTINE_STACK_HUGEPAGES,
+	OD_LCOROUTINE_STACK_GUARD,
 	OD_LCLIENT_MAX,
 	OD_LCLIENT_FWD_ERROR,
 	OD_LTLS,
@@ -70,6 +79,7 @@ enum
 	OD_LTLS_KEY_FILE,
 	OD_LTLS_CERT_FILE,
 	OD_LTLS_PROTOCOLS,
+	OD_LTLS_KTLS,
 	OD_LSTORAGE,
 	OD_LTYPE,
 	OD_LDEFAULT,
@@ -131,11 +141,16 @@ od_config_keywords[] =
 	od_keyword("host",                 OD_LHOST),
 	od_keyword("port",                 OD_LPORT),
 	od_keyword("backlog",              OD_LBACKLOG),
+	od_keyword("reuseport",            OD_LREUSEPORT),
 	od_keyword("nodelay",              OD_LNODELAY),
 	od_keyword("keepalive",            OD_LKEEPALIVE),
 	od_keyword("readahead",            OD_LREADAHEAD),
 	od_keyword("workers",              OD_LWORKERS),
 	od_keyword("resolvers",            OD_LRESOLVERS),
+	od_keyword("tls_workers",          OD_LTLS_WORKERS),
+	od_keyword("dns_ttl",              OD_LDNS_TTL),
+	od_keyword("dns_negative_ttl",     OD_LDNS_NEGATIVE_TTL),
+	od_keyword("dns_timeout",          OD_LDNS_TIMEOUT),
 	od_keyword("pipeline",             OD_LPIPELINE),
 	od_keyword("packet_read_size",     OD_LPACKET_READ_SIZE),
 	od_keyword("packet_write_queue",   OD_LPACKET_WRITE_QUEUE),
@@ -144,6 +159,9 @@ od_config_keywords[] =
 	od_keyword("cache_msg_gc_size",    OD_LCACHE_MSG_GC_SIZE),
 	od_keyword("cache_coroutine",      OD_LCACHE_COROUTINE),
 	od_keyword("coroutine_stack_size", OD_LCOROUTINE_STACK_SIZE),
+	od_keyword("coroutine_stack_hugepages", OD_LCOROUTINE_STACK_HUGEPAGES),
+	od_keyword("coroutine_stack_guard", OD_LCOROUTINE_STACK_GUARD),
+	od_keyword("poll_backend",         OD_LPOLL_BACKEND),
 	od_keyword("client_max",           OD_LCLIENT_MAX),
 	od_keyword("client_fwd_error",     OD_LCLIENT_FWD_ERROR),
 	od_keyword("tls",                  OD_LTLS),
@@ -151,6 +169,7 @@ od_config_keywords[] =
 	od_keyword("tls_key_file",         OD_LTLS_KEY_FILE),
 	od_keyword("tls_cert_file",        OD_LTLS_CERT_FILE),
 	od_keyword("tls_protocols",        OD_LTLS_PROTOCOLS),
+	od_keyword("tls_ktls",             OD_LTLS_KTLS),
 	/* storage */
 	od_keyword("storage",              OD_LSTORAGE),
 	od_keyword("type",                 OD_LTYPE),
@@ -412,6 +431,11 @@ od_config_reader_listen(od_config_reader_t *reader)
 			if (! od_config_reader_number(reader, &listen->backlog))
 				return -1;
 			continue;
+		/* reuseport */
+		case OD_LREUSEPORT:
+			if (! od_config_reader_yes_no(reader, &listen->reuseport))
+				return -1;
+			continue;
 		/* tls */
 		case OD_LTLS:
 			if (! od_config_reader_string(reader, &listen->tls))
@@ -437,6 +461,11 @@ od_config_reader_listen(od_config_reader_t *reader)
 			if (! od_config_reader_string(reader, &listen->tls_protocols))
 				return -1;
 			continue;
+		/* tls_ktls */
+		case OD_LTLS_KTLS:
+			if (! od_config_reader_yes_no(reader, &listen->tls_ktls))
+				return -1;
+			continue;
 		default:
 			od_config_reader_error(reader, &token, "unexpected parameter");
 			return -1;
@@ -527,6 +556,11 @@ od_config_reader_storage(od_config_reader_t *reader)
 			if (! od_config_reader_string(reader, &storage->tls_protocols))
 				return -1;
 			continue;
+		/* tls_ktls */
+		case OD_LTLS_KTLS:
+			if (! od_config_reader_yes_no(reader, &storage->tls_ktls))
+				return -1;
+			continue;
 		default:
 			od_config_reader_error(reader, &token, "unexpected parameter");
 			return -1;
@@ -971,6 +1005,26 @@ od_config_reader_parse(od_config_reader_t *reader)
 			if (! od_config_reader_number(reader, &config->resolvers))
 				return -1;
 			continue;
+		/* tls_workers */
+		case OD_LTLS_WORKERS:
+			if (! od_config_reader_number(reader, &config->tls_workers))
+				return -1;
+			continue;
+		/* dns_ttl */
+		case OD_LDNS_TTL:
+			if (! od_config_reader_number(reader, &config->dns_ttl))
+				return -1;
+			continue;
+		/* dns_negative_ttl */
+		case OD_LDNS_NEGATIVE_TTL:
+			if (! od_config_reader_number(reader, &config->dns_negative_ttl))
+				return -1;
+			continue;
+		/* dns_timeout */
+		case OD_LDNS_TIMEOUT:
+			if (! od_config_reader_number(reader, &config->dns_timeout))
+				return -1;
+			continue;
 		/* pipeline */
 		/* cache */
 		/* cache_chunk */
@@ -989,6 +1043,11 @@ od_config_reader_parse(od_config_reader_t *reader)
 			if (! od_config_reader_number(reader, &config->cache_msg_gc_size))
 				return -1;
 			continue;
+		/* poll_backend */
+		case OD_LPOLL_BACKEND:
+			if (! od_config_reader_string(reader, &config->poll_backend))
+				return -1;
+			continue;
 		/* cache_coroutine */
 		case OD_LCACHE_COROUTINE:
 			if (! od_config_reader_number(reader, &config->cache_coroutine))
@@ -999,6 +1058,16 @@ od_config_reader_parse(od_config_reader_t *reader)
 			if (! od_config_reader_number(reader, &config->coroutine_stack_size))
 				return -1;
 			continue;
+		/* coroutine_stack_hugepages */
+		case OD_LCOROUTINE_STACK_HUGEPAGES:
+			if (! od_config_reader_yes_no(reader, &config->coroutine_stack_hugepages))
+				return -1;
+			continue;
+		/* coroutine_stack_guard */
+		case OD_LCOROUTINE_STACK_GUARD:
+			if (! od_config_reader_yes_no(reader, &config->coroutine_stack_guard))
+				return -1;
+			continue;
 		/* listen */
 		case OD_LLISTEN:
 			rc = od_config_reader_listen(reader);
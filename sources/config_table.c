@@ -0,0 +1,220 @@
+
+/*
+ * Odyssey.
+ *
+ * Scalable PostgreSQL connection pooler.
+*/
+
+#include <stdlib.h>
+#include <stdarg.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <ctype.h>
+#include <inttypes.h>
+#include <assert.h>
+#include <pthread.h>
+
+#include <machinarium.h>
+#include <kiwi.h>
+#include <odyssey.h>
+
+static inline void
+od_config_table_map_init(od_config_table_map_t *map)
+{
+	map->buckets = NULL;
+	map->size    = 0;
+	map->count   = 0;
+}
+
+static inline void
+od_config_table_node_init(od_config_table_node_t *node)
+{
+	node->name     = NULL;
+	node->name_len = 0;
+	node->hash     = 0;
+	node->route    = NULL;
+	node->next     = NULL;
+	od_config_table_map_init(&node->users);
+}
+
+static void
+od_config_table_map_free(od_config_table_map_t *map)
+{
+	int i;
+	for (i = 0; i < map->size; i++) {
+		od_config_table_node_t *node = map->buckets[i];
+		while (node) {
+			od_config_table_node_t *next = node->next;
+			od_config_table_map_free(&node->users);
+			free(node);
+			node = next;
+		}
+	}
+	if (map->buckets)
+		free(map->buckets);
+	od_config_table_map_init(map);
+}
+
+static inline int
+od_config_table_map_resize(od_config_table_map_t *map, int size)
+{
+	od_config_table_node_t **buckets;
+	buckets = calloc(size, sizeof(od_config_table_node_t*));
+	if (buckets == NULL)
+		return -1;
+	int i;
+	for (i = 0; i < map->size; i++) {
+		od_config_table_node_t *node = map->buckets[i];
+		while (node) {
+			od_config_table_node_t *next = node->next;
+			int pos = node->hash & (size - 1);
+			node->next = buckets[pos];
+			buckets[pos] = node;
+			node = next;
+		}
+	}
+	if (map->buckets)
+		free(map->buckets);
+	map->buckets = buckets;
+	map->size = size;
+	return 0;
+}
+
+static inline od_config_table_node_t*
+od_config_table_map_get(od_config_table_map_t *map, char *name, int name_len,
+                        od_hash_t hash)
+{
+	if (map->size == 0)
+		return NULL;
+	od_config_table_node_t *node;
+	node = map->buckets[hash & (map->size - 1)];
+	for (; node; node = node->next) {
+		if (node->hash == hash && node->name_len == name_len &&
+		    memcmp(node->name, name, name_len) == 0)
+			return node;
+	}
+	return NULL;
+}
+
+static inline od_config_table_node_t*
+od_config_table_map_add(od_config_table_map_t *map, char *name)
+{
+	int name_len = strlen(name);
+	od_hash_t hash = od_hash(name, name_len);
+	od_config_table_node_t *node;
+	node = od_config_table_map_get(map, name, name_len, hash);
+	if (node)
+		return node;
+
+	/* keep load factor below one */
+	if (map->count >= map->size) {
+		int rc;
+		rc = od_config_table_map_resize(map, map->size ? map->size * 2 : 16);
+		if (rc == -1)
+			return NULL;
+	}
+	node = malloc(sizeof(*node));
+	if (node == NULL)
+		return NULL;
+	od_config_table_node_init(node);
+	node->name     = name;
+	node->name_len = name_len;
+	node->hash     = hash;
+	int pos = hash & (map->size - 1);
+	node->next = map->buckets[pos];
+	map->buckets[pos] = node;
+	map->count++;
+	return node;
+}
+
+void
+od_config_table_init(od_config_table_t *table)
+{
+	od_config_table_map_init(&table->databases);
+	od_config_table_node_init(&table->database_default);
+}
+
+void
+od_config_table_free(od_config_table_t *table)
+{
+	od_config_table_map_free(&table->databases);
+	od_config_table_map_free(&table->database_default.users);
+	od_config_table_init(table);
+}
+
+int
+od_config_table_build(od_config_table_t *table, od_list_t *routes)
+{
+	od_config_table_free(table);
+
+	/* names are referenced from active routes, table must be
+	 * rebuilt each time the routes list changes */
+	od_list_t *i;
+	od_list_foreach(routes, i) {
+		od_config_route_t *route;
+		route = od_container_of(i, od_config_route_t, link);
+		if (route->obsolete)
+			continue;
+		od_config_table_node_t *database;
+		if (route->db_is_default) {
+			database = &table->database_default;
+		} else {
+			database = od_config_table_map_add(&table->databases,
+			                                   route->db_name);
+			if (database == NULL)
+				goto error;
+		}
+		if (route->user_is_default) {
+			database->route = route;
+			continue;
+		}
+		od_config_table_node_t *user;
+		user = od_config_table_map_add(&database->users, route->user_name);
+		if (user == NULL)
+			goto error;
+		user->route = route;
+	}
+	return 0;
+error:
+	od_config_table_free(table);
+	return -1;
+}
+
+static inline od_config_route_t*
+od_config_table_forward_user(od_config_table_node_t *database,
+                             char *user_name, int user_name_len,
+                             od_hash_t user_hash)
+{
+	od_config_table_node_t *user;
+	user = od_config_table_map_get(&database->users, user_name,
+	                               user_name_len, user_hash);
+	if (user)
+		return user->route;
+	return database->route;
+}
+
+od_config_route_t*
+od_config_table_forward(od_config_table_t *table, char *db_name,
+                        char *user_name)
+{
+	int user_name_len = strlen(user_name);
+	od_hash_t user_hash = od_hash(user_name, user_name_len);
+
+	/* db.user, db.default */
+	int db_name_len = strlen(db_name);
+	od_config_table_node_t *database;
+	database = od_config_table_map_get(&table->databases, db_name, db_name_len,
+	                                   od_hash(db_name, db_name_len));
+	if (database) {
+		od_config_route_t *route;
+		route = od_config_table_forward_user(database, user_name,
+		                                     user_name_len, user_hash);
+		if (route)
+			return route;
+	}
+
+	/* default.user, default.default */
+	return od_config_table_forward_user(&table->database_default, user_name,
+	                                    user_name_len, user_hash);
+}
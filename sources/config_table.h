@@ -0,0 +1,51 @@
+#ifndef ODYSSEY_CONFIG_TABLE_H
+#define ODYSSEY_CONFIG_TABLE_H
+
+/*
+ * Odyssey.
+ *
+ * Scalable PostgreSQL connection pooler.
+*/
+
+typedef struct od_config_table_node od_config_table_node_t;
+typedef struct od_config_table_map  od_config_table_map_t;
+typedef struct od_config_table      od_config_table_t;
+
+struct od_config_table_map
+{
+	od_config_table_node_t **buckets;
+	int                      size;
+	int                      count;
+};
+
+/* database node keeps database default route and its
+ * users map, user node keeps database.user route */
+struct od_config_table_node
+{
+	char                   *name;
+	int                     name_len;
+	od_hash_t               hash;
+	struct od_config_route *route;
+	od_config_table_map_t   users;
+	od_config_table_node_t *next;
+};
+
+/* Compiled version of active config routes.
+ *
+ * database -> user two-level hash, default database
+ * routes are kept aside.
+*/
+struct od_config_table
+{
+	od_config_table_map_t  databases;
+	od_config_table_node_t database_default;
+};
+
+void od_config_table_init(od_config_table_t*);
+void od_config_table_free(od_config_table_t*);
+int  od_config_table_build(od_config_table_t*, od_list_t*);
+
+struct od_config_route*
+od_config_table_forward(od_config_table_t*, char*, char*);
+
+#endif /* ODYSSEY_CONFIG_TABLE_H */
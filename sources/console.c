@@ -13,6 +13,7 @@
 #include <ctype.h>
 #include <inttypes.h>
 #include <assert.h>
+#include <pthread.h>
 
 #include <machinarium.h>
 #include <kiwi.h>
@@ -185,10 +186,10 @@ od_console_show_stats(od_client_t *client, machine_channel_t *reply)
 	machine_channel_write(reply, msg);
 
 	int rc;
-	rc = od_route_pool_stat_database(&router->route_pool,
-	                                 od_console_show_stats_callback,
-	                                 cron->stat_time_us,
-	                                 reply);
+	rc = od_router_stat_database(router,
+	                         od_console_show_stats_callback,
+	                             cron->stat_time_us,
+	                         reply);
 	if (rc == -1)
 		return -1;
 
@@ -332,15 +333,15 @@ od_console_show_servers(od_client_t *client, machine_channel_t *reply)
 		return -1;
 	machine_channel_write(reply, msg);
 
-	od_route_pool_server_foreach(&router->route_pool,
-	                             OD_SERVER_IDLE,
-	                             od_console_show_servers_callback,
-	                             reply);
+	od_router_server_foreach(router,
+	                         OD_SERVER_IDLE,
+	                         od_console_show_servers_callback,
+	                         reply);
 
-	od_route_pool_server_foreach(&router->route_pool,
-	                             OD_SERVER_ACTIVE,
-	                             od_console_show_servers_callback,
-	                             reply);
+	od_router_server_foreach(router,
+	                         OD_SERVER_ACTIVE,
+	                         od_console_show_servers_callback,
+	                         reply);
 
 	msg = kiwi_be_write_complete("SHOW", 5);
 	if (msg == NULL)
@@ -483,20 +484,20 @@ od_console_show_clients(od_client_t *client, machine_channel_t *reply)
 		return -1;
 	machine_channel_write(reply, msg);
 
-	od_route_pool_client_foreach(&router->route_pool,
-	                             OD_CLIENT_ACTIVE,
-	                             od_console_show_clients_callback,
-	                             reply);
+	od_router_client_foreach(router,
+	                         OD_CLIENT_ACTIVE,
+	                         od_console_show_clients_callback,
+	                         reply);
 
-	od_route_pool_client_foreach(&router->route_pool,
-	                             OD_CLIENT_PENDING,
-	                             od_console_show_clients_callback,
-	                             reply);
+	od_router_client_foreach(router,
+	                         OD_CLIENT_PENDING,
+	                         od_console_show_clients_callback,
+	                         reply);
 
-	od_route_pool_client_foreach(&router->route_pool,
-	                             OD_CLIENT_QUEUE,
-	                             od_console_show_clients_callback,
-	                             reply);
+	od_router_client_foreach(router,
+	                         OD_CLIENT_QUEUE,
+	                         od_console_show_clients_callback,
+	                         reply);
 
 	msg = kiwi_be_write_complete("SHOW", 5);
 	if (msg == NULL)
@@ -552,15 +553,15 @@ od_console_show_lists(od_client_t *client, machine_channel_t *reply)
 	od_router_t *router = client->global->router;
 
 	int used_servers = 0;
-	od_route_pool_server_foreach(&router->route_pool,
-	                             OD_SERVER_IDLE,
-	                             od_console_show_lists_callback,
-	                             &used_servers);
+	od_router_server_foreach(router,
+	                         OD_SERVER_IDLE,
+	                         od_console_show_lists_callback,
+	                         &used_servers);
 
-	od_route_pool_server_foreach(&router->route_pool,
-	                             OD_SERVER_ACTIVE,
-	                             od_console_show_lists_callback,
-	                             &used_servers);
+	od_router_server_foreach(router,
+	                         OD_SERVER_ACTIVE,
+	                         od_console_show_lists_callback,
+	                         &used_servers);
 
 	machine_msg_t *msg;
 	msg = kiwi_be_write_row_descriptionf("sd", "list", "items");
@@ -578,7 +579,7 @@ od_console_show_lists(od_client_t *client, machine_channel_t *reply)
 	if (rc == -1)
 		return -1;
 	/* pools */
-	rc = od_console_show_lists_add(reply, "pools", router->route_pool.count);
+	rc = od_console_show_lists_add(reply, "pools", od_router_routes(router));
 	if (rc == -1)
 		return -1;
 	/* free_clients */
@@ -586,7 +587,8 @@ od_console_show_lists(od_client_t *client, machine_channel_t *reply)
 	if (rc == -1)
 		return -1;
 	/* used_clients */
-	rc = od_console_show_lists_add(reply, "used_clients", router->clients);
+	rc = od_console_show_lists_add(reply, "used_clients",
+	                               od_atomic_u32_of(&router->clients));
 	if (rc == -1)
 		return -1;
 	/* login_clients */
@@ -664,29 +666,35 @@ static inline int
 od_console_query_kill_client_callback(od_client_t *client, void *arg)
 {
 	od_id_t *id = arg;
-	return od_id_mgr_cmp(&client->id, id);
+	if (! od_id_mgr_cmp(&client->id, id))
+		return 0;
+	/* client could be freed as soon as the shard lock is
+	 * released, so notify it inside the callback */
+	client->ctl.op = OD_CLIENT_OP_KILL;
+	od_client_notify(client);
+	return 1;
 }
 
 static inline od_client_t*
 od_console_query_kill_client_match(od_router_t *router, od_id_t *id)
 {
 	od_client_t *match;
-	match = od_route_pool_client_foreach(&router->route_pool,
-	                                     OD_CLIENT_ACTIVE,
-	                                     od_console_query_kill_client_callback,
-	                                     id);
+	match = od_router_client_foreach(router,
+	                                 OD_CLIENT_ACTIVE,
+	                                 od_console_query_kill_client_callback,
+	                                 id);
 	if (match)
 		return match;
-	match = od_route_pool_client_foreach(&router->route_pool,
-	                                     OD_CLIENT_PENDING,
-	                                     od_console_query_kill_client_callback,
-	                                     id);
+	match = od_router_client_foreach(router,
+	                                 OD_CLIENT_PENDING,
+	                                 od_console_query_kill_client_callback,
+	                                 id);
 	if (match)
 		return match;
-	match = od_route_pool_client_foreach(&router->route_pool,
-	                                     OD_CLIENT_QUEUE,
-	                                     od_console_query_kill_client_callback,
-	                                     id);
+	match = od_router_client_foreach(router,
+	                                 OD_CLIENT_QUEUE,
+	                                 od_console_query_kill_client_callback,
+	                                 id);
 	return match;
 }
 
@@ -705,12 +713,7 @@ od_console_query_kill_client(od_router_t *router, machine_channel_t *reply,
 		return -1;
 	memcpy(id.id, token.value.string.pointer + 1, sizeof(id.id));
 
-	od_client_t *match;
-	match = od_console_query_kill_client_match(router, &id);
-	if (match) {
-		match->ctl.op = OD_CLIENT_OP_KILL;
-		od_client_notify(match);
-	}
+	od_console_query_kill_client_match(router, &id);
 
 	machine_msg_t *msg;
 	msg = kiwi_be_write_ready('I');
@@ -825,24 +828,30 @@ od_console(void *arg)
 	od_console_t *console = arg;
 	for (;;)
 	{
-		machine_msg_t *msg;
-		msg = machine_channel_read(console->channel, UINT32_MAX);
-		if (msg == NULL)
-			break;
-		od_msg_t msg_type;
-		msg_type = machine_msg_get_type(msg);
-		switch (msg_type) {
-		case OD_MCONSOLE_REQUEST:
-		{
-			od_msg_console_t *msg_console;
-			msg_console = machine_msg_get_data(msg);
-			od_console_query(console, msg_console);
-			machine_channel_write(msg_console->on_complete, msg);
-			break;
-		}
-		default:
-			assert(0);
+		machine_msg_t *msgs[OD_CHANNEL_BATCH];
+		int count;
+		count = machine_channel_read_batch(console->channel, msgs,
+		                                   OD_CHANNEL_BATCH, UINT32_MAX);
+		if (count == -1)
 			break;
+		int i;
+		for (i = 0; i < count; i++) {
+			machine_msg_t *msg = msgs[i];
+			od_msg_t msg_type;
+			msg_type = machine_msg_get_type(msg);
+			switch (msg_type) {
+			case OD_MCONSOLE_REQUEST:
+			{
+				od_msg_console_t *msg_console;
+				msg_console = machine_msg_get_data(msg);
+				od_console_query(console, msg_console);
+				machine_channel_write(msg_console->on_complete, msg);
+				break;
+			}
+			default:
+				assert(0);
+				break;
+			}
 		}
 	}
 }
@@ -859,7 +868,7 @@ od_console_start(od_console_t *console)
 {
 	od_instance_t *instance = console->global->instance;
 
-	console->channel = machine_channel_create(instance->is_shared);
+	console->channel = machine_channel_create(od_instance_channel_type(instance));
 	if (console->channel == NULL) {
 		od_error(&instance->logger, "console", NULL, NULL,
 		         "failed to create channel");
@@ -898,7 +907,7 @@ od_console_do(od_client_t *client, machine_channel_t *channel,
 
 	/* create response channel */
 	machine_channel_t *on_complete;
-	on_complete = machine_channel_create(instance->is_shared);
+	on_complete = machine_channel_create(od_instance_channel_type(instance));
 	if (on_complete == NULL) {
 		machine_msg_free(msg);
 		return -1;
@@ -13,6 +13,7 @@
 #include <ctype.h>
 #include <inttypes.h>
 #include <assert.h>
+#include <pthread.h>
 
 #include <machinarium.h>
 #include <kiwi.h>
@@ -54,14 +55,65 @@ od_cron_stat_cb(od_route_t *route, od_stat_t *current, od_stat_t *avg,
 	       avg->recv_client,
 	       avg->recv_server);
 
+	if (route->tls) {
+		uint64_t handshakes;
+		uint64_t reused;
+		machine_tls_stat(route->tls, &handshakes, &reused);
+		od_log(&instance->logger, "stats", NULL, NULL,
+		       "[%.*s.%.*s%s] tls: %" PRIu64 " handshakes, "
+		       "%" PRIu64 " resumed (%" PRIu64 "%%)",
+		       route->id.database_len - 1,
+		       route->id.database,
+		       route->id.user_len - 1,
+		       route->id.user,
+		       route->config->obsolete ? " obsolete" : "",
+		       handshakes,
+		       reused,
+		       handshakes ? reused * 100 / handshakes : 0);
+	}
+
 	return 0;
 }
 
+static inline void
+od_cron_stat_tls(od_cron_t *cron)
+{
+	od_instance_t *instance = cron->global->instance;
+	od_system_t *system = cron->global->system;
+
+	od_list_t *i;
+	od_list_foreach(&system->servers, i) {
+		od_system_server_t *server;
+		server = od_container_of(i, od_system_server_t, link);
+		/* reuseport listeners of the same address share tls */
+		if (server->tls == NULL || server->worker_id > 0)
+			continue;
+		char addr_name[PATH_MAX];
+		if (server->addr)
+			od_getaddrname(server->addr, addr_name, sizeof(addr_name), 1, 1);
+		else
+			od_snprintf(addr_name, sizeof(addr_name), "%s/.s.PGSQL.%d",
+			            instance->config.unix_socket_dir,
+			            server->config->port);
+		uint64_t handshakes;
+		uint64_t reused;
+		machine_tls_stat(server->tls, &handshakes, &reused);
+		od_log(&instance->logger, "stats", NULL, NULL,
+		       "listen %s tls: %" PRIu64 " handshakes, "
+		       "%" PRIu64 " resumed (%" PRIu64 "%%)",
+		       addr_name,
+		       handshakes,
+		       reused,
+		       handshakes ? reused * 100 / handshakes : 0);
+	}
+}
+
 static inline void
 od_cron_stat(od_cron_t *cron, od_router_t *router)
 {
 	od_instance_t *instance = router->global->instance;
 	od_worker_pool_t *worker_pool = router->global->worker_pool;
+	od_worker_pool_t *handshake_pool = router->global->handshake_pool;
 
 	if (instance->config.log_stats)
 	{
@@ -72,24 +124,73 @@ od_cron_stat(od_cron_t *cron, od_router_t *router)
 		uint64_t msg_cache_count = 0;
 		uint64_t msg_cache_gc_count = 0;
 		uint64_t msg_cache_size = 0;
+		uint64_t msg_cache_hit[MACHINE_MSG_CACHE_CLASSES];
+		uint64_t msg_cache_miss[MACHINE_MSG_CACHE_CLASSES];
+		uint64_t wakeup_count = 0;
+		uint64_t wakeup_coalesced_count = 0;
 		machine_stat(&count_coroutine,
 		             &count_coroutine_cache,
 		             &msg_allocated,
 		             &msg_cache_count,
 		             &msg_cache_gc_count,
-		             &msg_cache_size);
+		             &msg_cache_size,
+		             msg_cache_hit,
+		             msg_cache_miss,
+		             &wakeup_count,
+		             &wakeup_coalesced_count);
+		uint64_t stack_reserved = 0;
+		uint64_t stack_used_avg = 0;
+		uint64_t stack_used_p99 = 0;
+		uint64_t stack_used_max = 0;
+		uint64_t stack_used_count = 0;
+		machine_stack_stat(&stack_reserved, &stack_used_avg, &stack_used_p99,
+		                   &stack_used_max, &stack_used_count);
+		uint64_t msg_hit = 0;
+		uint64_t msg_miss = 0;
+		int i;
+		for (i = 0; i < MACHINE_MSG_CACHE_CLASSES; i++) {
+			msg_hit  += msg_cache_hit[i];
+			msg_miss += msg_cache_miss[i];
+		}
 		od_log(&instance->logger, "stats", NULL, NULL,
-		       "system worker: msg (%" PRIu64 " allocated, %" PRIu64 " cached, %" PRIu64 " freed, %" PRIu64 " cache_size), "
-		       "coroutines (%" PRIu64 " active, %"PRIu64 " cached)",
+		       "system worker: msg (%" PRIu64 " allocated, %" PRIu64 " cached, %" PRIu64 " freed, %" PRIu64 " cache_size, %" PRIu64 " hit, %" PRIu64 " miss), "
+		       "coroutines (%" PRIu64 " active, %"PRIu64 " cached), "
+		       "stacks (%" PRIu64 " KB reserved, %" PRIu64 " sampled, %" PRIu64 " avg, %" PRIu64 " p99, %" PRIu64 " max used), "
+		       "wakeups (%" PRIu64 " sent, %" PRIu64 " coalesced)",
 		       msg_allocated,
 		       msg_cache_count,
 		       msg_cache_gc_count,
 		       msg_cache_size,
+		       msg_hit,
+		       msg_miss,
 		       count_coroutine,
-		       count_coroutine_cache);
+		       count_coroutine_cache,
+		       stack_reserved / 1024,
+		       stack_used_count,
+		       stack_used_avg,
+		       stack_used_p99,
+		       stack_used_max,
+		       wakeup_count,
+		       wakeup_coalesced_count);
+
+		/* resolver stats */
+		uint64_t dns_hit = 0;
+		uint64_t dns_miss = 0;
+		uint64_t dns_refresh = 0;
+		uint64_t dns_resolve = 0;
+		uint64_t dns_resolve_time = 0;
+		machine_dns_stat(&dns_hit, &dns_miss, &dns_refresh, &dns_resolve,
+		                 &dns_resolve_time);
+		od_log(&instance->logger, "stats", NULL, NULL,
+		       "dns: %" PRIu64 " hit, %" PRIu64 " miss, %" PRIu64 " refreshed, "
+		       "%" PRIu64 " resolved (%" PRIu64 " usec avg)",
+		       dns_hit,
+		       dns_miss,
+		       dns_refresh,
+		       dns_resolve,
+		       dns_resolve ? dns_resolve_time / dns_resolve : 0);
 
 		/* request stats per worker */
-		int i;
 		for (i = 0; i < worker_pool->count; i++) {
 			od_worker_t *worker = &worker_pool->pool[i];
 			machine_msg_t *msg;
@@ -97,18 +198,30 @@ od_cron_stat(od_cron_t *cron, od_router_t *router)
 			machine_msg_set_type(msg, OD_MSTAT);
 			machine_channel_write(worker->task_channel, msg);
 		}
+		for (i = 0; i < handshake_pool->count; i++) {
+			od_worker_t *worker = &handshake_pool->pool[i];
+			machine_msg_t *msg;
+			msg = machine_msg_create(0);
+			machine_msg_set_type(msg, OD_MSTAT);
+			machine_channel_write(worker->task_channel, msg);
+		}
 
 		od_log(&instance->logger, "stats", NULL, NULL,
-		       "clients %d", router->clients);
-	}
+		       "clients %d", od_atomic_u32_of(&router->clients));
 
-	if (router->route_pool.count == 0)
-		return;
+		/* client distribution between workers */
+		uint32_t active, active_min, active_max;
+		od_worker_pool_stat(worker_pool, &active, &active_min, &active_max);
+		od_log(&instance->logger, "stats", NULL, NULL,
+		       "workers: %" PRIu32 " active clients (%" PRIu32 " min, %" PRIu32 " max per worker)",
+		       active, active_min, active_max);
+
+		/* tls session resumption per listener */
+		od_cron_stat_tls(cron);
+	}
 
 	/* update stats per route */
-	od_route_pool_stat(&router->route_pool, od_cron_stat_cb,
-	                   cron->stat_time_us,
-	                   router);
+	od_router_stat(router, od_cron_stat_cb, cron->stat_time_us, router);
 
 	/* update current stat time mark */
 	cron->stat_time_us = machine_time_us();
@@ -149,34 +262,15 @@ od_cron_expire_mark(od_server_t *server, void *arg)
 }
 
 static inline void
-od_cron_expire(od_cron_t *cron)
+od_cron_expire_shard(od_cron_t *cron, od_router_shard_t *shard)
 {
 	od_router_t *router = cron->global->router;
 	od_instance_t *instance = cron->global->instance;
 
-	/* Idle servers expire.
-	 *
-	 * It is important that mark logic stage must not yield
-	 * to maintain iterator consistency.
-	 *
-	 * mark:
-	 *
-	 *  - If a server idle time is equal to ttl, then move
-	 *    it to the EXPIRE queue.
-	 *
-	 *  - If a server config marked as obsolete and route has
-	 *    no remaining clients, then move it to the EXPIRE queue.
-	 *
-	 *  - Add plus one idle second on each traversal.
-	 *
-	 * sweep:
-	 *
-	 *  - Foreach servers in EXPIRE queue, send Terminate
-	 *    and close the connection.
-	*/
+	od_router_shard_lock(shard);
 
 	/* mark */
-	od_route_pool_server_foreach(&router->route_pool, OD_SERVER_IDLE,
+	od_route_pool_server_foreach(&shard->route_pool, OD_SERVER_IDLE,
 	                             od_cron_expire_mark,
 	                             router);
 
@@ -184,7 +278,7 @@ od_cron_expire(od_cron_t *cron)
 	for (;;)
 	{
 		od_server_t *server;
-		server = od_route_pool_next(&router->route_pool, OD_SERVER_EXPIRE);
+		server = od_route_pool_next(&shard->route_pool, OD_SERVER_EXPIRE);
 		if (server == NULL)
 			break;
 		od_debug(&instance->logger, "expire", NULL, server,
@@ -196,15 +290,57 @@ od_cron_expire(od_cron_t *cron)
 		server->route = NULL;
 		od_server_pool_set(&route->server_pool, server, OD_SERVER_UNDEF);
 
+		/* server is unlinked, close it without holding
+		 * the shard lock */
+		od_router_shard_unlock(shard);
+
 		if (instance->is_shared)
 			machine_io_attach(server->io);
 
 		od_backend_close_connection(server);
 		od_backend_close(server);
+
+		od_router_shard_lock(shard);
 	}
 
 	/* cleanup unused dynamic routes */
-	od_route_pool_gc(&router->route_pool);
+	od_router_lock(router);
+	od_route_pool_gc(&shard->route_pool);
+	od_router_unlock(router);
+
+	od_router_shard_unlock(shard);
+}
+
+static inline void
+od_cron_expire(od_cron_t *cron)
+{
+	od_router_t *router = cron->global->router;
+
+	/* Idle servers expire.
+	 *
+	 * It is important that mark logic stage must not yield
+	 * to maintain iterator consistency.
+	 *
+	 * mark:
+	 *
+	 *  - If a server idle time is equal to ttl, then move
+	 *    it to the EXPIRE queue.
+	 *
+	 *  - If a server config marked as obsolete and route has
+	 *    no remaining clients, then move it to the EXPIRE queue.
+	 *
+	 *  - Add plus one idle second on each traversal.
+	 *
+	 * sweep:
+	 *
+	 *  - Foreach servers in EXPIRE queue, send Terminate
+	 *    and close the connection.
+	 *
+	 * Each router shard is processed separately.
+	*/
+	int i;
+	for (i = 0; i < router->shards_count; i++)
+		od_cron_expire_shard(cron, &router->shards[i]);
 }
 
 static void
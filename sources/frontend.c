@@ -13,6 +13,7 @@
 #include <ctype.h>
 #include <inttypes.h>
 #include <assert.h>
+#include <pthread.h>
 
 #include <machinarium.h>
 #include <kiwi.h>
@@ -536,16 +537,37 @@ od_frontend_remote_client(od_client_t *client)
 }
 
 static inline od_frontend_rc_t
-od_frontend_remote_server(od_client_t *client)
+od_frontend_remote_server(od_client_t *client, machine_pollgroup_t *poll)
 {
 	od_instance_t *instance = client->global->instance;
 	od_route_t *route = client->route;
 	od_server_t *server = client->server;
 
+	int rc;
+
+	/* forward packet continuation directly to the client, one part
+	 * per call so client events are handled in between */
+	if (od_packet_is_continuation(&server->packet_reader)) {
+		rc = od_packet_splice(&server->packet_reader, client->io, server->io,
+		                      OD_PACKET_SPLICE_TIMEOUT);
+		if (rc == -1) {
+			od_error(&instance->logger, "main", client, server,
+			         "failed to forward packet continuation: %s",
+			         machine_error(client->io));
+			if (! machine_connected(server->io))
+				return OD_FE_ESERVER_READ;
+			return OD_FE_ECLIENT_WRITE;
+		}
+		od_stat_recv_server(&route->stats, rc);
+		rc = od_flush(client->io, instance->config.packet_write_queue, UINT32_MAX);
+		if (rc == -1)
+			return OD_FE_ECLIENT_WRITE;
+		return OD_FE_OK;
+	}
+
 	/* read incoming packet in chunks */
 	machine_msg_t *msg;
 	int next_chunk;
-	int rc;
 	rc = od_packet_read(&server->packet_reader, server->io, &msg);
 	if (rc == -1)
 		return OD_FE_ESERVER_READ;
@@ -648,6 +670,7 @@ od_frontend_remote_server(od_client_t *client)
 					return OD_FE_ESERVER_WRITE;
 				}
 				/* push server connection back to route pool */
+				machine_pollgroup_del(poll, server->io);
 				od_router_detach(client);
 				server = NULL;
 			}
@@ -680,20 +703,15 @@ od_frontend_ctl(od_client_t *client)
 }
 
 static od_frontend_rc_t
-od_frontend_remote(od_client_t *client)
+od_frontend_remote_poll(od_client_t *client, machine_pollgroup_t *poll)
 {
 	machine_io_t *io_ready[3];
-	machine_io_t *io_set[3];
-	int           io_count = 2;
 	int           io_pos;
-	io_set[0] = client->io_notify;
-	io_set[1] = client->io;
-	io_set[2] = NULL;
 
 	for (;;)
 	{
 		int ready;
-		ready = machine_read_poll(io_set, io_ready, io_count, UINT32_MAX);
+		ready = machine_pollgroup_wait(poll, io_ready, 3, UINT32_MAX);
 
 		for (io_pos = 0; io_pos < ready; io_pos++)
 		{
@@ -710,18 +728,18 @@ od_frontend_remote(od_client_t *client)
 				if (fe_rc != OD_FE_OK)
 					return fe_rc;
 				assert(client->server != NULL);
-				io_count  = 3;
-				io_set[2] = client->server->io;
+				/* server io stays in the group until it is detached */
+				int rc;
+				rc = machine_pollgroup_add(poll, client->server->io);
+				if (rc == -1)
+					return OD_FE_ESERVER_READ;
 				continue;
 			}
-			fe_rc = od_frontend_remote_server(client);
+			fe_rc = od_frontend_remote_server(client, poll);
 			if (fe_rc != OD_FE_OK)
 				return fe_rc;
-			if (client->server == NULL) {
-				io_count  = 2;
-				io_set[2] = NULL;
+			if (client->server == NULL)
 				break;
-			}
 		}
 	}
 
@@ -730,6 +748,30 @@ od_frontend_remote(od_client_t *client)
 	return OD_FE_UNDEF;
 }
 
+static od_frontend_rc_t
+od_frontend_remote(od_client_t *client)
+{
+	machine_pollgroup_t *poll;
+	poll = machine_pollgroup_create();
+	if (poll == NULL)
+		return OD_FE_ECLIENT_READ;
+	int rc;
+	rc = machine_pollgroup_add(poll, client->io_notify);
+	if (rc == -1) {
+		machine_pollgroup_free(poll);
+		return OD_FE_ECLIENT_READ;
+	}
+	rc = machine_pollgroup_add(poll, client->io);
+	if (rc == -1) {
+		machine_pollgroup_free(poll);
+		return OD_FE_ECLIENT_READ;
+	}
+	od_frontend_rc_t fe_rc;
+	fe_rc = od_frontend_remote_poll(client, poll);
+	machine_pollgroup_free(poll);
+	return fe_rc;
+}
+
 static od_frontend_rc_t
 od_frontend_local(od_client_t *client)
 {
@@ -957,27 +999,45 @@ od_frontend(void *arg)
 		od_error(&instance->logger, "startup", client, NULL,
 		         "failed to transfer client io");
 		machine_close(client->io);
-		machine_close(client->io_notify);
 		od_client_free(client);
 		return;
 	}
-	rc = machine_io_attach(client->io_notify);
+
+	/* create client notify io in worker, so it is never transferred */
+	client->io_notify = machine_io_create();
+	if (client->io_notify == NULL) {
+		od_error(&instance->logger, "startup", client, NULL,
+		         "failed to allocate client io notify object");
+		od_frontend_close(client);
+		return;
+	}
+	rc = machine_eventfd(client->io_notify);
 	if (rc == -1) {
 		od_error(&instance->logger, "startup", client, NULL,
-		         "failed to transfer client notify io");
-		machine_close(client->io);
-		machine_close(client->io_notify);
-		od_client_free(client);
+		         "failed to get eventfd for client: %s",
+		         machine_error(client->io_notify));
+		machine_io_free(client->io_notify);
+		client->io_notify = NULL;
+		od_frontend_close(client);
 		return;
 	}
-
-	/* handle startup */
-	rc = od_frontend_startup(client);
+	rc = machine_io_attach(client->io_notify);
 	if (rc == -1) {
+		od_error(&instance->logger, "startup", client, NULL,
+		         "failed to attach client notify io");
 		od_frontend_close(client);
 		return;
 	}
 
+	/* handle startup, unless it is done by handshake worker */
+	if (! client->is_startup_done) {
+		rc = od_frontend_startup(client);
+		if (rc == -1) {
+			od_frontend_close(client);
+			return;
+		}
+	}
+
 	/* handle cancel request */
 	if (client->startup.is_cancel) {
 		od_log(&instance->logger, "startup", client, NULL,
@@ -1077,3 +1137,57 @@ od_frontend(void *arg)
 	/* close frontend connection */
 	od_frontend_close(client);
 }
+
+void
+od_frontend_handshake(void *arg)
+{
+	od_client_t *client = arg;
+	od_instance_t *instance = client->global->instance;
+
+	/* handle startup and tls negotiation on the handshake
+	 * worker, so crypto does not delay clients of the worker */
+	int rc;
+	rc = machine_io_attach(client->io);
+	if (rc == -1) {
+		od_error(&instance->logger, "startup", client, NULL,
+		         "failed to transfer client io");
+		od_frontend_close(client);
+		return;
+	}
+	rc = od_frontend_startup(client);
+	if (rc == -1) {
+		od_frontend_close(client);
+		return;
+	}
+	client->is_startup_done = 1;
+
+	/* pass established connection to the worker pool, pending
+	 * writes are not transferred along with io */
+	rc = machine_flush(client->io, UINT32_MAX);
+	if (rc == -1) {
+		od_frontend_close(client);
+		return;
+	}
+	rc = machine_io_detach(client->io);
+	if (rc == -1) {
+		od_error(&instance->logger, "startup", client, NULL,
+		         "failed to detach client io");
+		od_frontend_close(client);
+		return;
+	}
+	machine_msg_t *msg;
+	msg = machine_msg_create(sizeof(od_client_t*));
+	if (msg == NULL) {
+		od_frontend_close(client);
+		return;
+	}
+	machine_msg_set_type(msg, OD_MCLIENT_NEW);
+	memcpy(machine_msg_get_data(msg), &client, sizeof(od_client_t*));
+
+	/* client leaves handshake worker */
+	od_atomic_u32_dec(client->worker_load);
+	client->worker_load = NULL;
+
+	od_worker_pool_t *worker_pool = client->global->worker_pool;
+	od_worker_pool_feed(worker_pool, msg);
+}
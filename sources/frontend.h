@@ -33,5 +33,6 @@ od_frontend_errorf(od_client_t *client, char *code, char *fmt, ...)
 
 int  od_frontend_error(od_client_t*, char*, char*, ...);
 void od_frontend(void*);
+void od_frontend_handshake(void*);
 
 #endif /* ODYSSEY_FRONTEND_H */
@@ -17,6 +17,7 @@ struct od_global
 	void *console;
 	void *cron;
 	void *worker_pool;
+	void *handshake_pool;
 };
 
 #endif /* ODYSSEY_GLOBAL_H */
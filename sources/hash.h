@@ -0,0 +1,31 @@
+#ifndef ODYSSEY_HASH_H
+#define ODYSSEY_HASH_H
+
+/*
+ * Odyssey.
+ *
+ * Scalable PostgreSQL connection pooler.
+*/
+
+typedef uint32_t od_hash_t;
+
+/* FNV-1a */
+static inline od_hash_t
+od_hash_of(od_hash_t hash, void *data, int size)
+{
+	unsigned char *pos = data;
+	unsigned char *end = pos + size;
+	while (pos < end) {
+		hash ^= *pos++;
+		hash *= 16777619U;
+	}
+	return hash;
+}
+
+static inline od_hash_t
+od_hash(void *data, int size)
+{
+	return od_hash_of(2166136261U, data, size);
+}
+
+#endif /* ODYSSEY_HASH_H */
@@ -13,6 +13,7 @@
 #include <ctype.h>
 #include <inttypes.h>
 #include <assert.h>
+#include <pthread.h>
 
 #include <signal.h>
 #include <errno.h>
@@ -94,6 +95,14 @@ od_instance_main(od_instance_t *instance, int argc, char **argv)
 	if (rc == -1)
 		return -1;
 
+	/* compile routes table */
+	rc = od_config_compile(&instance->config);
+	if (rc == -1) {
+		od_error(&instance->logger, "init", NULL, NULL,
+		         "failed to compile routes table");
+		return -1;
+	}
+
 	/* configure logger */
 	od_logger_set_format(&instance->logger, instance->config.log_format);
 	od_logger_set_debug(&instance->logger, instance->config.log_debug);
@@ -150,9 +159,14 @@ od_instance_main(od_instance_t *instance, int argc, char **argv)
 
 	/* initialize machinarium */
 	machinarium_set_stack_size(instance->config.coroutine_stack_size);
+	machinarium_set_stack_hugepages(instance->config.coroutine_stack_hugepages);
+	machinarium_set_stack_guard(instance->config.coroutine_stack_guard);
 	machinarium_set_pool_size(instance->config.resolvers);
+	machinarium_set_dns_ttl(instance->config.dns_ttl * 1000);
+	machinarium_set_dns_negative_ttl(instance->config.dns_negative_ttl * 1000);
 	machinarium_set_coroutine_cache_size(instance->config.cache_coroutine);
 	machinarium_set_msg_cache_gc_size(instance->config.cache_msg_gc_size);
+	machinarium_set_poll(instance->config.poll_backend);
 	rc = machinarium_init();
 	if (rc == -1) {
 		od_error(&instance->logger, "init", NULL, NULL,
@@ -167,8 +181,10 @@ od_instance_main(od_instance_t *instance, int argc, char **argv)
 	/* seed id manager */
 	od_id_mgr_seed(&instance->id_mgr);
 
-	/* is multi-worker deploy */
-	instance->is_shared = instance->config.workers > 1;
+	/* is multi-worker deploy, handshake workers pass clients
+	 * between threads as well */
+	instance->is_shared = instance->config.workers > 1 ||
+	                      instance->config.tls_workers > 0;
 
 	/* prepare global services */
 	od_system_t system;
@@ -178,6 +194,7 @@ od_instance_main(od_instance_t *instance, int argc, char **argv)
 	od_console_t console;
 	od_cron_t cron;
 	od_worker_pool_t worker_pool;
+	od_worker_pool_t handshake_pool;
 
 	od_global_t *global;
 	global = &system.global;
@@ -187,11 +204,13 @@ od_instance_main(od_instance_t *instance, int argc, char **argv)
 	global->console     = &console;
 	global->cron        = &cron;
 	global->worker_pool = &worker_pool;
+	global->handshake_pool = &handshake_pool;
 
 	od_router_init(&router, global);
 	od_console_init(&console, global);
 	od_cron_init(&cron, global);
 	od_worker_pool_init(&worker_pool);
+	od_worker_pool_init(&handshake_pool);
 
 	/* start system machine thread */
 	rc = od_system_start(&system);
@@ -23,4 +23,16 @@ void od_instance_init(od_instance_t*);
 void od_instance_free(od_instance_t*);
 int  od_instance_main(od_instance_t*, int, char**);
 
+/* max number of task messages processed per wakeup */
+#define OD_CHANNEL_BATCH 64
+
+static inline int
+od_instance_channel_type(od_instance_t *instance)
+{
+	/* task channels are read by a single coroutine */
+	if (instance->is_shared)
+		return MACHINE_CHANNEL_MPSC;
+	return MACHINE_CHANNEL_FAST;
+}
+
 #endif /* ODYSSEY_INSTANCE_H */
@@ -11,6 +11,7 @@ typedef enum
 {
 	OD_MSTAT,
 	OD_MCLIENT_NEW,
+	OD_MSERVER_LISTEN,
 	OD_MROUTER_ROUTE,
 	OD_MROUTER_UNROUTE,
 	OD_MROUTER_ATTACH,
@@ -18,7 +19,6 @@ typedef enum
 	OD_MROUTER_DETACH_AND_UNROUTE,
 	OD_MROUTER_CLOSE,
 	OD_MROUTER_CLOSE_AND_UNROUTE,
-	OD_MROUTER_CANCEL,
 	OD_MCONSOLE_REQUEST
 } od_msg_t;
 
@@ -10,6 +10,7 @@
 #include "sources/macro.h"
 #include "sources/version.h"
 #include "sources/atomic.h"
+#include "sources/hash.h"
 #include "sources/util.h"
 #include "sources/error.h"
 #include "sources/list.h"
@@ -18,6 +19,7 @@
 #include "sources/id.h"
 #include "sources/logger.h"
 #include "sources/parser.h"
+#include "sources/config_table.h"
 #include "sources/config.h"
 #include "sources/config_reader.h"
 #include "sources/msg.h"
@@ -34,6 +36,7 @@
 #include "sources/route_pool.h"
 #include "sources/instance.h"
 #include "sources/router_cancel.h"
+#include "sources/cancel.h"
 #include "sources/router.h"
 #include "sources/cron.h"
 #include "sources/system.h"
@@ -42,7 +45,6 @@
 #include "sources/tls.h"
 #include "sources/auth_query.h"
 #include "sources/auth.h"
-#include "sources/cancel.h"
 #include "sources/reset.h"
 #include "sources/deploy.h"
 #include "sources/backend.h"
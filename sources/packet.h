@@ -9,6 +9,11 @@
 
 typedef struct od_packet od_packet_t;
 
+/* largest part of a packet spliced in one call and the time
+ * it may take without progress */
+#define OD_PACKET_SPLICE_CHUNK   (256 * 1024)
+#define OD_PACKET_SPLICE_TIMEOUT 30000
+
 struct od_packet
 {
 	int      has_header;
@@ -46,6 +51,12 @@ od_packet_is_complete(od_packet_t *packet)
 	return packet->size == 0;
 }
 
+static inline int
+od_packet_is_continuation(od_packet_t *packet)
+{
+	return packet->has_header;
+}
+
 static inline int
 od_packet_read(od_packet_t *packet, machine_io_t *io, machine_msg_t **msg)
 {
@@ -88,4 +99,24 @@ od_packet_read(od_packet_t *packet, machine_io_t *io, machine_msg_t **msg)
 	return next_chunk;
 }
 
+static inline int
+od_packet_splice(od_packet_t *packet, machine_io_t *dst, machine_io_t *src,
+                 uint32_t time_ms)
+{
+	/* forward next part of the packet without reading it,
+	   the caller gets back to its event loop between parts */
+	assert(packet->has_header);
+	uint32_t to_read = packet->size - packet->read;
+	if (to_read > OD_PACKET_SPLICE_CHUNK)
+		to_read = OD_PACKET_SPLICE_CHUNK;
+	int rc;
+	rc = machine_splice(dst, src, to_read, time_ms);
+	if (rc == -1)
+		return -1;
+	packet->read += to_read;
+	if (packet->read == packet->size)
+		od_packet_reset(packet);
+	return to_read;
+}
+
 #endif /* ODYSSEY_PACKET_H */
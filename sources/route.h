@@ -19,6 +19,9 @@ struct od_route
 	od_server_pool_t   server_pool;
 	od_client_pool_t   client_pool;
 	kiwi_params_lock_t params;
+	machine_tls_t     *tls;
+	od_hash_t          hash;
+	od_list_t          link_hash;
 	od_list_t          link;
 };
 
@@ -33,6 +36,9 @@ od_route_init(od_route_t *route)
 	od_stat_init(&route->stats);
 	od_stat_init(&route->stats_prev);
 	kiwi_params_lock_init(&route->params);
+	route->tls  = NULL;
+	route->hash = 0;
+	od_list_init(&route->link_hash);
 	od_list_init(&route->link);
 }
 
@@ -52,6 +58,8 @@ od_route_free(od_route_t *route)
 	od_route_id_free(&route->id);
 	od_server_pool_free(&route->server_pool);
 	kiwi_params_lock_free(&route->params);
+	if (route->tls)
+		machine_tls_free(route->tls);
 	free(route);
 }
 
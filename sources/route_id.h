@@ -66,4 +66,13 @@ od_route_id_compare(od_route_id_t *a, od_route_id_t *b)
 	return 0;
 }
 
+static inline od_hash_t
+od_route_id_hash(od_route_id_t *id)
+{
+	od_hash_t hash;
+	hash = od_hash(id->database, id->database_len);
+	hash = od_hash_of(hash, id->user, id->user_len);
+	return hash;
+}
+
 #endif /* ODYSSEY_ROUTE_ID_H */
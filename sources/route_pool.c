@@ -13,6 +13,7 @@
 #include <ctype.h>
 #include <inttypes.h>
 #include <assert.h>
+#include <pthread.h>
 
 #include <machinarium.h>
 #include <kiwi.h>
@@ -22,6 +23,8 @@ void
 od_route_pool_init(od_route_pool_t *pool)
 {
 	od_list_init(&pool->list);
+	pool->hash = NULL;
+	pool->hash_size = 0;
 	pool->count = 0;
 }
 
@@ -34,6 +37,43 @@ od_route_pool_free(od_route_pool_t *pool)
 		route = od_container_of(i, od_route_t, link);
 		od_route_free(route);
 	}
+	if (pool->hash)
+		free(pool->hash);
+}
+
+static inline od_hash_t
+od_route_pool_hash_of(od_route_id_t *id, od_config_route_t *config)
+{
+	od_hash_t hash;
+	hash = od_route_id_hash(id);
+	hash = od_hash_of(hash, &config, sizeof(config));
+	return hash;
+}
+
+static inline int
+od_route_pool_hash_resize(od_route_pool_t *pool, int size)
+{
+	od_list_t *hash;
+	hash = malloc(sizeof(od_list_t) * size);
+	if (hash == NULL)
+		return -1;
+	int j;
+	for (j = 0; j < size; j++)
+		od_list_init(&hash[j]);
+
+	/* rehash routes, size is always power of two */
+	od_list_t *i;
+	od_list_foreach(&pool->list, i) {
+		od_route_t *route;
+		route = od_container_of(i, od_route_t, link);
+		od_list_init(&route->link_hash);
+		od_list_append(&hash[route->hash & (size - 1)], &route->link_hash);
+	}
+	if (pool->hash)
+		free(pool->hash);
+	pool->hash = hash;
+	pool->hash_size = size;
+	return 0;
 }
 
 static inline void
@@ -52,6 +92,7 @@ od_route_pool_gc_route(od_route_pool_t *pool, od_route_t *route)
 	/* free route data */
 	assert(pool->count > 0);
 	pool->count--;
+	od_list_unlink(&route->link_hash);
 	od_list_unlink(&route->link);
 	od_route_free(route);
 }
@@ -71,16 +112,26 @@ od_route_t*
 od_route_pool_new(od_route_pool_t *pool, od_config_route_t *config,
                   od_route_id_t *id)
 {
+	/* keep hash table load factor below one */
+	int rc;
+	if (pool->count >= pool->hash_size) {
+		int size = pool->hash_size ? pool->hash_size * 2 : 64;
+		rc = od_route_pool_hash_resize(pool, size);
+		if (rc == -1)
+			return NULL;
+	}
 	od_route_t *route = od_route_allocate();
 	if (route == NULL)
 		return NULL;
-	int rc;
 	rc = od_route_id_copy(&route->id, id);
 	if (rc == -1) {
 		od_route_free(route);
 		return NULL;
 	}
 	route->config = config;
+	route->hash = od_route_pool_hash_of(id, config);
+	od_list_append(&pool->hash[route->hash & (pool->hash_size - 1)],
+	               &route->link_hash);
 	od_list_append(&pool->list, &route->link);
 	pool->count++;
 	return route;
@@ -91,10 +142,16 @@ od_route_pool_match(od_route_pool_t *pool,
                     od_route_id_t *key,
                     od_config_route_t *config)
 {
+	if (pool->hash == NULL)
+		return NULL;
+	od_hash_t hash;
+	hash = od_route_pool_hash_of(key, config);
 	od_list_t *i;
-	od_list_foreach(&pool->list, i) {
+	od_list_foreach(&pool->hash[hash & (pool->hash_size - 1)], i) {
 		od_route_t *route;
-		route = od_container_of(i, od_route_t, link);
+		route = od_container_of(i, od_route_t, link_hash);
+		if (route->hash != hash)
+			continue;
 		if (route->config == config && od_route_id_compare(&route->id, key))
 			return route;
 	}
@@ -169,81 +226,94 @@ od_route_pool_client_foreach(od_route_pool_t *pool, od_client_state_t state,
 }
 
 static inline void
-od_route_pool_stat_database_mark(od_route_pool_t *pool,
+od_route_pool_stat_database_mark(od_route_pool_t **pools,
+                                 int   pools_count,
                                  char *database,
                                  int   database_len,
                                  od_stat_t *current,
                                  od_stat_t *prev)
 {
-	od_list_t *i;
-	od_list_foreach(&pool->list, i)
-	{
-		od_route_t *route;
-		route = od_container_of(i, od_route_t, link);
-		if (route->stats_mark)
-			continue;
-		if (route->id.database_len != database_len)
-			continue;
-		if (memcmp(route->id.database, database, database_len) != 0)
-			continue;
+	int j;
+	for (j = 0; j < pools_count; j++) {
+		od_list_t *i;
+		od_list_foreach(&pools[j]->list, i)
+		{
+			od_route_t *route;
+			route = od_container_of(i, od_route_t, link);
+			if (route->stats_mark)
+				continue;
+			if (route->id.database_len != database_len)
+				continue;
+			if (memcmp(route->id.database, database, database_len) != 0)
+				continue;
 
-		od_stat_sum(current, &route->stats);
-		od_stat_sum(prev, &route->stats_prev);
+			od_stat_sum(current, &route->stats);
+			od_stat_sum(prev, &route->stats_prev);
 
-		route->stats_mark++;
+			route->stats_mark++;
+		}
 	}
 }
 
 static inline void
-od_route_pool_stat_unmark(od_route_pool_t *pool)
+od_route_pool_stat_unmark(od_route_pool_t **pools, int pools_count)
 {
-	od_route_t *route;
-	od_list_t *i;
-	od_list_foreach(&pool->list, i) {
-		route = od_container_of(i, od_route_t, link);
-		route->stats_mark = 0;
+	int j;
+	for (j = 0; j < pools_count; j++) {
+		od_route_t *route;
+		od_list_t *i;
+		od_list_foreach(&pools[j]->list, i) {
+			route = od_container_of(i, od_route_t, link);
+			route->stats_mark = 0;
+		}
 	}
 }
 
 int
-od_route_pool_stat_database(od_route_pool_t *pool,
+od_route_pool_stat_database(od_route_pool_t **pools,
+                            int pools_count,
                             od_route_pool_stat_database_cb_t callback,
                             uint64_t prev_time_us,
                             void *arg)
 {
-	od_route_t *route;
-	od_list_t *i;
-	od_list_foreach(&pool->list, i)
+	/* databases could be spread between several pools */
+	int j;
+	for (j = 0; j < pools_count; j++)
 	{
-		route = od_container_of(i, od_route_t, link);
-		if (route->stats_mark)
-			continue;
+		od_route_t *route;
+		od_list_t *i;
+		od_list_foreach(&pools[j]->list, i)
+		{
+			route = od_container_of(i, od_route_t, link);
+			if (route->stats_mark)
+				continue;
 
-		/* gather current and previous cron stats */
-		od_stat_t current;
-		od_stat_t prev;
-		od_stat_init(&current);
-		od_stat_init(&prev);
-		od_route_pool_stat_database_mark(pool,
-		                                 route->id.database,
-		                                 route->id.database_len,
-		                                 &current, &prev);
+			/* gather current and previous cron stats */
+			od_stat_t current;
+			od_stat_t prev;
+			od_stat_init(&current);
+			od_stat_init(&prev);
+			od_route_pool_stat_database_mark(pools, pools_count,
+			                                 route->id.database,
+			                                 route->id.database_len,
+			                                 &current, &prev);
 
-		/* calculate average */
-		od_stat_t avg;
-		od_stat_init(&avg);
-		od_stat_average(&avg, &current, &prev, prev_time_us);
+			/* calculate average */
+			od_stat_t avg;
+			od_stat_init(&avg);
+			od_stat_average(&avg, &current, &prev, prev_time_us);
 
-		int rc;
-		rc = callback(route->id.database, route->id.database_len - 1,
-		              &current, &avg, arg);
-		if (rc == -1) {
-			od_route_pool_stat_unmark(pool);
-			return -1;
+			int rc;
+			rc = callback(route->id.database, route->id.database_len - 1,
+			              &current, &avg, arg);
+			if (rc == -1) {
+				od_route_pool_stat_unmark(pools, pools_count);
+				return -1;
+			}
 		}
 	}
 
-	od_route_pool_stat_unmark(pool);
+	od_route_pool_stat_unmark(pools, pools_count);
 	return 0;
 }
 
@@ -24,8 +24,10 @@ typedef int (*od_route_pool_stat_database_cb_t)
 
 struct od_route_pool
 {
-	od_list_t list;
-	int count;
+	od_list_t  list;
+	od_list_t *hash;
+	int        hash_size;
+	int        count;
 };
 
 void od_route_pool_init(od_route_pool_t*);
@@ -52,7 +54,7 @@ od_client_t*
 od_route_pool_client_foreach(od_route_pool_t*, od_client_state_t,
                             od_client_pool_cb_t, void*);
 
-int od_route_pool_stat_database(od_route_pool_t *pool,
+int od_route_pool_stat_database(od_route_pool_t**, int,
                                 od_route_pool_stat_database_cb_t,
                                 uint64_t,
                                 void*);
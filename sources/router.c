@@ -13,6 +13,7 @@
 #include <ctype.h>
 #include <inttypes.h>
 #include <assert.h>
+#include <pthread.h>
 
 #include <machinarium.h>
 #include <kiwi.h>
@@ -22,55 +23,42 @@ typedef struct
 {
 	od_router_status_t  status;
 	od_client_t        *client;
+	od_config_route_t  *config;
+	od_route_id_t       id;
 	machine_channel_t  *response;
-	od_router_cancel_t *cancel;
 } od_msg_router_t;
 
+static inline od_router_shard_t*
+od_router_shard_of(od_client_t *client)
+{
+	od_router_t *router = client->global->router;
+	assert(client->router_shard >= 0);
+	return &router->shards[client->router_shard];
+}
+
 static od_route_t*
-od_forward(od_router_t *router, kiwi_be_startup_t *startup)
+od_forward(od_router_shard_t *shard, od_msg_router_t *msg_route)
 {
+	od_router_t *router = shard->router;
 	od_instance_t *instance = router->global->instance;
 
-	assert(startup->database != NULL);
-	assert(startup->user != NULL);
-
-	/* match latest version of route config */
-	od_config_route_t *config;
-	config = od_config_route_forward(&instance->config,
-	                                 kiwi_param_value(startup->database),
-	                                 kiwi_param_value(startup->user));
-	if (config == NULL)
-		return NULL;
-
-	od_route_id_t id = {
-		.database     = kiwi_param_value(startup->database),
-		.user         = kiwi_param_value(startup->user),
-		.database_len = startup->database->value_len,
-		.user_len     = startup->user->value_len
-	};
-
-	/* force settings required by route */
-	if (config->storage_db) {
-		id.database = config->storage_db;
-		id.database_len = strlen(config->storage_db) + 1;
-	}
-	if (config->storage_user) {
-		id.user = config->storage_user;
-		id.user_len = strlen(config->storage_user) + 1;
-	}
-
 	/* match or create dynamic route */
 	od_route_t *route;
-	route = od_route_pool_match(&router->route_pool, &id, config);
+	route = od_route_pool_match(&shard->route_pool, &msg_route->id,
+	                            msg_route->config);
 	if (route)
 		return route;
-	route = od_route_pool_new(&router->route_pool, config, &id);
+	route = od_route_pool_new(&shard->route_pool, msg_route->config,
+	                          &msg_route->id);
 	if (route == NULL) {
 		od_error(&instance->logger, "router", NULL, NULL,
 		         "failed to allocate route");
 		return NULL;
 	}
-	od_config_route_ref(config);
+
+	od_router_lock(router);
+	od_config_route_ref(msg_route->config);
+	od_router_unlock(router);
 	return route;
 }
 
@@ -89,14 +77,17 @@ od_router_attacher(void *arg)
 	od_instance_t *instance;
 	instance = client->global->instance;
 
-	od_router_t *router;
-	router = client->global->router;
+	od_router_shard_t *shard;
+	shard = od_router_shard_of(client);
 
 	od_route_t  *route;
 	route = client->route;
 
+	od_router_shard_lock(shard);
+
 	/* get server connection from route idle pool */
 	od_server_t *server;
+	int rc;
 	for (;;)
 	{
 		server = od_server_pool_next(&route->server_pool, OD_SERVER_IDLE);
@@ -131,10 +122,12 @@ od_router_attacher(void *arg)
 		uint32_t timeout = route->config->pool_timeout;
 		if (timeout == 0)
 			timeout = UINT32_MAX;
-		int rc;
+		od_router_shard_unlock(shard);
 		rc = machine_condition(timeout);
+		od_router_shard_lock(shard);
 		if (rc == -1) {
 			od_client_pool_set(&route->client_pool, client, OD_CLIENT_PENDING);
+			od_router_shard_unlock(shard);
 			od_error(&instance->logger, "router", client, NULL,
 			         "route '%s.%s' server pool wait timedout, closing",
 			         route->config->db_name,
@@ -154,13 +147,14 @@ od_router_attacher(void *arg)
 	/* create new server object */
 	server = od_server_allocate();
 	if (server == NULL) {
+		od_router_shard_unlock(shard);
 		msg_attach->status = OD_RERROR;
 		machine_channel_write(msg_attach->response, msg);
 		return;
 	}
 	od_id_mgr_generate(&instance->id_mgr, &server->id, "s");
 	od_packet_set_chunk(&server->packet_reader, instance->config.packet_read_size);
-	server->global = router->global;
+	server->global = client->global;
 	server->route = route;
 
 on_attach:
@@ -171,6 +165,11 @@ on_attach:
 	server->idle_time = 0;
 	/* assign client session key */
 	server->key_client = client->key;
+	rc = od_cancel_index_add(&shard->cancel_index, server);
+	if (rc == -1)
+		od_error(&instance->logger, "router", client, server,
+		         "failed to index cancel key");
+	od_router_shard_unlock(shard);
 	msg_attach->status = OD_ROK;
 	machine_channel_write(msg_attach->response, msg);
 }
@@ -197,268 +196,317 @@ od_router_wakeup(od_router_t *router, od_route_t *route)
 }
 
 static inline void
-od_router(void *arg)
+od_router_process(od_router_shard_t *shard, machine_msg_t *msg)
 {
-	od_router_t *router = arg;
+	od_router_t *router = shard->router;
 	od_instance_t *instance = router->global->instance;
 
-	for (;;)
+	od_msg_t msg_type;
+	msg_type = machine_msg_get_type(msg);
+	switch (msg_type) {
+	case OD_MROUTER_ROUTE:
 	{
-		machine_msg_t *msg;
-		msg = machine_channel_read(router->channel, UINT32_MAX);
-		if (msg == NULL)
-			break;
-
-		od_msg_t msg_type;
-		msg_type = machine_msg_get_type(msg);
-		switch (msg_type) {
-		case OD_MROUTER_ROUTE:
-		{
-			/* attach client to route */
-			od_msg_router_t *msg_route;
-			msg_route = machine_msg_get_data(msg);
-
-			/* ensure global client_max limit */
-			if (instance->config.client_max_set) {
-				if (router->clients >= instance->config.client_max) {
-					od_log(&instance->logger, "router", NULL, NULL,
-					       "router: global client_max limit reached (%d)",
-					       instance->config.client_max);
-					msg_route->status = OD_RERROR_LIMIT;
-					machine_channel_write(msg_route->response, msg);
-					break;
-				}
-			}
-
-			/* match route */
-			od_route_t *route;
-			route = od_forward(router, &msg_route->client->startup);
-			if (route == NULL) {
-				msg_route->status = OD_RERROR_NOT_FOUND;
+		/* attach client to route */
+		od_msg_router_t *msg_route;
+		msg_route = machine_msg_get_data(msg);
+
+		/* ensure global client_max limit */
+		if (instance->config.client_max_set) {
+			uint32_t clients = od_atomic_u32_of(&router->clients);
+			if ((int)clients >= instance->config.client_max) {
+				od_log(&instance->logger, "router", NULL, NULL,
+				       "router: global client_max limit reached (%d)",
+				       instance->config.client_max);
+				msg_route->status = OD_RERROR_LIMIT;
 				machine_channel_write(msg_route->response, msg);
 				break;
 			}
-
-			/* ensure route client_max limit */
-			if (route->config->client_max_set) {
-				int client_total;
-				client_total = od_client_pool_total(&route->client_pool);
-				if (client_total >= route->config->client_max) {
-					od_log(&instance->logger, "router", NULL, NULL,
-					       "route '%s.%s' client_max limit reached (%d)",
-					       route->config->db_name,
-					       route->config->user_name,
-					       route->config->client_max);
-					msg_route->status = OD_RERROR_LIMIT;
-					machine_channel_write(msg_route->response, msg);
-					break;
-				}
-			}
-
-			/* add client to route client pool */
-			od_client_pool_set(&route->client_pool, msg_route->client, OD_CLIENT_PENDING);
-			router->clients++;
-
-			msg_route->client->config = route->config;
-			msg_route->client->route = route;
-			msg_route->status = OD_ROK;
-			machine_channel_write(msg_route->response, msg);
-			break;
 		}
 
-		case OD_MROUTER_UNROUTE:
-		{
-			/* detach client from route */
-			od_msg_router_t *msg_unroute;
-			msg_unroute = machine_msg_get_data(msg);
-
-			od_client_t *client = msg_unroute->client;
-			od_route_t *route = client->route;
-			client->route = NULL;
-			assert(client->server == NULL);
-			od_client_pool_set(&route->client_pool, client, OD_CLIENT_UNDEF);
-
-			assert(router->clients > 0);
-			router->clients--;
-
-			msg_unroute->status = OD_ROK;
-			machine_channel_write(msg_unroute->response, msg);
+		/* match route */
+		od_route_t *route;
+		route = od_forward(shard, msg_route);
+		if (route == NULL) {
+			msg_route->status = OD_RERROR_NOT_FOUND;
+			machine_channel_write(msg_route->response, msg);
 			break;
 		}
 
-		case OD_MROUTER_ATTACH:
-		{
-			/* get client server from route server pool */
-			od_msg_router_t *msg_attach;
-			msg_attach = machine_msg_get_data(msg);
-
-			od_client_t *client;
-			client = msg_attach->client;
-
-			int64_t coroutine_id;
-			coroutine_id = machine_coroutine_create(od_router_attacher, msg);
-			if (coroutine_id == -1) {
-				msg_attach->status = OD_RERROR;
-				machine_channel_write(msg_attach->response, msg);
+		/* ensure route client_max limit */
+		if (route->config->client_max_set) {
+			int client_total;
+			client_total = od_client_pool_total(&route->client_pool);
+			if (client_total >= route->config->client_max) {
+				od_log(&instance->logger, "router", NULL, NULL,
+				       "route '%s.%s' client_max limit reached (%d)",
+				       route->config->db_name,
+				       route->config->user_name,
+				       route->config->client_max);
+				msg_route->status = OD_RERROR_LIMIT;
+				machine_channel_write(msg_route->response, msg);
 				break;
 			}
-			client->coroutine_attacher_id = coroutine_id;
-			break;
 		}
 
-		case OD_MROUTER_DETACH:
-		{
-			/* push client server back to route server pool */
-			od_msg_router_t *msg_detach;
-			msg_detach = machine_msg_get_data(msg);
+		/* add client to route client pool */
+		od_client_pool_set(&route->client_pool, msg_route->client, OD_CLIENT_PENDING);
+		od_atomic_u32_inc(&router->clients);
 
-			od_client_t *client = msg_detach->client;
-			od_route_t *route = client->route;
-			od_server_t *server = client->server;
+		msg_route->client->config = route->config;
+		msg_route->client->route = route;
+		msg_route->status = OD_ROK;
+		machine_channel_write(msg_route->response, msg);
+		break;
+	}
 
-			client->server = NULL;
-			server->client = NULL;
-			server->last_client_id = client->id;
-			od_server_pool_set(&route->server_pool, server, OD_SERVER_IDLE);
-			od_client_pool_set(&route->client_pool, client, OD_CLIENT_PENDING);
+	case OD_MROUTER_UNROUTE:
+	{
+		/* detach client from route */
+		od_msg_router_t *msg_unroute;
+		msg_unroute = machine_msg_get_data(msg);
+
+		od_client_t *client = msg_unroute->client;
+		od_route_t *route = client->route;
+		client->route = NULL;
+		assert(client->server == NULL);
+		od_client_pool_set(&route->client_pool, client, OD_CLIENT_UNDEF);
+
+		assert(od_atomic_u32_of(&router->clients) > 0);
+		od_atomic_u32_dec(&router->clients);
+
+		msg_unroute->status = OD_ROK;
+		machine_channel_write(msg_unroute->response, msg);
+		break;
+	}
 
-			/* wakeup attachers */
-			od_router_wakeup(router, route);
+	case OD_MROUTER_ATTACH:
+	{
+		/* get client server from route server pool */
+		od_msg_router_t *msg_attach;
+		msg_attach = machine_msg_get_data(msg);
 
-			msg_detach->status = OD_ROK;
-			machine_channel_write(msg_detach->response, msg);
+		od_client_t *client;
+		client = msg_attach->client;
+
+		int64_t coroutine_id;
+		coroutine_id = machine_coroutine_create(od_router_attacher, msg);
+		if (coroutine_id == -1) {
+			msg_attach->status = OD_RERROR;
+			machine_channel_write(msg_attach->response, msg);
 			break;
 		}
+		client->coroutine_attacher_id = coroutine_id;
+		break;
+	}
 
-		case OD_MROUTER_DETACH_AND_UNROUTE:
-		{
-			/* push client server back to route server pool,
-			 * unroute client */
-			od_msg_router_t *msg_detach;
-			msg_detach = machine_msg_get_data(msg);
-
-			od_client_t *client = msg_detach->client;
-			od_route_t *route = client->route;
-			od_server_t *server = client->server;
-
-			server->last_client_id = client->id;
-			server->client = NULL;
-			od_server_pool_set(&route->server_pool, server, OD_SERVER_IDLE);
+	case OD_MROUTER_DETACH:
+	{
+		/* push client server back to route server pool */
+		od_msg_router_t *msg_detach;
+		msg_detach = machine_msg_get_data(msg);
+
+		od_client_t *client = msg_detach->client;
+		od_route_t *route = client->route;
+		od_server_t *server = client->server;
+
+		od_cancel_index_remove(&shard->cancel_index, server);
+		client->server = NULL;
+		server->client = NULL;
+		server->last_client_id = client->id;
+		od_server_pool_set(&route->server_pool, server, OD_SERVER_IDLE);
+		od_client_pool_set(&route->client_pool, client, OD_CLIENT_PENDING);
+
+		/* wakeup attachers */
+		od_router_wakeup(router, route);
+
+		msg_detach->status = OD_ROK;
+		machine_channel_write(msg_detach->response, msg);
+		break;
+	}
 
-			client->server = NULL;
-			client->route = NULL;
-			od_client_pool_set(&route->client_pool, client, OD_CLIENT_UNDEF);
-			assert(router->clients > 0);
-			router->clients--;
+	case OD_MROUTER_DETACH_AND_UNROUTE:
+	{
+		/* push client server back to route server pool,
+		 * unroute client */
+		od_msg_router_t *msg_detach;
+		msg_detach = machine_msg_get_data(msg);
+
+		od_client_t *client = msg_detach->client;
+		od_route_t *route = client->route;
+		od_server_t *server = client->server;
+
+		od_cancel_index_remove(&shard->cancel_index, server);
+		server->last_client_id = client->id;
+		server->client = NULL;
+		od_server_pool_set(&route->server_pool, server, OD_SERVER_IDLE);
+
+		client->server = NULL;
+		client->route = NULL;
+		od_client_pool_set(&route->client_pool, client, OD_CLIENT_UNDEF);
+		assert(od_atomic_u32_of(&router->clients) > 0);
+		od_atomic_u32_dec(&router->clients);
+
+		/* wakeup attachers */
+		od_router_wakeup(router, route);
+
+		msg_detach->status = OD_ROK;
+		machine_channel_write(msg_detach->response, msg);
+		break;
+	}
 
-			/* wakeup attachers */
-			od_router_wakeup(router, route);
+	case OD_MROUTER_CLOSE:
+	{
+		/* detach closed server connection */
+		od_msg_router_t *msg_detach;
+		msg_detach = machine_msg_get_data(msg);
 
-			msg_detach->status = OD_ROK;
-			machine_channel_write(msg_detach->response, msg);
-			break;
-		}
+		od_client_t *client = msg_detach->client;
+		od_route_t *route = client->route;
+		od_server_t *server = client->server;
 
-		case OD_MROUTER_CLOSE:
-		{
-			/* detach closed server connection */
-			od_msg_router_t *msg_detach;
-			msg_detach = machine_msg_get_data(msg);
+		client->server = NULL;
+		od_client_pool_set(&route->client_pool, client, OD_CLIENT_PENDING);
 
-			od_client_t *client = msg_detach->client;
-			od_route_t *route = client->route;
-			od_server_t *server = client->server;
+		od_cancel_index_remove(&shard->cancel_index, server);
+		od_server_pool_set(&route->server_pool, server, OD_SERVER_UNDEF);
+		server->last_client_id = client->id;
+		server->client = NULL;
+		server->route  = NULL;
 
-			client->server = NULL;
-			od_client_pool_set(&route->client_pool, client, OD_CLIENT_PENDING);
+		assert(server->io == NULL);
+		od_backend_close(server);
 
-			od_server_pool_set(&route->server_pool, server, OD_SERVER_UNDEF);
-			server->last_client_id = client->id;
-			server->client = NULL;
-			server->route  = NULL;
+		msg_detach->status = OD_ROK;
+		machine_channel_write(msg_detach->response, msg);
+		break;
+	}
 
-			assert(server->io == NULL);
-			od_backend_close(server);
+	case OD_MROUTER_CLOSE_AND_UNROUTE:
+	{
+		/* detach closed server connection and unroute client */
+		od_msg_router_t *msg_close;
+		msg_close = machine_msg_get_data(msg);
+
+		od_client_t *client = msg_close->client;
+		od_route_t *route = client->route;
+		od_server_t *server = client->server;
+		od_cancel_index_remove(&shard->cancel_index, server);
+		od_server_pool_set(&route->server_pool, server, OD_SERVER_UNDEF);
+		server->client = NULL;
+		server->route  = NULL;
+
+		/* remove client from route client pool */
+		client->server = NULL;
+		client->route  = NULL;
+		od_client_pool_set(&route->client_pool, client, OD_CLIENT_UNDEF);
+		assert(od_atomic_u32_of(&router->clients) > 0);
+		od_atomic_u32_dec(&router->clients);
+
+		assert(server->io == NULL);
+		od_backend_close(server);
+
+		msg_close->status = OD_ROK;
+		machine_channel_write(msg_close->response, msg);
+		break;
+	}
 
-			msg_detach->status = OD_ROK;
-			machine_channel_write(msg_detach->response, msg);
-			break;
-		}
+	default:
+		assert(0);
+		break;
+	}
+}
 
-		case OD_MROUTER_CLOSE_AND_UNROUTE:
-		{
-			/* detach closed server connection and unroute client */
-			od_msg_router_t *msg_close;
-			msg_close = machine_msg_get_data(msg);
-
-			od_client_t *client = msg_close->client;
-			od_route_t *route = client->route;
-			od_server_t *server = client->server;
-			od_server_pool_set(&route->server_pool, server, OD_SERVER_UNDEF);
-			server->client = NULL;
-			server->route  = NULL;
-
-			/* remove client from route client pool */
-			client->server = NULL;
-			client->route  = NULL;
-			od_client_pool_set(&route->client_pool, client, OD_CLIENT_UNDEF);
-			assert(router->clients > 0);
-			router->clients--;
-
-			assert(server->io == NULL);
-			od_backend_close(server);
-
-			msg_close->status = OD_ROK;
-			machine_channel_write(msg_close->response, msg);
+static inline void
+od_router(void *arg)
+{
+	od_router_shard_t *shard = arg;
+	for (;;)
+	{
+		machine_msg_t *msgs[OD_CHANNEL_BATCH];
+		int count;
+		count = machine_channel_read_batch(shard->channel, msgs,
+		                                   OD_CHANNEL_BATCH, UINT32_MAX);
+		if (count == -1)
 			break;
-		}
 
-		case OD_MROUTER_CANCEL:
-		{
-			/* match server key and config by client key */
-			od_msg_router_t *msg_cancel;
-			msg_cancel = machine_msg_get_data(msg);
-
-			int rc;
-			rc = od_cancel_find(&router->route_pool,
-			                    &msg_cancel->client->startup.key,
-			                     msg_cancel->cancel);
-			if (rc == -1)
-				msg_cancel->status = OD_RERROR;
-			else
-				msg_cancel->status = OD_ROK;
-			machine_channel_write(msg_cancel->response, msg);
-			break;
-		}
-		default:
-			assert(0);
-			break;
-		}
+		od_router_shard_lock(shard);
+		int i;
+		for (i = 0; i < count; i++)
+			od_router_process(shard, msgs[i]);
+		od_router_shard_unlock(shard);
 	}
 }
 
 void
 od_router_init(od_router_t *router, od_global_t *global)
 {
-	od_route_pool_init(&router->route_pool);
-	router->global  = global;
-	router->clients = 0;
-	router->channel = NULL;
+	pthread_mutex_init(&router->lock, NULL);
+	router->global       = global;
+	router->clients      = 0;
+	router->shards       = NULL;
+	router->shards_count = 0;
+}
+
+static inline void
+od_router_shard_free(od_router_shard_t *shard)
+{
+	od_route_pool_free(&shard->route_pool);
+	od_cancel_index_free(&shard->cancel_index);
+	if (shard->channel)
+		machine_channel_free(shard->channel);
+	pthread_mutex_destroy(&shard->lock);
+}
+
+void
+od_router_free(od_router_t *router)
+{
+	int i;
+	for (i = 0; i < router->shards_count; i++)
+		od_router_shard_free(&router->shards[i]);
+	if (router->shards)
+		free(router->shards);
+	router->shards = NULL;
+	router->shards_count = 0;
 }
 
 int
-od_router_start(od_router_t *router)
+od_router_start(od_router_t *router, int shards_count)
 {
 	od_instance_t *instance = router->global->instance;
 
-	router->channel = machine_channel_create(instance->is_shared);
-	if (router->channel == NULL) {
+	router->shards = malloc(sizeof(od_router_shard_t) * shards_count);
+	if (router->shards == NULL) {
 		od_error(&instance->logger, "router", NULL, NULL,
-		         "failed to create router channel");
+		         "failed to allocate router shards");
 		return -1;
 	}
+	int i;
+	for (i = 0; i < shards_count; i++) {
+		od_router_shard_t *shard = &router->shards[i];
+		shard->id = i;
+		shard->router = router;
+		pthread_mutex_init(&shard->lock, NULL);
+		od_route_pool_init(&shard->route_pool);
+		od_cancel_index_init(&shard->cancel_index);
+		router->shards_count++;
+		shard->channel = machine_channel_create(od_instance_channel_type(instance));
+		if (shard->channel == NULL) {
+			od_error(&instance->logger, "router", NULL, NULL,
+			         "failed to create router channel");
+			od_router_free(router);
+			return -1;
+		}
+	}
+	return 0;
+}
+
+int
+od_router_shard_start(od_router_t *router, int id)
+{
+	od_instance_t *instance = router->global->instance;
+	assert(id < router->shards_count);
 	int64_t coroutine_id;
-	coroutine_id = machine_coroutine_create(od_router, router);
+	coroutine_id = machine_coroutine_create(od_router, &router->shards[id]);
 	if (coroutine_id == -1) {
 		od_error(&instance->logger, "router", NULL, NULL,
 		         "failed to start router");
@@ -467,55 +515,225 @@ od_router_start(od_router_t *router)
 	return 0;
 }
 
+int
+od_router_routes(od_router_t *router)
+{
+	int count = 0;
+	int i;
+	for (i = 0; i < router->shards_count; i++) {
+		od_router_shard_t *shard = &router->shards[i];
+		od_router_shard_lock(shard);
+		count += shard->route_pool.count;
+		od_router_shard_unlock(shard);
+	}
+	return count;
+}
+
+int
+od_router_foreach(od_router_t *router, od_route_pool_cb_t callback,
+                  void *arg)
+{
+	int i;
+	for (i = 0; i < router->shards_count; i++) {
+		od_router_shard_t *shard = &router->shards[i];
+		od_router_shard_lock(shard);
+		int rc;
+		rc = od_route_pool_foreach(&shard->route_pool, callback, arg);
+		od_router_shard_unlock(shard);
+		if (rc == -1)
+			return -1;
+	}
+	return 0;
+}
+
+od_server_t*
+od_router_server_foreach(od_router_t *router, od_server_state_t state,
+                         od_server_pool_cb_t callback,
+                         void *arg)
+{
+	int i;
+	for (i = 0; i < router->shards_count; i++) {
+		od_router_shard_t *shard = &router->shards[i];
+		od_router_shard_lock(shard);
+		od_server_t *server;
+		server = od_route_pool_server_foreach(&shard->route_pool, state,
+		                                      callback, arg);
+		od_router_shard_unlock(shard);
+		if (server)
+			return server;
+	}
+	return NULL;
+}
+
+od_client_t*
+od_router_client_foreach(od_router_t *router, od_client_state_t state,
+                         od_client_pool_cb_t callback,
+                         void *arg)
+{
+	int i;
+	for (i = 0; i < router->shards_count; i++) {
+		od_router_shard_t *shard = &router->shards[i];
+		od_router_shard_lock(shard);
+		od_client_t *client;
+		client = od_route_pool_client_foreach(&shard->route_pool, state,
+		                                      callback, arg);
+		od_router_shard_unlock(shard);
+		if (client)
+			return client;
+	}
+	return NULL;
+}
+
+int
+od_router_stat(od_router_t *router, od_route_pool_stat_cb_t callback,
+               uint64_t prev_time_us,
+               void *arg)
+{
+	int i;
+	for (i = 0; i < router->shards_count; i++) {
+		od_router_shard_t *shard = &router->shards[i];
+		od_router_shard_lock(shard);
+		int rc;
+		rc = od_route_pool_stat(&shard->route_pool, callback,
+		                        prev_time_us, arg);
+		od_router_shard_unlock(shard);
+		if (rc == -1)
+			return -1;
+	}
+	return 0;
+}
+
+int
+od_router_stat_database(od_router_t *router,
+                        od_route_pool_stat_database_cb_t callback,
+                        uint64_t prev_time_us,
+                        void *arg)
+{
+	/* database routes could be spread between shards, lock
+	 * all of them to get consistent totals */
+	od_route_pool_t *pools[router->shards_count];
+	int i;
+	for (i = 0; i < router->shards_count; i++) {
+		od_router_shard_lock(&router->shards[i]);
+		pools[i] = &router->shards[i].route_pool;
+	}
+	int rc;
+	rc = od_route_pool_stat_database(pools, router->shards_count,
+	                                 callback, prev_time_us, arg);
+	for (i = 0; i < router->shards_count; i++)
+		od_router_shard_unlock(&router->shards[i]);
+	return rc;
+}
+
+static inline int
+od_router_reply_prepare(od_client_t *client)
+{
+	od_instance_t *instance = client->global->instance;
+
+	/* router request message and reply channel are allocated
+	 * once per client and reused by each request */
+	if (client->router_msg == NULL) {
+		client->router_msg = machine_msg_create(sizeof(od_msg_router_t));
+		if (client->router_msg == NULL)
+			return -1;
+	}
+	if (client->router_reply == NULL) {
+		client->router_reply = machine_channel_create(od_instance_channel_type(instance));
+		if (client->router_reply == NULL)
+			return -1;
+	}
+	return 0;
+}
+
 static od_router_status_t
-od_router_do(od_client_t *client, od_msg_t msg_type, od_router_cancel_t *cancel)
+od_router_do(od_client_t *client, od_msg_t msg_type, od_msg_router_t *request)
 {
-	od_router_t *router = client->global->router;
-	od_instance_t *instance = router->global->instance;
+	od_router_shard_t *shard = od_router_shard_of(client);
+
+	int rc;
+	rc = od_router_reply_prepare(client);
+	if (rc == -1)
+		return OD_RERROR;
 
 	/* send request to router */
 	machine_msg_t *msg;
-	msg = machine_msg_create(sizeof(od_msg_router_t));
-	if (msg == NULL)
-		return OD_RERROR;
+	msg = client->router_msg;
 	machine_msg_set_type(msg, msg_type);
 
 	od_msg_router_t *msg_route;
 	msg_route = machine_msg_get_data(msg);
+	if (request)
+		*msg_route = *request;
+	else
+		msg_route->config = NULL;
 	msg_route->status = OD_RERROR;
 	msg_route->client = client;
-	msg_route->response = NULL;
-	msg_route->cancel = cancel;
-
-	/* create response channel */
-	machine_channel_t *response;
-	response = machine_channel_create(instance->is_shared);
-	if (response == NULL) {
-		machine_msg_free(msg);
-		return OD_RERROR;
-	}
-	msg_route->response = response;
-	machine_channel_write(router->channel, msg);
+	msg_route->response = client->router_reply;
+	machine_channel_write(shard->channel, msg);
 
-	/* wait for reply */
-	msg = machine_channel_read(response, UINT32_MAX);
+	/* wait for reply, router sends back the same message */
+	msg = machine_channel_read(client->router_reply, UINT32_MAX);
 	if (msg == NULL) {
 		abort();
-		machine_channel_free(response);
 		return OD_RERROR;
 	}
+	assert(msg == client->router_msg);
 	msg_route = machine_msg_get_data(msg);
-	od_router_status_t status;
-	status = msg_route->status;
-	machine_channel_free(response);
-	machine_msg_free(msg);
-	return status;
+	return msg_route->status;
 }
 
 od_router_status_t
 od_route(od_client_t *client)
 {
-	return od_router_do(client, OD_MROUTER_ROUTE, NULL);
+	od_router_t *router = client->global->router;
+	od_instance_t *instance = client->global->instance;
+	kiwi_be_startup_t *startup = &client->startup;
+
+	assert(startup->database != NULL);
+	assert(startup->user != NULL);
+
+	/* match latest version of route config, keep it referenced
+	 * until the shard links it with a route */
+	od_router_lock(router);
+	od_config_route_t *config;
+	config = od_config_route_forward(&instance->config,
+	                                 kiwi_param_value(startup->database),
+	                                 kiwi_param_value(startup->user));
+	if (config)
+		od_config_route_ref(config);
+	od_router_unlock(router);
+	if (config == NULL)
+		return OD_RERROR_NOT_FOUND;
+
+	od_msg_router_t request;
+	request.config = config;
+	request.id.database     = kiwi_param_value(startup->database);
+	request.id.database_len = startup->database->value_len;
+	request.id.user         = kiwi_param_value(startup->user);
+	request.id.user_len     = startup->user->value_len;
+
+	/* force settings required by route */
+	if (config->storage_db) {
+		request.id.database = config->storage_db;
+		request.id.database_len = strlen(config->storage_db) + 1;
+	}
+	if (config->storage_user) {
+		request.id.user = config->storage_user;
+		request.id.user_len = strlen(config->storage_user) + 1;
+	}
+
+	/* route is owned by a single shard */
+	od_hash_t hash;
+	hash = od_route_id_hash(&request.id);
+	client->router_shard = hash % router->shards_count;
+
+	od_router_status_t status;
+	status = od_router_do(client, OD_MROUTER_ROUTE, &request);
+
+	od_router_lock(router);
+	od_config_route_unref(config);
+	od_router_unlock(router);
+	return status;
 }
 
 od_router_status_t
@@ -578,5 +796,18 @@ od_router_close_and_unroute(od_client_t *client)
 od_router_status_t
 od_router_cancel(od_client_t *client, od_router_cancel_t *cancel)
 {
-	return od_router_do(client, OD_MROUTER_CANCEL, cancel);
+	/* cancel key could belong to any shard, lookup shard
+	 * indexes directly without a router round-trip */
+	od_router_t *router = client->global->router;
+	int i;
+	for (i = 0; i < router->shards_count; i++) {
+		od_router_shard_t *shard = &router->shards[i];
+		od_router_shard_lock(shard);
+		int rc;
+		rc = od_cancel_find(&shard->cancel_index, &client->startup.key, cancel);
+		od_router_shard_unlock(shard);
+		if (rc == 0)
+			return OD_ROK;
+	}
+	return OD_RERROR;
 }
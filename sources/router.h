@@ -7,7 +7,8 @@
  * Scalable PostgreSQL connection pooler.
 */
 
-typedef struct od_router od_router_t;
+typedef struct od_router_shard od_router_shard_t;
+typedef struct od_router       od_router_t;
 
 typedef enum
 {
@@ -18,16 +19,76 @@ typedef enum
 	OD_RERROR_TIMEDOUT
 } od_router_status_t;
 
-struct od_router
+/* Routes are partitioned between router shards by route id,
+ * each shard is served by a coroutine running inside
+ * its own worker machine.
+ *
+ * Shard lock protects the route pool from the system
+ * machine (cron, console, config reload) and must never be
+ * held across a yield.
+*/
+struct od_router_shard
 {
+	int                id;
+	pthread_mutex_t    lock;
 	od_route_pool_t    route_pool;
+	od_cancel_index_t  cancel_index;
 	machine_channel_t *channel;
-	int                clients;
+	od_router_t       *router;
+};
+
+struct od_router
+{
+	pthread_mutex_t    lock;
+	od_router_shard_t *shards;
+	int                shards_count;
+	od_atomic_u32_t    clients;
 	od_global_t       *global;
 };
 
+static inline void
+od_router_lock(od_router_t *router)
+{
+	pthread_mutex_lock(&router->lock);
+}
+
+static inline void
+od_router_unlock(od_router_t *router)
+{
+	pthread_mutex_unlock(&router->lock);
+}
+
+static inline void
+od_router_shard_lock(od_router_shard_t *shard)
+{
+	pthread_mutex_lock(&shard->lock);
+}
+
+static inline void
+od_router_shard_unlock(od_router_shard_t *shard)
+{
+	pthread_mutex_unlock(&shard->lock);
+}
+
 void od_router_init(od_router_t*, od_global_t*);
-int  od_router_start(od_router_t*);
+void od_router_free(od_router_t*);
+int  od_router_start(od_router_t*, int);
+int  od_router_shard_start(od_router_t*, int);
+int  od_router_routes(od_router_t*);
+
+int  od_router_foreach(od_router_t*, od_route_pool_cb_t, void*);
+
+od_server_t*
+od_router_server_foreach(od_router_t*, od_server_state_t,
+                         od_server_pool_cb_t, void*);
+
+od_client_t*
+od_router_client_foreach(od_router_t*, od_client_state_t,
+                         od_client_pool_cb_t, void*);
+
+int  od_router_stat(od_router_t*, od_route_pool_stat_cb_t, uint64_t, void*);
+int  od_router_stat_database(od_router_t*, od_route_pool_stat_database_cb_t,
+                             uint64_t, void*);
 
 od_router_status_t
 od_route(od_client_t*);
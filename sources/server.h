@@ -39,6 +39,7 @@ struct od_server
 	void              *client;
 	void              *route;
 	od_global_t       *global;
+	od_list_t          link_cancel;
 	od_list_t          link;
 };
 
@@ -63,6 +64,7 @@ od_server_init(od_server_t *server)
 	kiwi_key_init(&server->key);
 	kiwi_key_init(&server->key_client);
 	od_packet_init(&server->packet_reader);
+	od_list_init(&server->link_cancel);
 	od_list_init(&server->link);
 	memset(&server->id, 0, sizeof(server->id));
 	memset(&server->last_client_id, 0, sizeof(server->last_client_id));
@@ -13,6 +13,7 @@
 #include <ctype.h>
 #include <inttypes.h>
 #include <assert.h>
+#include <pthread.h>
 
 #include <unistd.h>
 #include <signal.h>
@@ -23,7 +24,7 @@
 #include <kiwi.h>
 #include <odyssey.h>
 
-static inline void
+void
 od_system_server(void *arg)
 {
 	od_system_server_t *server = arg;
@@ -46,10 +47,8 @@ od_system_server(void *arg)
 			continue;
 		}
 
-		/* set network options */
-		machine_set_nodelay(client_io, instance->config.nodelay);
-		if (instance->config.keepalive > 0)
-			machine_set_keepalive(client_io, 1, instance->config.keepalive);
+		/* nodelay and keepalive are inherited from the listen
+		 * socket, client notify eventfd is created by worker */
 		rc = machine_set_readahead(client_io, instance->config.readahead);
 		if (rc == -1) {
 			od_error(&instance->logger, "server", NULL, NULL,
@@ -60,26 +59,6 @@ od_system_server(void *arg)
 			continue;
 		}
 
-		machine_io_t *notify_io;
-		notify_io = machine_io_create();
-		if (notify_io == NULL) {
-			od_error(&instance->logger, "server", NULL, NULL,
-			         "failed to allocate client io notify object");
-			machine_close(client_io);
-			machine_io_free(client_io);
-			continue;
-		}
-		rc = machine_eventfd(notify_io);
-		if (rc == -1) {
-			od_error(&instance->logger, "server", NULL, NULL,
-			         "failed to get eventfd for client: %s",
-			         machine_error(client_io));
-			machine_close(notify_io);
-			machine_close(client_io);
-			machine_io_free(client_io);
-			continue;
-		}
-
 		/* allocate new client */
 		od_client_t *client = od_client_allocate();
 		if (client == NULL) {
@@ -92,27 +71,51 @@ od_system_server(void *arg)
 		od_id_mgr_generate(&instance->id_mgr, &client->id, "c");
 		od_packet_set_chunk(&client->packet_reader, instance->config.packet_read_size);
 		client->io = client_io;
-		client->io_notify = notify_io;
 		client->config_listen = server->config;
 		client->tls = server->tls;
 		client->time_accept = 0;
 		if (instance->config.log_session)
 			client->time_accept = machine_time_us();
 
+		/* reuseport listener starts client in its own worker, unless
+		 * tls is negotiated on handshake threads */
+		od_worker_pool_t *worker_pool = server->global->worker_pool;
+		int is_handshake = server->tls && instance->config.tls_workers > 0;
+		if (server->worker_id != -1 && ! is_handshake) {
+			od_worker_t *worker = &worker_pool->pool[server->worker_id];
+			od_atomic_u32_inc(&worker->clients_active);
+			od_worker_client_new(worker, client);
+			continue;
+		}
+
 		/* create new client event and pass it to worker pool */
 		machine_msg_t *msg;
 		msg = machine_msg_create(sizeof(od_client_t*));
 		machine_msg_set_type(msg, OD_MCLIENT_NEW);
 		memcpy(machine_msg_get_data(msg), &client, sizeof(od_client_t*));
 
-		od_worker_pool_t *worker_pool = server->global->worker_pool;
+		/* negotiate tls on handshake threads, if enabled */
+		if (is_handshake)
+			worker_pool = server->global->handshake_pool;
 		od_worker_pool_feed(worker_pool, msg);
 	}
 }
 
+static inline void
+od_system_server_free(od_system_server_t *server)
+{
+	/* reuseport listeners of the same address share tls of the first one */
+	if (server->tls && server->worker_id <= 0)
+		machine_tls_free(server->tls);
+	machine_close(server->io);
+	machine_io_free(server->io);
+	free(server);
+}
+
 static inline int
 od_system_server_start(od_system_t *system, od_config_listen_t *config,
-                       struct addrinfo *addr)
+                       struct addrinfo *addr, int worker_id,
+                       machine_tls_t *tls)
 {
 	od_instance_t *instance = system->global.instance;
 	od_system_server_t *server;
@@ -122,14 +125,17 @@ od_system_server_start(od_system_t *system, od_config_listen_t *config,
 		         "failed to allocate system server object");
 		return -1;
 	}
-	server->config = config;
-	server->addr   = addr;
-	server->io     = NULL;
-	server->tls    = NULL;
-	server->global = &system->global;
-
-	/* create server tls */
-	if (server->config->tls_mode != OD_TLS_DISABLE) {
+	server->config    = config;
+	server->addr      = addr;
+	server->io        = NULL;
+	server->tls       = tls;
+	server->worker_id = worker_id;
+	server->global    = &system->global;
+	od_list_init(&server->link);
+
+	/* create server tls, reuseport listeners of the same address
+	 * share the first one */
+	if (server->tls == NULL && server->config->tls_mode != OD_TLS_DISABLE) {
 		server->tls = od_tls_frontend(server->config);
 		if (server->tls == NULL) {
 			od_error(&instance->logger, "server", NULL, NULL,
@@ -144,7 +150,7 @@ od_system_server_start(od_system_t *system, od_config_listen_t *config,
 	if (server->io == NULL) {
 		od_error(&instance->logger, "server", NULL, NULL,
 		         "failed to create system io");
-		if (server->tls)
+		if (server->tls && server->worker_id <= 0)
 			machine_tls_free(server->tls);
 		free(server);
 		return -1;
@@ -171,15 +177,22 @@ od_system_server_start(od_system_t *system, od_config_listen_t *config,
 		strncpy(saddr_un.sun_path, addr_name, addr_name_len);
 	}
 
+	/* set network options inherited by accepted clients */
+	machine_set_nodelay(server->io, instance->config.nodelay);
+	if (instance->config.keepalive > 0)
+		machine_set_keepalive(server->io, 1, instance->config.keepalive);
+
 	/* bind */
 	int rc;
+	if (server->worker_id != -1)
+		machine_set_reuseport(server->io, 1);
 	rc = machine_bind(server->io, saddr);
 	if (rc == -1) {
 		od_error(&instance->logger, "server", NULL, NULL,
 		         "bind to '%s' failed: %s",
 		         addr_name,
 		         machine_error(server->io));
-		if (server->tls)
+		if (server->tls && server->worker_id <= 0)
 			machine_tls_free(server->tls);
 		machine_close(server->io);
 		machine_io_free(server->io);
@@ -205,6 +218,13 @@ od_system_server_start(od_system_t *system, od_config_listen_t *config,
 		}
 	}
 
+	/* accept in worker thread, once listeners of all workers are bound */
+	if (server->worker_id != -1) {
+		machine_io_detach(server->io);
+		od_list_append(&system->servers, &server->link);
+		return 0;
+	}
+
 	od_log(&instance->logger, "server", NULL, NULL,
 	       "listening on %s", addr_name);
 
@@ -213,16 +233,106 @@ od_system_server_start(od_system_t *system, od_config_listen_t *config,
 	if (coroutine_id == -1) {
 		od_error(&instance->logger, "system", NULL, NULL,
 		         "failed to start server coroutine");
-		if (server->tls)
-			machine_tls_free(server->tls);
-		machine_close(server->io);
-		machine_io_free(server->io);
-		free(server);
+		od_system_server_free(server);
 		return -1;
 	}
+	od_list_append(&system->servers, &server->link);
 	return 0;
 }
 
+static inline int
+od_system_server_listen(od_system_t *system, od_system_server_t *server)
+{
+	od_instance_t *instance = system->global.instance;
+	machine_msg_t *msg;
+	msg = machine_msg_create(sizeof(od_system_server_t*));
+	if (msg == NULL)
+		return -1;
+	machine_msg_set_type(msg, OD_MSERVER_LISTEN);
+	memcpy(machine_msg_get_data(msg), &server, sizeof(od_system_server_t*));
+
+	char addr_name[PATH_MAX];
+	od_getaddrname(server->addr, addr_name, sizeof(addr_name), 1, 1);
+	od_log(&instance->logger, "server", NULL, NULL,
+	       "listening on %s (worker %d)", addr_name, server->worker_id);
+
+	od_worker_pool_t *worker_pool = system->global.worker_pool;
+	od_worker_t *worker = &worker_pool->pool[server->worker_id];
+	machine_channel_write(worker->task_channel, msg);
+	return 0;
+}
+
+static inline int
+od_system_server_start_all(od_system_t *system, od_config_listen_t *config,
+                           struct addrinfo *addr)
+{
+	od_instance_t *instance = system->global.instance;
+	if (! config->reuseport)
+		return od_system_server_start(system, config, addr, -1, NULL);
+
+	/* bind listen socket per worker, the address is not listened
+	 * unless every worker gets its socket */
+	od_list_t *last = system->servers.prev;
+	od_system_server_t *first = NULL;
+	int i;
+	for (i = 0; i < instance->config.workers; i++) {
+		machine_tls_t *tls = NULL;
+		if (first)
+			tls = first->tls;
+		int rc;
+		rc = od_system_server_start(system, config, addr, i, tls);
+		if (rc == -1)
+			break;
+		if (first == NULL)
+			first = od_container_of(system->servers.prev,
+			                        od_system_server_t, link);
+	}
+
+	od_list_t *j, *n;
+	if (i < instance->config.workers) {
+		od_error(&instance->logger, "system", NULL, NULL,
+		         "failed to bind listen socket of worker %d, "
+		         "closing %d bound sockets", i, i);
+
+		/* close sockets already bound for the address, the shared
+		 * tls is freed last, with the first one */
+		for (j = system->servers.prev; j != last; j = n) {
+			n = j->prev;
+			od_system_server_t *server;
+			server = od_container_of(j, od_system_server_t, link);
+			od_list_unlink(&server->link);
+			od_system_server_free(server);
+		}
+		return -1;
+	}
+
+	/* pass bound sockets to workers */
+	int listening = 0;
+	int failed = 0;
+	for (j = last->next; j != &system->servers; j = n) {
+		n = j->next;
+		od_system_server_t *server;
+		server = od_container_of(j, od_system_server_t, link);
+		if (! failed) {
+			int rc;
+			rc = od_system_server_listen(system, server);
+			if (rc == 0) {
+				listening++;
+				continue;
+			}
+			failed = 1;
+		}
+		od_list_unlink(&server->link);
+		od_system_server_free(server);
+	}
+	if (listening < instance->config.workers) {
+		od_error(&instance->logger, "system", NULL, NULL,
+		         "listener is degraded, %d of %d workers accept clients",
+		         listening, instance->config.workers);
+	}
+	return (listening > 0) ? 0 : -1;
+}
+
 static inline int
 od_system_listen(od_system_t *system)
 {
@@ -237,7 +347,7 @@ od_system_listen(od_system_t *system)
 		/* unix socket */
 		int rc;
 		if (listen->host == NULL) {
-			rc = od_system_server_start(system, listen, NULL);
+			rc = od_system_server_start(system, listen, NULL, -1, NULL);
 			if (rc == 0)
 				binded++;
 			continue;
@@ -272,13 +382,13 @@ od_system_listen(od_system_t *system)
 
 		/* listen resolved addresses */
 		if (host) {
-			rc = od_system_server_start(system, listen, ai);
+			rc = od_system_server_start_all(system, listen, ai);
 			if (rc == 0)
 				binded++;
 			continue;
 		}
 		while (ai) {
-			rc = od_system_server_start(system, listen, ai);
+			rc = od_system_server_start_all(system, listen, ai);
 			if (rc == 0)
 				binded++;
 			ai = ai->ai_next;
@@ -354,20 +464,24 @@ od_system_config_reload(od_system_t *system)
 	 * present in new config file.
 	*/
 	int has_updates;
+	od_router_lock(router);
 	has_updates = od_config_merge(&instance->config, &instance->logger, &config);
+	od_router_unlock(router);
 
 	/* free unused settings */
 	od_config_free(&config);
 
 	/* force obsolete clients to disconnect */
-	od_route_pool_foreach(&router->route_pool, od_system_config_reload_kill,
-	                      NULL);
+	od_router_foreach(router, od_system_config_reload_kill, NULL);
 
 	if (! instance->config.log_config)
 		return;
 
-	if (has_updates)
+	if (has_updates) {
+		od_router_lock(router);
 		od_config_print(&instance->config, &instance->logger, 1);
+		od_router_unlock(router);
+	}
 }
 
 static inline void
@@ -421,31 +535,44 @@ od_system(void *arg)
 	od_system_t *system = arg;
 	od_instance_t *instance = system->global.instance;
 
-	/* start router coroutine */
+	/* prepare router shards, one per worker */
 	int rc;
 	od_router_t *router = system->global.router;
-	rc = od_router_start(router);
+	rc = od_router_start(router, instance->config.workers);
 	if (rc == -1)
 		return;
 
 	/* start console coroutine */
 	od_console_t *console = system->global.console;
 	rc = od_console_start(console);
-	if (rc == -1)
+	if (rc == -1) {
+		od_router_free(router);
 		return;
+	}
 
 	/* start cron coroutine */
 	od_cron_t *cron = system->global.cron;
 	rc = od_cron_start(cron);
-	if (rc == -1)
+	if (rc == -1) {
+		od_router_free(router);
 		return;
+	}
 
 	/* start worker threads */
 	od_worker_pool_t *worker_pool = system->global.worker_pool;
-	rc = od_worker_pool_start(worker_pool, &system->global, instance->config.workers);
+	rc = od_worker_pool_start(worker_pool, &system->global, instance->config.workers, 0);
 	if (rc == -1)
 		return;
 
+	/* start tls handshake threads */
+	if (instance->config.tls_workers > 0) {
+		od_worker_pool_t *handshake_pool = system->global.handshake_pool;
+		rc = od_worker_pool_start(handshake_pool, &system->global,
+		                          instance->config.tls_workers, 1);
+		if (rc == -1)
+			return;
+	}
+
 	/* start signal handler coroutine */
 	int64_t coroutine_id;
 	coroutine_id = machine_coroutine_create(od_system_signal_handler, system);
@@ -469,6 +596,7 @@ od_system_init(od_system_t *system)
 {
 	system->machine = -1;
 	memset(&system->global, 0, sizeof(system->global));
+	od_list_init(&system->servers);
 	return 0;
 }
 
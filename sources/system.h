@@ -16,16 +16,20 @@ struct od_system_server
 	machine_tls_t      *tls;
 	od_config_listen_t *config;
 	struct addrinfo    *addr;
+	int                 worker_id;
 	od_global_t        *global;
+	od_list_t           link;
 };
 
 struct od_system
 {
 	int64_t     machine;
 	od_global_t global;
+	od_list_t   servers;
 };
 
-int od_system_init(od_system_t*);
-int od_system_start(od_system_t*);
+int  od_system_init(od_system_t*);
+int  od_system_start(od_system_t*);
+void od_system_server(void*);
 
 #endif /* ODYSSEY_SYSTEM_H */
@@ -13,6 +13,7 @@
 #include <ctype.h>
 #include <inttypes.h>
 #include <assert.h>
+#include <pthread.h>
 
 #include <machinarium.h>
 #include <kiwi.h>
@@ -54,6 +55,8 @@ od_tls_frontend(od_config_listen_t *config)
 			return NULL;
 		}
 	}
+	if (config->tls_ktls)
+		machine_tls_set_ktls(tls, 1);
 	return tls;
 }
 
@@ -169,13 +172,16 @@ od_tls_backend(od_config_storage_t *config)
 			return NULL;
 		}
 	}
+	if (config->tls_ktls)
+		machine_tls_set_ktls(tls, 1);
 	return tls;
 }
 
 int
 od_tls_backend_connect(od_server_t *server,
                        od_logger_t *logger,
-                       od_config_storage_t *config)
+                       od_config_storage_t *config,
+                       machine_tls_t *tls)
 {
 	od_debug(logger, "tls", NULL, server, "init");
 
@@ -212,7 +218,7 @@ od_tls_backend_connect(od_server_t *server,
 	case 'S':
 		/* supported */
 		od_debug(logger, "tls", NULL, server, "supported");
-		rc = machine_set_tls(server->io, server->tls);
+		rc = machine_set_tls(server->io, tls);
 		if (rc == -1) {
 			od_error(logger, "tls", NULL, server, "error: %s",
 			         machine_error(server->io));
@@ -13,92 +13,195 @@
 #include <ctype.h>
 #include <inttypes.h>
 #include <assert.h>
+#include <pthread.h>
 
 #include <machinarium.h>
 #include <kiwi.h>
 #include <odyssey.h>
 
+void
+od_worker_client_new(od_worker_t *worker, od_client_t *client)
+{
+	od_instance_t *instance = worker->global->instance;
+	client->global = worker->global;
+	client->worker_load = &worker->clients_active;
+
+	/* handshake workers only do client startup and tls
+	 * negotiation, then pass client to the worker pool */
+	machine_coroutine_t function = od_frontend;
+	if (worker->is_handshake)
+		function = od_frontend_handshake;
+
+	int64_t coroutine_id;
+	coroutine_id = machine_coroutine_create(function, client);
+	if (coroutine_id == -1) {
+		od_error(&instance->logger, "worker", client, NULL,
+		         "failed to create coroutine");
+		machine_close(client->io);
+		od_client_free(client);
+		return;
+	}
+	client->coroutine_id = coroutine_id;
+
+	worker->clients_processed++;
+}
+
 static inline void
-od_worker(void *arg)
+od_worker_process(od_worker_t *worker, machine_msg_t *msg)
 {
-	od_worker_t *worker = arg;
 	od_instance_t *instance = worker->global->instance;
 
-	for (;;)
+	od_msg_t msg_type;
+	msg_type = machine_msg_get_type(msg);
+	switch (msg_type) {
+	case OD_MCLIENT_NEW:
 	{
-		machine_msg_t *msg;
-		msg = machine_channel_read(worker->task_channel, UINT32_MAX);
-		if (msg == NULL)
-			break;
-
-		od_msg_t msg_type;
-		msg_type = machine_msg_get_type(msg);
-		switch (msg_type) {
-		case OD_MCLIENT_NEW:
-		{
-			od_client_t *client;
-			client = *(od_client_t**)machine_msg_get_data(msg);
-			client->global = worker->global;
-
-			int64_t coroutine_id;
-			coroutine_id = machine_coroutine_create(od_frontend, client);
-			if (coroutine_id == -1) {
-				od_error(&instance->logger, "worker", client, NULL,
-				         "failed to create coroutine");
-				machine_close(client->io);
-				od_client_free(client);
-				break;
-			}
-			client->coroutine_id = coroutine_id;
-
-			worker->clients_processed++;
+		od_client_t *client;
+		client = *(od_client_t**)machine_msg_get_data(msg);
+		od_worker_client_new(worker, client);
+		break;
+	}
+	case OD_MSERVER_LISTEN:
+	{
+		/* accept clients of reuseport listener in this worker */
+		od_system_server_t *server;
+		server = *(od_system_server_t**)machine_msg_get_data(msg);
+		int rc;
+		rc = machine_io_attach(server->io);
+		if (rc == -1) {
+			od_error(&instance->logger, "worker", NULL, NULL,
+			         "failed to attach listen socket: %s",
+			         machine_error(server->io));
 			break;
 		}
-		case OD_MSTAT:
-		{
-			uint64_t count_coroutine = 0;
-			uint64_t count_coroutine_cache = 0;
-			uint64_t msg_allocated = 0;
-			uint64_t msg_cache_count = 0;
-			uint64_t msg_cache_gc_count = 0;
-			uint64_t msg_cache_size = 0;
-			machine_stat(&count_coroutine,
-			             &count_coroutine_cache,
-			             &msg_allocated,
-			             &msg_cache_count,
-			             &msg_cache_gc_count,
-			             &msg_cache_size);
-			od_log(&instance->logger, "stats", NULL, NULL,
-			       "worker[%d]: msg (%" PRIu64 " allocated, %" PRIu64 " cached, %" PRIu64 " freed, %" PRIu64 " cache_size), "
-			       "coroutines (%" PRIu64 " active, %"PRIu64 " cached), clients_processed: %" PRIu64,
-			       worker->id,
-			       msg_allocated,
-			       msg_cache_count,
-			       msg_cache_gc_count,
-			       msg_cache_size,
-			       count_coroutine,
-			       count_coroutine_cache,
-			       worker->clients_processed);
-			break;
+		int64_t coroutine_id;
+		coroutine_id = machine_coroutine_create(od_system_server, server);
+		if (coroutine_id == -1) {
+			od_error(&instance->logger, "worker", NULL, NULL,
+			         "failed to start server coroutine");
+			machine_io_detach(server->io);
 		}
-		default:
-			assert(0);
-			break;
+		break;
+	}
+	case OD_MSTAT:
+	{
+		uint64_t count_coroutine = 0;
+		uint64_t count_coroutine_cache = 0;
+		uint64_t msg_allocated = 0;
+		uint64_t msg_cache_count = 0;
+		uint64_t msg_cache_gc_count = 0;
+		uint64_t msg_cache_size = 0;
+		uint64_t msg_cache_hit[MACHINE_MSG_CACHE_CLASSES];
+		uint64_t msg_cache_miss[MACHINE_MSG_CACHE_CLASSES];
+		uint64_t wakeup_count = 0;
+		uint64_t wakeup_coalesced_count = 0;
+		machine_stat(&count_coroutine,
+		             &count_coroutine_cache,
+		             &msg_allocated,
+		             &msg_cache_count,
+		             &msg_cache_gc_count,
+		             &msg_cache_size,
+		             msg_cache_hit,
+		             msg_cache_miss,
+		             &wakeup_count,
+		             &wakeup_coalesced_count);
+		uint64_t stack_reserved = 0;
+		uint64_t stack_used_avg = 0;
+		uint64_t stack_used_p99 = 0;
+		uint64_t stack_used_max = 0;
+		uint64_t stack_used_count = 0;
+		machine_stack_stat(&stack_reserved, &stack_used_avg, &stack_used_p99,
+		                   &stack_used_max, &stack_used_count);
+		uint64_t msg_hit = 0;
+		uint64_t msg_miss = 0;
+		int i;
+		for (i = 0; i < MACHINE_MSG_CACHE_CLASSES; i++) {
+			msg_hit  += msg_cache_hit[i];
+			msg_miss += msg_cache_miss[i];
 		}
+		od_log(&instance->logger, "stats", NULL, NULL,
+		       "%s[%d]: msg (%" PRIu64 " allocated, %" PRIu64 " cached, %" PRIu64 " freed, %" PRIu64 " cache_size, %" PRIu64 " hit, %" PRIu64 " miss), "
+		       "coroutines (%" PRIu64 " active, %"PRIu64 " cached), "
+		       "stacks (%" PRIu64 " KB reserved, %" PRIu64 " sampled, %" PRIu64 " avg, %" PRIu64 " p99, %" PRIu64 " max used), "
+		       "wakeups (%" PRIu64 " sent, %" PRIu64 " coalesced), clients_processed: %" PRIu64 ", "
+		       "clients_active: %" PRIu32,
+		       worker->is_handshake ? "tls worker" : "worker",
+		       worker->id,
+		       msg_allocated,
+		       msg_cache_count,
+		       msg_cache_gc_count,
+		       msg_cache_size,
+		       msg_hit,
+		       msg_miss,
+		       count_coroutine,
+		       count_coroutine_cache,
+		       stack_reserved / 1024,
+		       stack_used_count,
+		       stack_used_avg,
+		       stack_used_p99,
+		       stack_used_max,
+		       wakeup_count,
+		       wakeup_coalesced_count,
+		       worker->clients_processed,
+		       od_atomic_u32_of(&worker->clients_active));
+		break;
+	}
+	default:
+		assert(0);
+		break;
+	}
 
-		machine_msg_free(msg);
+	machine_msg_free(msg);
+}
+
+static inline void
+od_worker(void *arg)
+{
+	od_worker_t *worker = arg;
+	od_instance_t *instance = worker->global->instance;
+
+	/* machinarium falls back to epoll */
+	char *poll_backend = instance->config.poll_backend;
+	if (poll_backend && strcmp(poll_backend, machine_poll()) != 0) {
+		od_error(&instance->logger, "worker", NULL, NULL,
+		         "poll backend '%s' is not supported, using '%s'",
+		         poll_backend, machine_poll());
+	}
+
+	/* start router shard coroutine */
+	if (! worker->is_handshake) {
+		int rc;
+		rc = od_router_shard_start(worker->global->router, worker->id);
+		if (rc == -1)
+			return;
+	}
+
+	for (;;)
+	{
+		machine_msg_t *msgs[OD_CHANNEL_BATCH];
+		int count;
+		count = machine_channel_read_batch(worker->task_channel, msgs,
+		                                   OD_CHANNEL_BATCH, UINT32_MAX);
+		if (count == -1)
+			break;
+		int i;
+		for (i = 0; i < count; i++)
+			od_worker_process(worker, msgs[i]);
 	}
 
 	od_log(&instance->logger, "worker", NULL, NULL, "stopped");
 }
 
 void
-od_worker_init(od_worker_t *worker, od_global_t *global, int id)
+od_worker_init(od_worker_t *worker, od_global_t *global, int id,
+               int is_handshake)
 {
 	worker->machine = -1;
 	worker->id = id;
+	worker->is_handshake = is_handshake;
 	worker->global = global;
 	worker->clients_processed = 0;
+	worker->clients_active = 0;
 }
 
 int
@@ -106,7 +209,7 @@ od_worker_start(od_worker_t *worker)
 {
 	od_instance_t *instance = worker->global->instance;
 
-	worker->task_channel = machine_channel_create(instance->is_shared);
+	worker->task_channel = machine_channel_create(od_instance_channel_type(instance));
 	if (worker->task_channel == NULL) {
 		od_error(&instance->logger, "worker", NULL, NULL,
 		         "failed to create task channel");
@@ -114,7 +217,9 @@ od_worker_start(od_worker_t *worker)
 	}
 	if (instance->is_shared) {
 		char name[32];
-		od_snprintf(name, sizeof(name), "worker: %d", worker->id);
+		od_snprintf(name, sizeof(name), "%s: %d",
+		            worker->is_handshake ? "tls worker" : "worker",
+		            worker->id);
 		worker->machine = machine_create(name, od_worker, worker);
 		if (worker->machine == -1) {
 			machine_channel_free(worker->task_channel);
@@ -13,12 +13,15 @@ struct od_worker
 {
 	int64_t            machine;
 	int                id;
+	int                is_handshake;
 	machine_channel_t *task_channel;
 	uint64_t           clients_processed;
+	od_atomic_u32_t    clients_active;
 	od_global_t       *global;
 };
 
-void od_worker_init(od_worker_t*, od_global_t*, int);
+void od_worker_init(od_worker_t*, od_global_t*, int, int);
 int  od_worker_start(od_worker_t*);
+void od_worker_client_new(od_worker_t*, od_client_t*);
 
 #endif /* ODYSSEY_WORKER_H */
@@ -11,9 +11,9 @@ typedef struct od_worker_pool od_worker_pool_t;
 
 struct od_worker_pool
 {
-	od_worker_t *pool;
-	int          round_robin;
-	int          count;
+	od_worker_t     *pool;
+	od_atomic_u32_t  round_robin;
+	int              count;
 };
 
 static inline void
@@ -25,7 +25,8 @@ od_worker_pool_init(od_worker_pool_t *pool)
 }
 
 static inline int
-od_worker_pool_start(od_worker_pool_t *pool, od_global_t *global, int count)
+od_worker_pool_start(od_worker_pool_t *pool, od_global_t *global, int count,
+                     int is_handshake)
 {
 	pool->pool = malloc(sizeof(od_worker_t) * count);
 	if (pool->pool == NULL)
@@ -34,7 +35,7 @@ od_worker_pool_start(od_worker_pool_t *pool, od_global_t *global, int count)
 	int i;
 	for (i = 0; i < count; i++) {
 		od_worker_t *worker = &pool->pool[i];
-		od_worker_init(worker, global, i);
+		od_worker_init(worker, global, i, is_handshake);
 		int rc;
 		rc = od_worker_start(worker);
 		if (rc == -1)
@@ -43,19 +44,58 @@ od_worker_pool_start(od_worker_pool_t *pool, od_global_t *global, int count)
 	return 0;
 }
 
+static inline od_worker_t*
+od_worker_pool_next(od_worker_pool_t *pool)
+{
+	/* power of two choices: compare round robin candidate with
+	 * another pseudo-random worker and take the one having less
+	 * active clients, equal load keeps round robin order */
+	uint32_t next;
+	next = __sync_fetch_and_add(&pool->round_robin, 1);
+	od_worker_t *worker;
+	worker = &pool->pool[next % pool->count];
+	if (pool->count == 1)
+		return worker;
+	uint32_t offset;
+	offset = 1 + ((next * 2654435761u) >> 16) % (pool->count - 1);
+	od_worker_t *other;
+	other = &pool->pool[(next + offset) % pool->count];
+	if (od_atomic_u32_of(&other->clients_active) <
+	    od_atomic_u32_of(&worker->clients_active))
+		worker = other;
+	return worker;
+}
+
 static inline void
 od_worker_pool_feed(od_worker_pool_t *pool, machine_msg_t *msg)
 {
-	int next = pool->round_robin;
-	if (pool->round_robin >= pool->count) {
-		pool->round_robin = 0;
-		next = 0;
-	}
-	pool->round_robin++;
-
+	/* fed by system and handshake threads, client is accounted
+	 * before it reaches the worker, so bursts are spread too */
 	od_worker_t *worker;
-	worker = &pool->pool[next];
+	worker = od_worker_pool_next(pool);
+	od_atomic_u32_inc(&worker->clients_active);
 	machine_channel_write(worker->task_channel, msg);
 }
 
+static inline void
+od_worker_pool_stat(od_worker_pool_t *pool, uint32_t *active,
+                    uint32_t *active_min, uint32_t *active_max)
+{
+	*active = 0;
+	*active_min = UINT32_MAX;
+	*active_max = 0;
+	int i;
+	for (i = 0; i < pool->count; i++) {
+		uint32_t count;
+		count = od_atomic_u32_of(&pool->pool[i].clients_active);
+		*active += count;
+		if (count < *active_min)
+			*active_min = count;
+		if (count > *active_max)
+			*active_max = count;
+	}
+	if (pool->count == 0)
+		*active_min = 0;
+}
+
 #endif /* ODYSSEY_WORKER_POOL_H */
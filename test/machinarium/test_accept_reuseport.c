@@ -0,0 +1,127 @@
+
+#include <machinarium.h>
+#include <odyssey_test.h>
+
+#include <arpa/inet.h>
+
+#define TEST_CLIENTS 20
+
+static int accepted = 0;
+static int done = 0;
+
+static void
+test_set_addr(struct sockaddr_in *sa)
+{
+	memset(sa, 0, sizeof(*sa));
+	sa->sin_family = AF_INET;
+	sa->sin_addr.s_addr = inet_addr("127.0.0.1");
+	sa->sin_port = htons(7778);
+}
+
+static void
+test_acceptor(void *arg)
+{
+	machine_io_t *server = arg;
+	while (accepted < TEST_CLIENTS) {
+		machine_io_t *client;
+		int rc;
+		rc = machine_accept(server, &client, 16, 1, 100);
+		if (rc == -1) {
+			test(machine_timedout());
+			continue;
+		}
+		accepted++;
+		machine_close(client);
+		machine_io_free(client);
+	}
+	done++;
+}
+
+static void
+test_client(void *arg)
+{
+	(void)arg;
+	struct sockaddr_in sa;
+	test_set_addr(&sa);
+	int i;
+	for (i = 0; i < TEST_CLIENTS; i++) {
+		machine_io_t *client = machine_io_create();
+		test(client != NULL);
+		int rc;
+		rc = machine_connect(client, (struct sockaddr*)&sa, UINT32_MAX);
+		test(rc == 0);
+		machine_close(client);
+		machine_io_free(client);
+	}
+	done++;
+}
+
+static void
+test_server(void *arg)
+{
+	(void)arg;
+	struct sockaddr_in sa;
+	test_set_addr(&sa);
+
+	/* address is busy unless every socket sets reuseport */
+	machine_io_t *a = machine_io_create();
+	machine_io_t *b = machine_io_create();
+	test(a != NULL && b != NULL);
+	int rc;
+	rc = machine_bind(a, (struct sockaddr*)&sa);
+	test(rc == 0);
+	machine_io_t *client;
+	rc = machine_accept(a, &client, 16, 1, 0);
+	test(rc == -1);
+	rc = machine_set_reuseport(b, 1);
+	test(rc == 0);
+	rc = machine_bind(b, (struct sockaddr*)&sa);
+	test(rc == -1);
+	test(machine_errno() == EADDRINUSE);
+	machine_close(a);
+	machine_io_free(a);
+	machine_io_free(b);
+
+	/* connections are accepted by both listeners */
+	a = machine_io_create();
+	b = machine_io_create();
+	test(a != NULL && b != NULL);
+	machine_set_reuseport(a, 1);
+	machine_set_reuseport(b, 1);
+	rc = machine_bind(a, (struct sockaddr*)&sa);
+	test(rc == 0);
+	rc = machine_bind(b, (struct sockaddr*)&sa);
+	test(rc == 0);
+
+	int64_t id;
+	id = machine_coroutine_create(test_acceptor, a);
+	test(id != -1);
+	id = machine_coroutine_create(test_acceptor, b);
+	test(id != -1);
+	id = machine_coroutine_create(test_client, NULL);
+	test(id != -1);
+	while (done < 3)
+		machine_sleep(0);
+	test(accepted == TEST_CLIENTS);
+
+	machine_close(a);
+	machine_close(b);
+	machine_io_free(a);
+	machine_io_free(b);
+}
+
+void
+machinarium_test_accept_reuseport(void)
+{
+	machinarium_init();
+
+	int id;
+	id = machine_create("test", test_server, NULL);
+	test(id != -1);
+
+	int rc;
+	rc = machine_wait(id);
+	test(rc != -1);
+
+	machinarium_free();
+}
@@ -0,0 +1,113 @@
+
+#include <machinarium.h>
+#include <odyssey_test.h>
+
+static machine_channel_t *channel;
+
+static void
+test_batch(int type)
+{
+	machine_channel_t *channel;
+	channel = machine_channel_create(type);
+	test(channel != NULL);
+
+	machine_msg_t *msgs[10];
+	int i;
+	for (i = 0; i < 10; i++) {
+		msgs[i] = machine_msg_create(0);
+		test(msgs[i] != NULL);
+		machine_msg_set_type(msgs[i], i);
+	}
+	machine_channel_write_batch(channel, msgs, 10);
+
+	/* messages are returned in order, up to max per call */
+	int next = 0;
+	int batches[] = { 4, 4, 2 };
+	int j;
+	for (j = 0; j < 3; j++) {
+		int count;
+		count = machine_channel_read_batch(channel, msgs, 4, UINT32_MAX);
+		test(count == batches[j]);
+		for (i = 0; i < count; i++) {
+			test(machine_msg_get_type(msgs[i]) == next);
+			machine_msg_free(msgs[i]);
+			next++;
+		}
+	}
+
+	int count;
+	count = machine_channel_read_batch(channel, msgs, 4, 10);
+	test(count == -1);
+
+	machine_channel_free(channel);
+}
+
+static void
+test_producer(void *arg)
+{
+	(void)arg;
+	int i;
+	for (i = 0; i < 100; i++) {
+		machine_msg_t *msgs[10];
+		int j;
+		for (j = 0; j < 10; j++) {
+			msgs[j] = machine_msg_create(0);
+			test(msgs[j] != NULL);
+			machine_msg_set_type(msgs[j], i * 10 + j);
+		}
+		machine_channel_write_batch(channel, msgs, 10);
+		machine_sleep(0);
+	}
+}
+
+static void
+test_consumer(void *arg)
+{
+	(void)arg;
+	test_batch(MACHINE_CHANNEL_FAST);
+	test_batch(MACHINE_CHANNEL_SHARED);
+	test_batch(MACHINE_CHANNEL_MPSC);
+
+	int id;
+	id = machine_create("producer", test_producer, NULL);
+	test(id != -1);
+
+	int next = 0;
+	while (next < 1000) {
+		machine_msg_t *msgs[16];
+		int count;
+		count = machine_channel_read_batch(channel, msgs, 16, UINT32_MAX);
+		test(count > 0);
+		int i;
+		for (i = 0; i < count; i++) {
+			test(machine_msg_get_type(msgs[i]) == next);
+			machine_msg_free(msgs[i]);
+			next++;
+		}
+	}
+
+	int rc;
+	rc = machine_wait(id);
+	test(rc != -1);
+}
+
+void
+machinarium_test_channel_batch(void)
+{
+	machinarium_init();
+
+	channel = machine_channel_create(MACHINE_CHANNEL_MPSC);
+	test(channel != NULL);
+
+	int id;
+	id = machine_create("consumer", test_consumer, NULL);
+	test(id != -1);
+
+	int rc;
+	rc = machine_wait(id);
+	test(rc != -1);
+
+	machine_channel_free(channel);
+
+	machinarium_free();
+}
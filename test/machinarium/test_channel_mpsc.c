@@ -0,0 +1,107 @@
+
+#include <machinarium.h>
+#include <odyssey_test.h>
+
+#define PRODUCERS 4
+#define PRODUCER_MSGS 10000
+
+static machine_channel_t *channel;
+
+static void
+test_producer(void *arg)
+{
+	uintptr_t id = (uintptr_t)arg;
+	int i;
+	for (i = 0; i < PRODUCER_MSGS; i++) {
+		machine_msg_t *msg;
+		msg = machine_msg_create(0);
+		test(msg != NULL);
+		machine_msg_set_type(msg, (id << 20) | i);
+		machine_channel_write(channel, msg);
+		if ((i % 1000) == 0)
+			machine_sleep(0);
+	}
+}
+
+static void
+test_consumer(void *arg)
+{
+	(void)arg;
+	int next[PRODUCERS] = {0};
+	int total = 0;
+	while (total < PRODUCERS * PRODUCER_MSGS) {
+		machine_msg_t *msg;
+		msg = machine_channel_read(channel, UINT32_MAX);
+		test(msg != NULL);
+		int type = machine_msg_get_type(msg);
+		int id = type >> 20;
+		test(id < PRODUCERS);
+		/* messages of each producer keep their order */
+		test((type & 0xfffff) == next[id]);
+		next[id]++;
+		total++;
+		machine_msg_free(msg);
+	}
+}
+
+static void
+test_timeout(void *arg)
+{
+	(void)arg;
+	machine_channel_t *channel;
+	channel = machine_channel_create(MACHINE_CHANNEL_MPSC);
+	test(channel != NULL);
+
+	machine_msg_t *msg;
+	msg = machine_channel_read(channel, 10);
+	test(msg == NULL);
+
+	msg = machine_msg_create(0);
+	test(msg != NULL);
+	machine_msg_set_type(msg, 123);
+	machine_channel_write(channel, msg);
+
+	msg = machine_channel_read(channel, 10);
+	test(msg != NULL);
+	test(machine_msg_get_type(msg) == 123);
+	machine_msg_free(msg);
+
+	machine_channel_free(channel);
+}
+
+void
+machinarium_test_channel_mpsc(void)
+{
+	machinarium_init();
+
+	int id;
+	id = machine_create("test", test_timeout, NULL);
+	test(id != -1);
+	int rc;
+	rc = machine_wait(id);
+	test(rc != -1);
+
+	channel = machine_channel_create(MACHINE_CHANNEL_MPSC);
+	test(channel != NULL);
+
+	int consumer;
+	consumer = machine_create("consumer", test_consumer, NULL);
+	test(consumer != -1);
+
+	int producers[PRODUCERS];
+	uintptr_t i;
+	for (i = 0; i < PRODUCERS; i++) {
+		producers[i] = machine_create("producer", test_producer, (void*)i);
+		test(producers[i] != -1);
+	}
+	for (i = 0; i < PRODUCERS; i++) {
+		rc = machine_wait(producers[i]);
+		test(rc != -1);
+	}
+	rc = machine_wait(consumer);
+	test(rc != -1);
+
+	machine_channel_free(channel);
+
+	machinarium_free();
+}
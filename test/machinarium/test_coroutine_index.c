@@ -0,0 +1,91 @@
+
+#include <machinarium.h>
+#include <odyssey_test.h>
+
+/*
+ * Wake up many coroutines waiting on condition by id, cancel
+ * and join some of them, and check that finished coroutines
+ * are no longer found (see benchmark_signal for timing).
+*/
+
+#define TEST_COROUTINES 10000
+
+static int64_t ids[TEST_COROUTINES];
+static int     signaled = 0;
+static int     cancelled = 0;
+
+static void
+test_waiter(void *arg)
+{
+	(void)arg;
+	int rc;
+	rc = machine_condition(UINT32_MAX);
+	if (machine_cancelled()) {
+		cancelled++;
+		return;
+	}
+	test(rc == 0);
+	signaled++;
+}
+
+static void
+test_runner(void *arg)
+{
+	(void)arg;
+	int i;
+	for (i = 0; i < TEST_COROUTINES; i++) {
+		ids[i] = machine_coroutine_create(test_waiter, NULL);
+		test(ids[i] != -1);
+	}
+
+	/* wait on condition */
+	machine_sleep(0);
+
+	/* cancel and join every tenth coroutine */
+	int rc;
+	for (i = 0; i < TEST_COROUTINES; i += 10) {
+		rc = machine_cancel(ids[i]);
+		test(rc == 0);
+		rc = machine_join(ids[i]);
+		test(rc == 0);
+	}
+
+	/* signal others in reverse order */
+	for (i = TEST_COROUTINES - 1; i >= 0; i--) {
+		if ((i % 10) == 0)
+			continue;
+		rc = machine_signal(ids[i]);
+		test(rc == 0);
+	}
+	machine_sleep(0);
+
+	test(signaled == TEST_COROUTINES - TEST_COROUTINES / 10);
+	test(cancelled == TEST_COROUTINES / 10);
+
+	/* finished coroutines are not found */
+	rc = machine_signal(ids[1]);
+	test(rc == -1);
+	test(machine_errno() == ENOENT);
+	rc = machine_cancel(ids[0]);
+	test(rc == -1);
+	rc = machine_join(ids[TEST_COROUTINES - 1]);
+	test(rc == -1);
+
+	machine_stop();
+}
+
+void
+machinarium_test_coroutine_index(void)
+{
+	machinarium_init();
+
+	int id;
+	id = machine_create("test", test_runner, NULL);
+	test(id != -1);
+
+	int rc;
+	rc = machine_wait(id);
+	test(rc != -1);
+
+	machinarium_free();
+}
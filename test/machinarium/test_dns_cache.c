@@ -0,0 +1,91 @@
+
+#include <machinarium.h>
+#include <odyssey_test.h>
+
+static void
+test_resolve(char *addr, char *service, int result)
+{
+	struct addrinfo *res = NULL;
+	int rc = machine_getaddrinfo(addr, service, NULL, &res, UINT32_MAX);
+	if (result == 0) {
+		test(rc == 0);
+		test(res != NULL);
+		machine_freeaddrinfo(res);
+	} else {
+		test(rc != 0);
+		test(res == NULL);
+	}
+}
+
+static void
+test_gai(void *arg)
+{
+	(void)arg;
+	uint64_t hit, miss, refresh, resolve, resolve_time;
+
+	/* second lookup is served from cache */
+	test_resolve("localhost", "http", 0);
+	test_resolve("localhost", "http", 0);
+	machine_dns_stat(&hit, &miss, &refresh, &resolve, &resolve_time);
+	test(hit == 1);
+	test(miss == 1);
+	test(resolve == 1);
+
+	/* failures are cached too */
+	test_resolve("127.0.0.1", "machinarium-unknown", -1);
+	test_resolve("127.0.0.1", "machinarium-unknown", -1);
+	machine_dns_stat(&hit, &miss, &refresh, &resolve, &resolve_time);
+	test(hit == 2);
+	test(miss == 2);
+	test(resolve == 2);
+
+	/* entry close to expiration is refreshed in background */
+	machine_sleep(800);
+	test_resolve("localhost", "http", 0);
+	machine_dns_stat(&hit, &miss, &refresh, &resolve, &resolve_time);
+	test(hit == 3);
+	test(refresh == 1);
+	while (resolve == 2) {
+		machine_sleep(10);
+		machine_dns_stat(&hit, &miss, &refresh, &resolve, &resolve_time);
+	}
+	test(resolve == 3);
+
+	/* refreshed entry does not expire */
+	machine_sleep(300);
+	test_resolve("localhost", "http", 0);
+	machine_dns_stat(&hit, &miss, &refresh, &resolve, &resolve_time);
+	test(hit == 4);
+	test(miss == 2);
+
+	/* waiter gives up on timeout, result is dropped */
+	struct addrinfo *res = NULL;
+	int rc = machine_getaddrinfo("localhost", "ftp", NULL, &res, 0);
+	if (rc == -1) {
+		test(machine_errno() == ETIMEDOUT);
+		test(res == NULL);
+	} else {
+		test(rc == 0);
+		machine_freeaddrinfo(res);
+	}
+}
+
+void
+machinarium_test_dns_cache(void)
+{
+	machinarium_set_dns_ttl(1000);
+	machinarium_set_dns_negative_ttl(1000);
+	machinarium_init();
+
+	int id;
+	id = machine_create("test", test_gai, NULL);
+	test(id != -1);
+
+	int rc;
+	rc = machine_wait(id);
+	test(rc != -1);
+
+	machinarium_free();
+	machinarium_set_dns_ttl(0);
+	machinarium_set_dns_negative_ttl(0);
+}
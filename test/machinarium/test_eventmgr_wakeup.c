@@ -0,0 +1,127 @@
+
+#include <machinarium.h>
+#include <odyssey_test.h>
+#include <unistd.h>
+
+#define READERS 10
+
+static machine_channel_t *channels[READERS];
+static machine_channel_t *channel_ready;
+static int readers_done;
+
+static void
+reader(void *arg)
+{
+	machine_channel_t *channel = arg;
+	machine_msg_t *msg;
+	msg = machine_channel_read(channel, UINT32_MAX);
+	test(msg != NULL);
+	machine_msg_free(msg);
+	readers_done++;
+}
+
+static void
+stat_wakeup(uint64_t *wakeup_count, uint64_t *wakeup_coalesced_count)
+{
+	uint64_t count_coroutine;
+	uint64_t count_coroutine_cache;
+	uint64_t msg_allocated;
+	uint64_t msg_cache_count;
+	uint64_t msg_cache_gc_count;
+	uint64_t msg_cache_size;
+	uint64_t msg_cache_hit[MACHINE_MSG_CACHE_CLASSES];
+	uint64_t msg_cache_miss[MACHINE_MSG_CACHE_CLASSES];
+	machine_stat(&count_coroutine, &count_coroutine_cache,
+	             &msg_allocated, &msg_cache_count, &msg_cache_gc_count,
+	             &msg_cache_size, msg_cache_hit, msg_cache_miss,
+	             wakeup_count, wakeup_coalesced_count);
+}
+
+static void
+consumer(void *arg)
+{
+	(void)arg;
+	int i;
+	for (i = 0; i < READERS; i++) {
+		int64_t id;
+		id = machine_coroutine_create(reader, channels[i]);
+		test(id != -1);
+	}
+	/* let readers start waiting */
+	machine_sleep(10);
+
+	uint64_t wakeup_count;
+	uint64_t wakeup_coalesced_count;
+	stat_wakeup(&wakeup_count, &wakeup_coalesced_count);
+
+	machine_msg_t *msg;
+	msg = machine_msg_create(0);
+	test(msg != NULL);
+	machine_channel_write(channel_ready, msg);
+
+	/* block machine thread, so that all signals are done
+	 * before the event manager is drained */
+	usleep(100 * 1000);
+
+	while (readers_done < READERS)
+		machine_sleep(0);
+
+	uint64_t wakeup_count_after;
+	uint64_t wakeup_coalesced_count_after;
+	stat_wakeup(&wakeup_count_after, &wakeup_coalesced_count_after);
+	test(wakeup_count_after - wakeup_count == 1);
+	test(wakeup_coalesced_count_after - wakeup_coalesced_count == READERS - 1);
+}
+
+static void
+producer(void *arg)
+{
+	(void)arg;
+	int id;
+	id = machine_create("consumer", consumer, NULL);
+	test(id != -1);
+
+	machine_msg_t *msg;
+	msg = machine_channel_read(channel_ready, UINT32_MAX);
+	test(msg != NULL);
+	machine_msg_free(msg);
+
+	int i;
+	for (i = 0; i < READERS; i++) {
+		msg = machine_msg_create(0);
+		test(msg != NULL);
+		machine_channel_write(channels[i], msg);
+	}
+
+	int rc;
+	rc = machine_wait(id);
+	test(rc != -1);
+}
+
+void
+machinarium_test_eventmgr_wakeup(void)
+{
+	machinarium_init();
+
+	int i;
+	for (i = 0; i < READERS; i++) {
+		channels[i] = machine_channel_create(MACHINE_CHANNEL_SHARED);
+		test(channels[i] != NULL);
+	}
+	channel_ready = machine_channel_create(MACHINE_CHANNEL_SHARED);
+	test(channel_ready != NULL);
+
+	int id;
+	id = machine_create("producer", producer, NULL);
+	test(id != -1);
+
+	int rc;
+	rc = machine_wait(id);
+	test(rc != -1);
+
+	for (i = 0; i < READERS; i++)
+		machine_channel_free(channels[i]);
+	machine_channel_free(channel_ready);
+
+	machinarium_free();
+}
@@ -13,7 +13,7 @@ test_gai(void *arg)
 	} else {
 		test(res != NULL);
 		if (res)
-			freeaddrinfo(res);
+			machine_freeaddrinfo(res);
 	}
 }
 
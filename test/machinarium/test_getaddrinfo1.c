@@ -13,7 +13,7 @@ test_gai0(void *arg)
 	} else {
 		test(res != NULL);
 		if (res)
-			freeaddrinfo(res);
+			machine_freeaddrinfo(res);
 	}
 }
 
@@ -28,7 +28,7 @@ test_gai1(void *arg)
 	} else {
 		test(res != NULL);
 		if (res)
-			freeaddrinfo(res);
+			machine_freeaddrinfo(res);
 	}
 }
 
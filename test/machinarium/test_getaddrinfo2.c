@@ -15,7 +15,7 @@ test_gai_coroutine(void *arg)
 	} else {
 		test(res != NULL);
 		if (res)
-			freeaddrinfo(res);
+			machine_freeaddrinfo(res);
 	}
 	gai_complete++;
 }
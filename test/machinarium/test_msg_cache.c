@@ -0,0 +1,121 @@
+
+#include <machinarium.h>
+#include <odyssey_test.h>
+
+#define MSG_COUNT 100
+#define MSG_CLASS 4
+
+static machine_channel_t *channel;
+static machine_channel_t *channel_ack;
+
+static void
+consumer(void *arg)
+{
+	(void)arg;
+	int i;
+	for (i = 0; i < MSG_COUNT; i++) {
+		machine_msg_t *msg;
+		msg = machine_channel_read(channel, UINT32_MAX);
+		test(msg != NULL);
+		test(machine_msg_get_size(msg) == 1000);
+		/* return message to producer cache */
+		machine_msg_free(msg);
+	}
+	machine_msg_t *msg;
+	msg = machine_msg_create(0);
+	test(msg != NULL);
+	machine_channel_write(channel_ack, msg);
+}
+
+static void
+produce(void)
+{
+	int i;
+	for (i = 0; i < MSG_COUNT; i++) {
+		machine_msg_t *msg;
+		msg = machine_msg_create(1000);
+		test(msg != NULL);
+		machine_channel_write(channel, msg);
+	}
+}
+
+static void
+producer(void *arg)
+{
+	(void)arg;
+	channel = machine_channel_create(1);
+	test(channel != NULL);
+	channel_ack = machine_channel_create(1);
+	test(channel_ack != NULL);
+
+	uint64_t count_coroutine;
+	uint64_t count_coroutine_cache;
+	uint64_t msg_allocated;
+	uint64_t msg_cache_count;
+	uint64_t msg_cache_gc_count;
+	uint64_t msg_cache_size;
+	uint64_t msg_cache_hit[MACHINE_MSG_CACHE_CLASSES];
+	uint64_t msg_cache_miss[MACHINE_MSG_CACHE_CLASSES];
+	uint64_t wakeup_count;
+	uint64_t wakeup_coalesced_count;
+
+	/* first round allocates messages */
+	int id;
+	id = machine_create("consumer", consumer, NULL);
+	test(id != -1);
+	produce();
+
+	machine_msg_t *ack;
+	ack = machine_channel_read(channel_ack, UINT32_MAX);
+	test(ack != NULL);
+	int rc;
+	rc = machine_wait(id);
+	test(rc != -1);
+
+	machine_stat(&count_coroutine, &count_coroutine_cache,
+	             &msg_allocated, &msg_cache_count, &msg_cache_gc_count,
+	             &msg_cache_size, msg_cache_hit, msg_cache_miss,
+	             &wakeup_count, &wakeup_coalesced_count);
+	test(msg_cache_hit[MSG_CLASS] == 0);
+	test(msg_cache_miss[MSG_CLASS] == MSG_COUNT);
+
+	/* message of finished machine is freed */
+	machine_msg_free(ack);
+
+	/* second round reuses messages returned by consumer */
+	id = machine_create("consumer", consumer, NULL);
+	test(id != -1);
+	produce();
+
+	ack = machine_channel_read(channel_ack, UINT32_MAX);
+	test(ack != NULL);
+	machine_msg_free(ack);
+	rc = machine_wait(id);
+	test(rc != -1);
+
+	machine_stat(&count_coroutine, &count_coroutine_cache,
+	             &msg_allocated, &msg_cache_count, &msg_cache_gc_count,
+	             &msg_cache_size, msg_cache_hit, msg_cache_miss,
+	             &wakeup_count, &wakeup_coalesced_count);
+	test(msg_cache_hit[MSG_CLASS] == MSG_COUNT);
+	test(msg_cache_miss[MSG_CLASS] == MSG_COUNT);
+
+	machine_channel_free(channel);
+	machine_channel_free(channel_ack);
+}
+
+void
+machinarium_test_msg_cache(void)
+{
+	machinarium_init();
+
+	int id;
+	id = machine_create("producer", producer, NULL);
+	test(id != -1);
+
+	int rc;
+	rc = machine_wait(id);
+	test(rc != -1);
+
+	machinarium_free();
+}
@@ -0,0 +1,316 @@
+
+/*
+ * machinarium.
+ *
+ * Cooperative multitasking engine.
+*/
+
+#include <machinarium.h>
+#include <odyssey_test.h>
+
+#include <string.h>
+#include <arpa/inet.h>
+
+static machine_io_t *notify = NULL;
+
+static void
+server(void *arg)
+{
+	(void)arg;
+	machine_io_t *server = machine_io_create();
+	test(server != NULL);
+
+	struct sockaddr_in sa;
+	sa.sin_family = AF_INET;
+	sa.sin_addr.s_addr = inet_addr("127.0.0.1");
+	sa.sin_port = htons(7778);
+	int rc;
+	rc = machine_bind(server, (struct sockaddr*)&sa);
+	test(rc == 0);
+
+	machine_io_t *client;
+	rc = machine_accept(server, &client, 16, 1, UINT32_MAX);
+	test(rc == 0);
+
+	rc = machine_set_readahead(client, 8192);
+	test(rc == 0);
+
+	machine_pollgroup_t *poll;
+	poll = machine_pollgroup_create();
+	test(poll != NULL);
+
+	rc = machine_pollgroup_add(poll, notify);
+	test(rc == 0);
+	rc = machine_pollgroup_add(poll, client);
+	test(rc == 0);
+	rc = machine_pollgroup_add(poll, client);
+	test(rc == 0);
+
+	/* io cannot be used by machine_read_poll() while in a group */
+	machine_io_t *io_set[] = {client};
+	machine_io_t *io_ready[2];
+	rc = machine_read_poll(io_set, io_ready, 1, 0);
+	test(rc == -1);
+
+	/* read messages in chunks */
+	int i;
+	for (i = 0; i < 4; i++) {
+		rc = machine_pollgroup_wait(poll, io_ready, 2, UINT32_MAX);
+		test(rc == 1);
+		test(io_ready[0] == client);
+
+		machine_msg_t *msg;
+		msg = machine_read(client, 128, UINT32_MAX);
+		test(msg != NULL);
+		test(*(char*)machine_msg_get_data(msg) == 'a' + i);
+		machine_msg_free(msg);
+	}
+
+	/* notify */
+	rc = machine_pollgroup_wait(poll, io_ready, 2, UINT32_MAX);
+	test(rc == 1);
+	test(io_ready[0] == notify);
+
+	machine_msg_t *msg;
+	msg = machine_read(notify, sizeof(uint64_t), UINT32_MAX);
+	test(msg != NULL);
+	machine_msg_free(msg);
+
+	rc = machine_pollgroup_wait(poll, io_ready, 2, 0);
+	test(rc == -1);
+	test(machine_errno() == ETIMEDOUT);
+
+	/* eof */
+	rc = machine_pollgroup_wait(poll, io_ready, 2, UINT32_MAX);
+	test(rc == 1);
+	test(io_ready[0] == client);
+	msg = machine_read(client, 128, UINT32_MAX);
+	test(msg == NULL);
+
+	rc = machine_pollgroup_del(poll, client);
+	test(rc == 0);
+	rc = machine_pollgroup_del(poll, client);
+	test(rc == -1);
+
+	rc = machine_close(client);
+	test(rc == 0);
+	machine_io_free(client);
+
+	machine_pollgroup_free(poll);
+
+	rc = machine_close(server);
+	test(rc == 0);
+	machine_io_free(server);
+}
+
+static void
+client(void *arg)
+{
+	(void)arg;
+	machine_io_t *client = machine_io_create();
+	test(client != NULL);
+
+	struct sockaddr_in sa;
+	sa.sin_family = AF_INET;
+	sa.sin_addr.s_addr = inet_addr("127.0.0.1");
+	sa.sin_port = htons(7778);
+	int rc;
+	rc = machine_connect(client, (struct sockaddr*)&sa, UINT32_MAX);
+	test(rc == 0);
+
+	int i;
+	for (i = 0; i < 4; i++) {
+		machine_msg_t *msg;
+		msg = machine_msg_create(0);
+		test(msg != NULL);
+		rc = machine_msg_write(msg, NULL, 128);
+		test(rc == 0);
+		memset(machine_msg_get_data(msg), 'a' + i, 128);
+		rc = machine_write(client, msg);
+		test(rc == 0);
+		rc = machine_flush(client, UINT32_MAX);
+		test(rc == 0);
+		machine_sleep(10);
+	}
+
+	machine_msg_t *msg;
+	msg = machine_msg_create(sizeof(uint64_t));
+	test(msg != NULL);
+	*(uint64_t*)machine_msg_get_data(msg) = 1;
+	rc = machine_write(notify, msg);
+	test(rc == 0);
+	machine_sleep(10);
+
+	rc = machine_close(client);
+	test(rc == 0);
+	machine_io_free(client);
+}
+
+static void
+test_cs(void *arg)
+{
+	(void)arg;
+	notify = machine_io_create();
+	test(notify != NULL);
+	int rc;
+	rc = machine_eventfd(notify);
+	test(rc == 0);
+	rc = machine_io_attach(notify);
+	test(rc == 0);
+
+	int64_t server_id;
+	server_id = machine_coroutine_create(server, NULL);
+	test(server_id != -1);
+
+	int64_t client_id;
+	client_id = machine_coroutine_create(client, NULL);
+	test(client_id != -1);
+
+	/* server finishes after client eof */
+	rc = machine_join(server_id);
+	test(rc == 0);
+
+	machine_close(notify);
+	machine_io_free(notify);
+	notify = NULL;
+}
+
+#define TEST_STREAM_SIZE (3 * 8192)
+
+static void
+server_stream(void *arg)
+{
+	(void)arg;
+	machine_io_t *server = machine_io_create();
+	test(server != NULL);
+
+	struct sockaddr_in sa;
+	sa.sin_family = AF_INET;
+	sa.sin_addr.s_addr = inet_addr("127.0.0.1");
+	sa.sin_port = htons(7779);
+	int rc;
+	rc = machine_bind(server, (struct sockaddr*)&sa);
+	test(rc == 0);
+
+	machine_io_t *client;
+	rc = machine_accept(server, &client, 16, 1, UINT32_MAX);
+	test(rc == 0);
+
+	rc = machine_set_readahead(client, 8192);
+	test(rc == 0);
+
+	machine_pollgroup_t *poll;
+	poll = machine_pollgroup_create();
+	test(poll != NULL);
+	rc = machine_pollgroup_add(poll, client);
+	test(rc == 0);
+
+	/* let the readahead buffer fill up exactly */
+	machine_sleep(50);
+
+	/* consume buffered data only, io has to be polled again
+	 * once the buffer is drained */
+	int total = 0;
+	while (total < TEST_STREAM_SIZE) {
+		machine_io_t *io_ready[1];
+		rc = machine_pollgroup_wait(poll, io_ready, 1, 1000);
+		test(rc == 1);
+		test(io_ready[0] == client);
+
+		machine_msg_t *msg;
+		msg = machine_read(client, 128, UINT32_MAX);
+		test(msg != NULL);
+		test(*(char*)machine_msg_get_data(msg) == 'a' + total / 8192);
+		machine_msg_free(msg);
+		total += 128;
+	}
+
+	machine_pollgroup_free(poll);
+
+	rc = machine_close(client);
+	test(rc == 0);
+	machine_io_free(client);
+
+	rc = machine_close(server);
+	test(rc == 0);
+	machine_io_free(server);
+}
+
+static void
+client_stream(void *arg)
+{
+	(void)arg;
+	machine_io_t *client = machine_io_create();
+	test(client != NULL);
+
+	struct sockaddr_in sa;
+	sa.sin_family = AF_INET;
+	sa.sin_addr.s_addr = inet_addr("127.0.0.1");
+	sa.sin_port = htons(7779);
+	int rc;
+	rc = machine_connect(client, (struct sockaddr*)&sa, UINT32_MAX);
+	test(rc == 0);
+
+	machine_msg_t *msg;
+	msg = machine_msg_create(0);
+	test(msg != NULL);
+	rc = machine_msg_write(msg, NULL, TEST_STREAM_SIZE);
+	test(rc == 0);
+	char *data = machine_msg_get_data(msg);
+	int i;
+	for (i = 0; i < TEST_STREAM_SIZE / 8192; i++)
+		memset(data + i * 8192, 'a' + i, 8192);
+	rc = machine_write(client, msg);
+	test(rc == 0);
+	rc = machine_flush(client, UINT32_MAX);
+	test(rc == 0);
+
+	/* keep connection open until everything is read */
+	machine_sleep(500);
+
+	rc = machine_close(client);
+	test(rc == 0);
+	machine_io_free(client);
+}
+
+static void
+test_stream(void *arg)
+{
+	(void)arg;
+	int64_t server_id;
+	server_id = machine_coroutine_create(server_stream, NULL);
+	test(server_id != -1);
+
+	int64_t client_id;
+	client_id = machine_coroutine_create(client_stream, NULL);
+	test(client_id != -1);
+
+	int rc;
+	rc = machine_join(server_id);
+	test(rc == 0);
+	rc = machine_join(client_id);
+	test(rc == 0);
+}
+
+void
+machinarium_test_pollgroup(void)
+{
+	machinarium_init();
+
+	int id;
+	id = machine_create("test", test_cs, NULL);
+	test(id != -1);
+
+	int rc;
+	rc = machine_wait(id);
+	test(rc != -1);
+
+	/* readahead buffer filled up exactly */
+	id = machine_create("test", test_stream, NULL);
+	test(id != -1);
+
+	rc = machine_wait(id);
+	test(rc != -1);
+
+	machinarium_free();
+}
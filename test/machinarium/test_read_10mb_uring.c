@@ -0,0 +1,121 @@
+
+#include <machinarium.h>
+#include <odyssey_test.h>
+
+#include <string.h>
+#include <arpa/inet.h>
+
+static void
+server(void *arg)
+{
+	(void)arg;
+	machine_io_t *server = machine_io_create();
+	test(server != NULL);
+
+	struct sockaddr_in sa;
+	sa.sin_family = AF_INET;
+	sa.sin_addr.s_addr = inet_addr("127.0.0.1");
+	sa.sin_port = htons(7778);
+	int rc;
+	rc = machine_bind(server, (struct sockaddr*)&sa);
+	test(rc == 0);
+
+	machine_io_t *client;
+	rc = machine_accept(server, &client, 16, 1, UINT32_MAX);
+	test(rc == 0);
+
+	machine_msg_t *msg;
+	msg = machine_msg_create(0);
+	test(msg != NULL);
+	rc = machine_msg_write(msg, NULL, 10 * 1024 * 1024);
+	test(rc == 0);
+	memset(machine_msg_get_data(msg), 'x', 10 * 1024 * 1024);
+
+	rc = machine_write(client, msg);
+	test(rc == 0);
+
+	rc = machine_flush(client, UINT32_MAX);
+	test(rc == 0);
+
+	rc = machine_close(client);
+	test(rc == 0);
+	machine_io_free(client);
+
+	rc = machine_close(server);
+	test(rc == 0);
+	machine_io_free(server);
+}
+
+static void
+client(void *arg)
+{
+	(void)arg;
+	machine_io_t *client = machine_io_create();
+	test(client != NULL);
+
+	struct sockaddr_in sa;
+	sa.sin_family = AF_INET;
+	sa.sin_addr.s_addr = inet_addr("127.0.0.1");
+	sa.sin_port = htons(7778);
+	int rc;
+	rc = machine_connect(client, (struct sockaddr*)&sa, UINT32_MAX);
+	test(rc == 0);
+
+	machine_msg_t *msg;
+	msg = machine_read(client, 10 * 1024 * 1024, UINT32_MAX);
+	test(msg != NULL);
+
+	char *buf_cmp = malloc(10 * 1024 * 1024);
+	test(buf_cmp != NULL);
+	memset(buf_cmp, 'x', 10 * 1024 * 1024);
+	test(memcmp(buf_cmp, machine_msg_get_data(msg), 10 * 1024 * 1024) == 0 );
+	free(buf_cmp);
+
+	machine_msg_free(msg);
+
+	rc = machine_close(client);
+	test(rc == 0);
+	machine_io_free(client);
+}
+
+static int uring_skipped = 0;
+
+static void
+test_cs(void *arg)
+{
+	(void)arg;
+	/* epoll is used, if io_uring is not supported by the kernel */
+	char *poll = machine_poll();
+	test(strcmp(poll, "io_uring") == 0 || strcmp(poll, "epoll") == 0);
+	uring_skipped = strcmp(poll, "io_uring") != 0;
+
+	int rc;
+	rc = machine_coroutine_create(server, NULL);
+	test(rc != -1);
+
+	rc = machine_coroutine_create(client, NULL);
+	test(rc != -1);
+}
+
+void
+machinarium_test_read_10mb_uring(void)
+{
+	machinarium_set_poll("io_uring");
+	machinarium_init();
+
+	int id;
+	id = machine_create("test", test_cs, NULL);
+	test(id != -1);
+
+	int rc;
+	rc = machine_wait(id);
+	test(rc != -1);
+
+	machinarium_free();
+	machinarium_set_poll(NULL);
+
+	if (uring_skipped) {
+		printf("[io_uring is not supported, tested with epoll] ");
+		fflush(NULL);
+	}
+}
@@ -0,0 +1,163 @@
+
+#include <machinarium.h>
+#include <odyssey_test.h>
+
+#include <string.h>
+#include <arpa/inet.h>
+
+#define PACKETS 1000
+
+static inline int
+packet_size(int i)
+{
+	return 1 + (i * 37) % 300;
+}
+
+static void
+server(void *arg)
+{
+	(void)arg;
+	machine_io_t *server = machine_io_create();
+	test(server != NULL);
+
+	struct sockaddr_in sa;
+	sa.sin_family = AF_INET;
+	sa.sin_addr.s_addr = inet_addr("127.0.0.1");
+	sa.sin_port = htons(7778);
+	int rc;
+	rc = machine_bind(server, (struct sockaddr*)&sa);
+	test(rc == 0);
+
+	machine_io_t *client;
+	rc = machine_accept(server, &client, 16, 1, UINT32_MAX);
+	test(rc == 0);
+
+	int i;
+	for (i = 0; i < PACKETS; i++)
+	{
+		uint32_t size = packet_size(i);
+		machine_msg_t *msg;
+		msg = machine_msg_create(0);
+		test(msg != NULL);
+		rc = machine_msg_write(msg, &size, sizeof(size));
+		test(rc == 0);
+		rc = machine_msg_write(msg, NULL, size);
+		test(rc == 0);
+		memset((char*)machine_msg_get_data(msg) + sizeof(size), i & 0xff, size);
+		rc = machine_write(client, msg);
+		test(rc == 0);
+		if ((i % 100) == 0) {
+			rc = machine_flush(client, UINT32_MAX);
+			test(rc == 0);
+		}
+	}
+	rc = machine_flush(client, UINT32_MAX);
+	test(rc == 0);
+
+	/* wait for client to finish */
+	machine_msg_t *msg;
+	msg = machine_read(client, sizeof(uint32_t), UINT32_MAX);
+	test(msg == NULL);
+
+	rc = machine_close(client);
+	test(rc == 0);
+	machine_io_free(client);
+
+	rc = machine_close(server);
+	test(rc == 0);
+	machine_io_free(server);
+}
+
+static inline void
+packet_validate(machine_msg_t *msg, int i, int extra)
+{
+	uint32_t size = packet_size(i);
+	test(machine_msg_get_size(msg) == (int)(sizeof(size) + size + extra));
+	char *data = machine_msg_get_data(msg);
+	test(memcmp(data, &size, sizeof(size)) == 0);
+	uint32_t j;
+	for (j = 0; j < size; j++)
+		test(data[sizeof(size) + j] == (char)(i & 0xff));
+	if (extra)
+		test(data[sizeof(size) + size] == 'x');
+}
+
+static void
+client(void *arg)
+{
+	(void)arg;
+	machine_io_t *client = machine_io_create();
+	test(client != NULL);
+
+	/* small readahead makes packets cross buffer boundaries */
+	int rc;
+	rc = machine_set_readahead(client, 1024);
+	test(rc == 0);
+
+	struct sockaddr_in sa;
+	sa.sin_family = AF_INET;
+	sa.sin_addr.s_addr = inet_addr("127.0.0.1");
+	sa.sin_port = htons(7778);
+	rc = machine_connect(client, (struct sockaddr*)&sa, UINT32_MAX);
+	test(rc == 0);
+
+	/* keep all messages referenced until the end */
+	machine_msg_t *packets[PACKETS];
+	int i;
+	for (i = 0; i < PACKETS; i++)
+	{
+		machine_msg_t *msg;
+		msg = machine_read(client, sizeof(uint32_t), UINT32_MAX);
+		test(msg != NULL);
+		uint32_t size;
+		memcpy(&size, machine_msg_get_data(msg), sizeof(size));
+		test(size == (uint32_t)packet_size(i));
+		rc = machine_read_to(client, msg, size, UINT32_MAX);
+		test(rc == 0);
+		packet_validate(msg, i, 0);
+
+		/* modification must not affect other messages */
+		if ((i % 10) == 0) {
+			rc = machine_msg_write(msg, "x", 1);
+			test(rc == 0);
+		}
+		packets[i] = msg;
+	}
+
+	for (i = 0; i < PACKETS; i++) {
+		packet_validate(packets[i], i, (i % 10) == 0);
+		machine_msg_free(packets[i]);
+	}
+
+	rc = machine_close(client);
+	test(rc == 0);
+	machine_io_free(client);
+}
+
+static void
+test_cs(void *arg)
+{
+	(void)arg;
+	int rc;
+	rc = machine_coroutine_create(server, NULL);
+	test(rc != -1);
+
+	rc = machine_coroutine_create(client, NULL);
+	test(rc != -1);
+}
+
+void
+machinarium_test_read_slice(void)
+{
+	machinarium_init();
+
+	int id;
+	id = machine_create("test", test_cs, NULL);
+	test(id != -1);
+
+	int rc;
+	rc = machine_wait(id);
+	test(rc != -1);
+
+	machinarium_free();
+}
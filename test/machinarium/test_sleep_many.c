@@ -0,0 +1,80 @@
+
+#include <machinarium.h>
+#include <odyssey_test.h>
+
+/*
+ * Start many sleeping coroutines with random timeouts, cancel
+ * every other one and check that the rest wake up in order
+ * of their deadlines (see benchmark_timer for timing).
+*/
+
+#define TEST_COROUTINES 10000
+
+static int64_t  ids[TEST_COROUTINES];
+static int      woken = 0;
+static int      cancelled = 0;
+static uint64_t last_deadline = 0;
+
+static void
+test_sleeper(void *arg)
+{
+	uint32_t interval = (uintptr_t)arg;
+	uint64_t deadline = machine_time_ms() + interval;
+	machine_sleep(interval);
+	if (machine_cancelled()) {
+		cancelled++;
+		return;
+	}
+	test(machine_time_ms() >= deadline);
+	test(deadline >= last_deadline);
+	last_deadline = deadline;
+	woken++;
+}
+
+static void
+test_runner(void *arg)
+{
+	(void)arg;
+	unsigned int seed = 7;
+
+	int i;
+	for (i = 0; i < TEST_COROUTINES; i++) {
+		uintptr_t interval = 1 + rand_r(&seed) % 100;
+		ids[i] = machine_coroutine_create(test_sleeper, (void*)interval);
+		test(ids[i] != -1);
+	}
+
+	/* start timers */
+	machine_sleep(0);
+
+	/* cancel timers in the middle of the heap */
+	int rc;
+	for (i = 0; i < TEST_COROUTINES; i += 2) {
+		rc = machine_cancel(ids[i]);
+		test(rc == 0);
+	}
+
+	for (i = 0; i < TEST_COROUTINES; i++)
+		machine_join(ids[i]);
+
+	test(woken == TEST_COROUTINES / 2);
+	test(cancelled == TEST_COROUTINES / 2);
+
+	machine_stop();
+}
+
+void
+machinarium_test_sleep_many(void)
+{
+	machinarium_init();
+
+	int id;
+	id = machine_create("test", test_runner, NULL);
+	test(id != -1);
+
+	int rc;
+	rc = machine_wait(id);
+	test(rc != -1);
+
+	machinarium_free();
+}
@@ -0,0 +1,174 @@
+
+#include <machinarium.h>
+#include <odyssey_test.h>
+
+#include <string.h>
+#include <arpa/inet.h>
+
+#define TEST_SIZE (10 * 1024 * 1024)
+
+static void
+test_fill(char *data, int offset, int size)
+{
+	int i;
+	for (i = 0; i < size; i++)
+		data[i] = (offset + i) % 251;
+}
+
+static void
+source(void *arg)
+{
+	(void)arg;
+	machine_io_t *io = machine_io_create();
+	test(io != NULL);
+
+	struct sockaddr_in sa;
+	sa.sin_family = AF_INET;
+	sa.sin_addr.s_addr = inet_addr("127.0.0.1");
+	sa.sin_port = htons(7778);
+	int rc;
+	rc = machine_connect(io, (struct sockaddr*)&sa, UINT32_MAX);
+	test(rc == 0);
+
+	machine_msg_t *msg;
+	msg = machine_msg_create(TEST_SIZE);
+	test(msg != NULL);
+	test_fill(machine_msg_get_data(msg), 0, TEST_SIZE);
+	rc = machine_write(io, msg);
+	test(rc == 0);
+	rc = machine_flush(io, UINT32_MAX);
+	test(rc == 0);
+
+	rc = machine_close(io);
+	test(rc == 0);
+	machine_io_free(io);
+}
+
+static void
+sink(void *arg)
+{
+	(void)arg;
+	machine_io_t *server = machine_io_create();
+	test(server != NULL);
+
+	struct sockaddr_in sa;
+	sa.sin_family = AF_INET;
+	sa.sin_addr.s_addr = inet_addr("127.0.0.1");
+	sa.sin_port = htons(7779);
+	int rc;
+	rc = machine_bind(server, (struct sockaddr*)&sa);
+	test(rc == 0);
+
+	machine_io_t *io;
+	rc = machine_accept(server, &io, 16, 1, UINT32_MAX);
+	test(rc == 0);
+
+	machine_msg_t *msg;
+	msg = machine_read(io, TEST_SIZE, UINT32_MAX);
+	test(msg != NULL);
+
+	char *buf_cmp = malloc(TEST_SIZE);
+	test(buf_cmp != NULL);
+	test_fill(buf_cmp, 0, TEST_SIZE);
+	test(memcmp(buf_cmp, machine_msg_get_data(msg), TEST_SIZE) == 0);
+	free(buf_cmp);
+	machine_msg_free(msg);
+
+	rc = machine_close(io);
+	test(rc == 0);
+	machine_io_free(io);
+
+	rc = machine_close(server);
+	test(rc == 0);
+	machine_io_free(server);
+}
+
+static void
+proxy(void *arg)
+{
+	(void)arg;
+	machine_io_t *server = machine_io_create();
+	test(server != NULL);
+
+	struct sockaddr_in sa;
+	sa.sin_family = AF_INET;
+	sa.sin_addr.s_addr = inet_addr("127.0.0.1");
+	sa.sin_port = htons(7778);
+	int rc;
+	rc = machine_bind(server, (struct sockaddr*)&sa);
+	test(rc == 0);
+
+	int64_t id;
+	id = machine_coroutine_create(source, NULL);
+	test(id != -1);
+
+	machine_io_t *src;
+	rc = machine_accept(server, &src, 16, 1, UINT32_MAX);
+	test(rc == 0);
+	rc = machine_set_readahead(src, 8192);
+	test(rc == 0);
+
+	machine_io_t *dst = machine_io_create();
+	test(dst != NULL);
+	sa.sin_port = htons(7779);
+	rc = machine_connect(dst, (struct sockaddr*)&sa, UINT32_MAX);
+	test(rc == 0);
+
+	/* queue first chunk and leave data in readahead buffer */
+	machine_msg_t *msg;
+	msg = machine_read(src, 100, UINT32_MAX);
+	test(msg != NULL);
+	rc = machine_write(dst, msg);
+	test(rc == 0);
+
+	rc = machine_splice(dst, src, TEST_SIZE - 100, UINT32_MAX);
+	test(rc == 0);
+
+	rc = machine_read_pending(src);
+	test(rc == 0);
+
+	rc = machine_close(dst);
+	test(rc == 0);
+	machine_io_free(dst);
+
+	rc = machine_close(src);
+	test(rc == 0);
+	machine_io_free(src);
+
+	rc = machine_close(server);
+	test(rc == 0);
+	machine_io_free(server);
+}
+
+static void
+test_cs(void *arg)
+{
+	(void)arg;
+	int64_t sink_id;
+	sink_id = machine_coroutine_create(sink, NULL);
+	test(sink_id != -1);
+
+	int64_t proxy_id;
+	proxy_id = machine_coroutine_create(proxy, NULL);
+	test(proxy_id != -1);
+
+	int rc;
+	rc = machine_join(sink_id);
+	test(rc == 0);
+}
+
+void
+machinarium_test_splice(void)
+{
+	machinarium_init();
+
+	int id;
+	id = machine_create("test", test_cs, NULL);
+	test(id != -1);
+
+	int rc;
+	rc = machine_wait(id);
+	test(rc != -1);
+
+	machinarium_free();
+}
@@ -0,0 +1,112 @@
+
+#include <machinarium.h>
+#include <odyssey_test.h>
+
+#define TEST_COROUTINES 300
+#define TEST_STACK_USE  (8 * 1024)
+
+static int done = 0;
+
+static __attribute__((noinline)) void
+test_deep(void)
+{
+	char buf[TEST_STACK_USE];
+	volatile char *ptr = buf;
+	size_t i;
+	for (i = 0; i < sizeof(buf); i++)
+		ptr[i] = 1;
+}
+
+static void
+test_coroutine(void *arg)
+{
+	if (arg)
+		test_deep();
+	machine_sleep(0);
+	done++;
+}
+
+static void
+test_round(int deep_every)
+{
+	done = 0;
+	int i;
+	for (i = 0; i < TEST_COROUTINES; i++) {
+		void *deep = (deep_every && i % deep_every == 0) ? &done : NULL;
+		int64_t id;
+		id = machine_coroutine_create(test_coroutine, deep);
+		test(id != -1);
+	}
+	while (done < TEST_COROUTINES)
+		machine_sleep(0);
+}
+
+static void
+test_arena(void *arg)
+{
+	(void)arg;
+	uint64_t reserved, used_avg, used_p99, used_max, used_count;
+
+	/* only a few coroutines go deep */
+	test_round(50);
+	machine_stack_stat(&reserved, &used_avg, &used_p99, &used_max,
+	                   &used_count);
+	test(reserved >= TEST_COROUTINES * 8 * 4096ULL);
+	test(used_count == TEST_COROUTINES);
+	test(used_max >= TEST_STACK_USE);
+	test(used_max < 8 * 4096ULL);
+	test(used_avg < TEST_STACK_USE);
+	test(used_p99 <= used_max);
+
+	/* cached and released slots are reused without new reservations,
+	 * shallow coroutines on slots used by deep ones are measured
+	 * on their own */
+	uint64_t reserved_prev = reserved;
+	uint64_t used_sum_prev = used_avg * used_count;
+	test_round(0);
+	machine_stack_stat(&reserved, &used_avg, &used_p99, &used_max,
+	                   &used_count);
+	test(reserved == reserved_prev);
+	test(used_count == TEST_COROUTINES * 2);
+	test(used_max >= TEST_STACK_USE);
+	uint64_t used_avg_round;
+	used_avg_round = (used_avg * used_count - used_sum_prev) / TEST_COROUTINES;
+	test(used_avg_round < 4096);
+}
+
+static void
+test_run(int hugepages, int guard)
+{
+	machinarium_set_stack_size(8);
+	machinarium_set_stack_hugepages(hugepages);
+	machinarium_set_stack_guard(guard);
+	machinarium_set_coroutine_cache_size(TEST_COROUTINES / 2);
+	machinarium_init();
+
+	int id;
+	id = machine_create("test", test_arena, NULL);
+	test(id != -1);
+
+	int rc;
+	rc = machine_wait(id);
+	test(rc != -1);
+
+	machinarium_free();
+	machinarium_set_stack_size(0);
+	machinarium_set_stack_hugepages(0);
+	machinarium_set_stack_guard(1);
+	machinarium_set_coroutine_cache_size(0);
+}
+
+void
+machinarium_test_stack_arena(void)
+{
+	test_run(0, 1);
+	test_run(0, 0);
+	test_run(1, 0);
+
+	/* huge pages can not be combined with guard pages */
+	machinarium_set_stack_hugepages(1);
+	test(machinarium_init() == -1);
+	machinarium_set_stack_hugepages(0);
+}
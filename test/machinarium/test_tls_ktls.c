@@ -0,0 +1,223 @@
+
+#include <machinarium.h>
+#include <odyssey_test.h>
+
+#include <string.h>
+#include <arpa/inet.h>
+
+#define PACKETS 200
+
+static int
+ktls_available(void)
+{
+	/* tls ulp is listed once the kernel module is loaded */
+	FILE *file = fopen("/proc/sys/net/ipv4/tcp_available_ulp", "r");
+	if (file == NULL)
+		return 0;
+	char ulp[256];
+	int available = 0;
+	while (fscanf(file, "%255s", ulp) == 1) {
+		if (strcmp(ulp, "tls") == 0)
+			available = 1;
+	}
+	fclose(file);
+	return available;
+}
+
+static int ktls_skipped = 0;
+
+static void
+ktls_check(machine_io_t *io)
+{
+	/* connections are switched to kernel tls, unless it is not
+	 * supported by the build or the kernel */
+	int rc;
+	rc = machine_get_ktls(io);
+	if (rc == -1 || ! ktls_available()) {
+		test(rc != 1);
+		ktls_skipped = 1;
+		return;
+	}
+	test(rc == 1);
+}
+
+static inline int
+packet_size(int i)
+{
+	return 1 + (i * 997) % 20000;
+}
+
+static machine_tls_t*
+tls_create(char *cert, char *key)
+{
+	machine_tls_t *tls;
+	tls = machine_tls_create();
+	test(tls != NULL);
+	int rc;
+	rc = machine_tls_set_verify(tls, "none");
+	test(rc == 0);
+	rc = machine_tls_set_ca_file(tls, "./machinarium/ca.crt");
+	test(rc == 0);
+	rc = machine_tls_set_cert_file(tls, cert);
+	test(rc == 0);
+	rc = machine_tls_set_key_file(tls, key);
+	test(rc == 0);
+	rc = machine_tls_set_ktls(tls, 1);
+	test(rc == 0);
+	return tls;
+}
+
+static void
+server(void *arg)
+{
+	(void)arg;
+	machine_io_t *server = machine_io_create();
+	test(server != NULL);
+
+	struct sockaddr_in sa;
+	sa.sin_family = AF_INET;
+	sa.sin_addr.s_addr = inet_addr("127.0.0.1");
+	sa.sin_port = htons(7778);
+	int rc;
+	rc = machine_bind(server, (struct sockaddr*)&sa);
+	test(rc == 0);
+
+	machine_io_t *client = NULL;
+	rc = machine_accept(server, &client, 16, 1, UINT32_MAX);
+	test(rc == 0);
+	test(client != NULL);
+
+	rc = machine_set_readahead(client, 8192);
+	test(rc == 0);
+
+	machine_tls_t *tls;
+	tls = tls_create("./machinarium/server.crt", "./machinarium/server.key");
+	rc = machine_set_tls(client, tls);
+	if (rc == -1) {
+		printf("%s\n", machine_error(client));
+		test(rc == 0);
+	}
+	ktls_check(client);
+
+	/* echo packets */
+	int i;
+	for (i = 0; i < PACKETS; i++) {
+		machine_msg_t *msg;
+		msg = machine_read(client, sizeof(uint32_t), UINT32_MAX);
+		test(msg != NULL);
+		uint32_t size;
+		memcpy(&size, machine_msg_get_data(msg), sizeof(size));
+		test(size == (uint32_t)packet_size(i));
+		rc = machine_read_to(client, msg, size, UINT32_MAX);
+		test(rc == 0);
+		rc = machine_write(client, msg);
+		test(rc == 0);
+		rc = machine_flush(client, UINT32_MAX);
+		test(rc == 0);
+	}
+
+	rc = machine_close(client);
+	test(rc == 0);
+	machine_io_free(client);
+
+	rc = machine_close(server);
+	test(rc == 0);
+	machine_io_free(server);
+
+	machine_tls_free(tls);
+}
+
+static void
+client(void *arg)
+{
+	(void)arg;
+	machine_io_t *client = machine_io_create();
+	test(client != NULL);
+
+	struct sockaddr_in sa;
+	sa.sin_family = AF_INET;
+	sa.sin_addr.s_addr = inet_addr("127.0.0.1");
+	sa.sin_port = htons(7778);
+	int rc;
+	rc = machine_connect(client, (struct sockaddr*)&sa, UINT32_MAX);
+	test(rc == 0);
+
+	machine_tls_t *tls;
+	tls = tls_create("./machinarium/client.crt", "./machinarium/client.key");
+	rc = machine_set_tls(client, tls);
+	if (rc == -1) {
+		printf("%s\n", machine_error(client));
+		test(rc == 0);
+	}
+	ktls_check(client);
+
+	int i;
+	for (i = 0; i < PACKETS; i++) {
+		uint32_t size = packet_size(i);
+		machine_msg_t *msg;
+		msg = machine_msg_create(0);
+		test(msg != NULL);
+		rc = machine_msg_write(msg, &size, sizeof(size));
+		test(rc == 0);
+		rc = machine_msg_write(msg, NULL, size);
+		test(rc == 0);
+		memset((char*)machine_msg_get_data(msg) + sizeof(size), i & 0xff, size);
+		rc = machine_write(client, msg);
+		test(rc == 0);
+		rc = machine_flush(client, UINT32_MAX);
+		test(rc == 0);
+
+		msg = machine_read(client, sizeof(size) + size, UINT32_MAX);
+		test(msg != NULL);
+		char *data = machine_msg_get_data(msg);
+		test(memcmp(data, &size, sizeof(size)) == 0);
+		uint32_t j;
+		for (j = 0; j < size; j++)
+			test(data[sizeof(size) + j] == (char)(i & 0xff));
+		machine_msg_free(msg);
+	}
+
+	machine_msg_t *msg;
+	msg = machine_read(client, 1, UINT32_MAX);
+	/* eof */
+	test(msg == NULL);
+
+	rc = machine_close(client);
+	test(rc == 0);
+	machine_io_free(client);
+
+	machine_tls_free(tls);
+}
+
+static void
+test_cs(void *arg)
+{
+	(void)arg;
+	int rc;
+	rc = machine_coroutine_create(server, NULL);
+	test(rc != -1);
+
+	rc = machine_coroutine_create(client, NULL);
+	test(rc != -1);
+}
+
+void
+machinarium_test_tls_ktls(void)
+{
+	machinarium_init();
+
+	int id;
+	id = machine_create("test", test_cs, NULL);
+	test(id != -1);
+
+	int rc;
+	rc = machine_wait(id);
+	test(rc != -1);
+
+	machinarium_free();
+
+	if (ktls_skipped) {
+		printf("[kernel tls is not available, offload skipped] ");
+		fflush(NULL);
+	}
+}
@@ -0,0 +1,182 @@
+
+#include <machinarium.h>
+#include <odyssey_test.h>
+
+#include <string.h>
+#include <arpa/inet.h>
+
+#define CONNECTIONS 4
+
+static machine_tls_t *server_tls;
+static machine_tls_t *client_tls;
+static int done;
+
+static machine_tls_t*
+tls_create(char *cert, char *key)
+{
+	machine_tls_t *tls;
+	tls = machine_tls_create();
+	test(tls != NULL);
+	int rc;
+	rc = machine_tls_set_verify(tls, "none");
+	test(rc == 0);
+	rc = machine_tls_set_ca_file(tls, "./machinarium/ca.crt");
+	test(rc == 0);
+	rc = machine_tls_set_cert_file(tls, cert);
+	test(rc == 0);
+	rc = machine_tls_set_key_file(tls, key);
+	test(rc == 0);
+	return tls;
+}
+
+static void
+server(void *arg)
+{
+	(void)arg;
+	machine_io_t *server = machine_io_create();
+	test(server != NULL);
+
+	struct sockaddr_in sa;
+	sa.sin_family = AF_INET;
+	sa.sin_addr.s_addr = inet_addr("127.0.0.1");
+	sa.sin_port = htons(7778);
+	int rc;
+	rc = machine_bind(server, (struct sockaddr*)&sa);
+	test(rc == 0);
+
+	int i;
+	for (i = 0; i < CONNECTIONS; i++) {
+		machine_io_t *client = NULL;
+		rc = machine_accept(server, &client, 16, 1, UINT32_MAX);
+		test(rc == 0);
+		test(client != NULL);
+
+		rc = machine_set_tls(client, server_tls);
+		if (rc == -1) {
+			printf("%s\n", machine_error(client));
+			test(rc == 0);
+		}
+
+		machine_msg_t *msg;
+		msg = machine_read(client, 4, UINT32_MAX);
+		test(msg != NULL);
+		test(memcmp(machine_msg_get_data(msg), "ping", 4) == 0);
+		machine_msg_free(msg);
+
+		msg = machine_msg_create(0);
+		test(msg != NULL);
+		rc = machine_msg_write(msg, "pong", 4);
+		test(rc == 0);
+		rc = machine_write(client, msg);
+		test(rc == 0);
+		rc = machine_flush(client, UINT32_MAX);
+		test(rc == 0);
+
+		/* wait for client to close connection */
+		msg = machine_read(client, 1, UINT32_MAX);
+		test(msg == NULL);
+
+		rc = machine_close(client);
+		test(rc == 0);
+		machine_io_free(client);
+	}
+
+	rc = machine_close(server);
+	test(rc == 0);
+	machine_io_free(server);
+	done++;
+}
+
+static void
+client(void *arg)
+{
+	(void)arg;
+	struct sockaddr_in sa;
+	sa.sin_family = AF_INET;
+	sa.sin_addr.s_addr = inet_addr("127.0.0.1");
+	sa.sin_port = htons(7778);
+
+	int i;
+	for (i = 0; i < CONNECTIONS; i++) {
+		machine_io_t *client = machine_io_create();
+		test(client != NULL);
+		int rc;
+		rc = machine_connect(client, (struct sockaddr*)&sa, UINT32_MAX);
+		test(rc == 0);
+
+		rc = machine_set_tls(client, client_tls);
+		if (rc == -1) {
+			printf("%s\n", machine_error(client));
+			test(rc == 0);
+		}
+
+		machine_msg_t *msg;
+		msg = machine_msg_create(0);
+		test(msg != NULL);
+		rc = machine_msg_write(msg, "ping", 4);
+		test(rc == 0);
+		rc = machine_write(client, msg);
+		test(rc == 0);
+		rc = machine_flush(client, UINT32_MAX);
+		test(rc == 0);
+
+		/* session tickets are received along with the reply */
+		msg = machine_read(client, 4, UINT32_MAX);
+		test(msg != NULL);
+		test(memcmp(machine_msg_get_data(msg), "pong", 4) == 0);
+		machine_msg_free(msg);
+
+		rc = machine_close(client);
+		test(rc == 0);
+		machine_io_free(client);
+	}
+	done++;
+}
+
+static void
+test_cs(void *arg)
+{
+	(void)arg;
+	server_tls = tls_create("./machinarium/server.crt", "./machinarium/server.key");
+	client_tls = tls_create("./machinarium/client.crt", "./machinarium/client.key");
+
+	int rc;
+	rc = machine_coroutine_create(server, NULL);
+	test(rc != -1);
+
+	rc = machine_coroutine_create(client, NULL);
+	test(rc != -1);
+
+	while (done < 2)
+		machine_sleep(0);
+
+	/* first connection does full handshake, the rest are resumed */
+	uint64_t handshakes;
+	uint64_t reused;
+	machine_tls_stat(client_tls, &handshakes, &reused);
+	test(handshakes == CONNECTIONS);
+	test(reused == CONNECTIONS - 1);
+
+	machine_tls_stat(server_tls, &handshakes, &reused);
+	test(handshakes == CONNECTIONS);
+	test(reused == CONNECTIONS - 1);
+
+	machine_tls_free(server_tls);
+	machine_tls_free(client_tls);
+}
+
+void
+machinarium_test_tls_session(void)
+{
+	machinarium_init();
+
+	int id;
+	id = machine_create("test", test_cs, NULL);
+	test(id != -1);
+
+	int rc;
+	rc = machine_wait(id);
+	test(rc != -1);
+
+	machinarium_free();
+}
@@ -0,0 +1,149 @@
+
+#include <machinarium.h>
+#include <odyssey_test.h>
+
+#include <string.h>
+#include <arpa/inet.h>
+
+#define PACKETS 1000
+
+static inline int
+packet_size(int i)
+{
+	/* mix small messages with large ones */
+	if ((i % 10) == 9)
+		return 2000 + i;
+	return 1 + (i * 37) % 100;
+}
+
+static void
+server(void *arg)
+{
+	(void)arg;
+	machine_io_t *server = machine_io_create();
+	test(server != NULL);
+
+	struct sockaddr_in sa;
+	sa.sin_family = AF_INET;
+	sa.sin_addr.s_addr = inet_addr("127.0.0.1");
+	sa.sin_port = htons(7778);
+	int rc;
+	rc = machine_bind(server, (struct sockaddr*)&sa);
+	test(rc == 0);
+
+	machine_io_t *client;
+	rc = machine_accept(server, &client, 16, 1, UINT32_MAX);
+	test(rc == 0);
+
+	int i;
+	for (i = 0; i < PACKETS; i++)
+	{
+		uint32_t size = packet_size(i);
+		machine_msg_t *msg;
+		msg = machine_msg_create(0);
+		test(msg != NULL);
+		rc = machine_msg_write(msg, &size, sizeof(size));
+		test(rc == 0);
+		rc = machine_msg_write(msg, NULL, size);
+		test(rc == 0);
+		memset((char*)machine_msg_get_data(msg) + sizeof(size), i & 0xff, size);
+		rc = machine_write(client, msg);
+		test(rc == 0);
+
+		/* small messages are coalesced into a single write
+		 * queue entry, large message is queued as is */
+		if ((i % 100) == 8)
+			test(machine_get_write_queue_count(client) == 1);
+		if ((i % 100) == 9)
+			test(machine_get_write_queue_count(client) == 2);
+
+		if ((i % 10) == 9) {
+			rc = machine_flush(client, UINT32_MAX);
+			test(rc == 0);
+			test(machine_get_write_queue_count(client) == 0);
+		}
+	}
+	rc = machine_flush(client, UINT32_MAX);
+	test(rc == 0);
+
+	/* wait for client to finish */
+	machine_msg_t *msg;
+	msg = machine_read(client, sizeof(uint32_t), UINT32_MAX);
+	test(msg == NULL);
+
+	rc = machine_close(client);
+	test(rc == 0);
+	machine_io_free(client);
+
+	rc = machine_close(server);
+	test(rc == 0);
+	machine_io_free(server);
+}
+
+static void
+client(void *arg)
+{
+	(void)arg;
+	machine_io_t *client = machine_io_create();
+	test(client != NULL);
+
+	struct sockaddr_in sa;
+	sa.sin_family = AF_INET;
+	sa.sin_addr.s_addr = inet_addr("127.0.0.1");
+	sa.sin_port = htons(7778);
+	int rc;
+	rc = machine_connect(client, (struct sockaddr*)&sa, UINT32_MAX);
+	test(rc == 0);
+
+	int i;
+	for (i = 0; i < PACKETS; i++)
+	{
+		machine_msg_t *msg;
+		msg = machine_read(client, sizeof(uint32_t), UINT32_MAX);
+		test(msg != NULL);
+		uint32_t size;
+		memcpy(&size, machine_msg_get_data(msg), sizeof(size));
+		test(size == (uint32_t)packet_size(i));
+		machine_msg_free(msg);
+
+		msg = machine_read(client, size, UINT32_MAX);
+		test(msg != NULL);
+		char *data = machine_msg_get_data(msg);
+		uint32_t j;
+		for (j = 0; j < size; j++)
+			test(data[j] == (char)(i & 0xff));
+		machine_msg_free(msg);
+	}
+
+	rc = machine_close(client);
+	test(rc == 0);
+	machine_io_free(client);
+}
+
+static void
+test_cs(void *arg)
+{
+	(void)arg;
+	int rc;
+	rc = machine_coroutine_create(server, NULL);
+	test(rc != -1);
+
+	rc = machine_coroutine_create(client, NULL);
+	test(rc != -1);
+}
+
+void
+machinarium_test_write_stage(void)
+{
+	machinarium_init();
+
+	int id;
+	id = machine_create("test", test_cs, NULL);
+	test(id != -1);
+
+	int rc;
+	rc = machine_wait(id);
+	test(rc != -1);
+
+	machinarium_free();
+}
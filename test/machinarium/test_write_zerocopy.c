@@ -0,0 +1,300 @@
+
+#include <machinarium.h>
+#include <odyssey_test.h>
+
+#include <string.h>
+#include <arpa/inet.h>
+
+#define PACKETS 300
+
+static inline int
+packet_size(int i)
+{
+	/* mix zero-copy sized messages with regular ones */
+	if ((i % 3) == 0)
+		return 16384 + i * 13;
+	return 1 + (i * 37) % 4000;
+}
+
+static void
+server(void *arg)
+{
+	(void)arg;
+	machine_io_t *server = machine_io_create();
+	test(server != NULL);
+
+	struct sockaddr_in sa;
+	sa.sin_family = AF_INET;
+	sa.sin_addr.s_addr = inet_addr("127.0.0.1");
+	sa.sin_port = htons(7778);
+	int rc;
+	rc = machine_set_zerocopy(server, 16384);
+	test(rc == 0);
+	rc = machine_bind(server, (struct sockaddr*)&sa);
+	test(rc == 0);
+
+	machine_io_t *client;
+	rc = machine_accept(server, &client, 16, 1, UINT32_MAX);
+	test(rc == 0);
+
+	int i;
+	for (i = 0; i < PACKETS; i++)
+	{
+		uint32_t size = packet_size(i);
+		machine_msg_t *msg;
+		msg = machine_msg_create(0);
+		test(msg != NULL);
+		rc = machine_msg_write(msg, &size, sizeof(size));
+		test(rc == 0);
+		rc = machine_msg_write(msg, NULL, size);
+		test(rc == 0);
+		memset((char*)machine_msg_get_data(msg) + sizeof(size), i & 0xff, size);
+		rc = machine_write(client, msg);
+		test(rc == 0);
+		if (i == 0) {
+			/* completion of a single zero-copy send must be reaped
+			 * while the io has nothing else to write */
+			rc = machine_flush(client, UINT32_MAX);
+			test(rc == 0);
+			test(machine_get_zerocopy_queue_count(client) == 0);
+		}
+		if ((i % 10) == 9) {
+			rc = machine_flush(client, UINT32_MAX);
+			test(rc == 0);
+		}
+	}
+	rc = machine_flush(client, UINT32_MAX);
+	test(rc == 0);
+
+	/* wait for client to finish */
+	machine_msg_t *msg;
+	msg = machine_read(client, sizeof(uint32_t), UINT32_MAX);
+	test(msg == NULL);
+
+	rc = machine_close(client);
+	test(rc == 0);
+	machine_io_free(client);
+
+	rc = machine_close(server);
+	test(rc == 0);
+	machine_io_free(server);
+}
+
+static void
+client(void *arg)
+{
+	(void)arg;
+	machine_io_t *client = machine_io_create();
+	test(client != NULL);
+
+	struct sockaddr_in sa;
+	sa.sin_family = AF_INET;
+	sa.sin_addr.s_addr = inet_addr("127.0.0.1");
+	sa.sin_port = htons(7778);
+	int rc;
+	rc = machine_connect(client, (struct sockaddr*)&sa, UINT32_MAX);
+	test(rc == 0);
+
+	int i;
+	for (i = 0; i < PACKETS; i++)
+	{
+		machine_msg_t *msg;
+		msg = machine_read(client, sizeof(uint32_t), UINT32_MAX);
+		test(msg != NULL);
+		uint32_t size;
+		memcpy(&size, machine_msg_get_data(msg), sizeof(size));
+		test(size == (uint32_t)packet_size(i));
+		machine_msg_free(msg);
+
+		msg = machine_read(client, size, UINT32_MAX);
+		test(msg != NULL);
+		char *data = machine_msg_get_data(msg);
+		uint32_t j;
+		for (j = 0; j < size; j++)
+			test(data[j] == (char)(i & 0xff));
+		machine_msg_free(msg);
+	}
+
+	rc = machine_close(client);
+	test(rc == 0);
+	machine_io_free(client);
+}
+
+static void
+server_close(void *arg)
+{
+	(void)arg;
+	machine_io_t *server = machine_io_create();
+	test(server != NULL);
+
+	struct sockaddr_in sa;
+	sa.sin_family = AF_INET;
+	sa.sin_addr.s_addr = inet_addr("127.0.0.1");
+	sa.sin_port = htons(7778);
+	int rc;
+	rc = machine_set_zerocopy(server, 16384);
+	test(rc == 0);
+	rc = machine_bind(server, (struct sockaddr*)&sa);
+	test(rc == 0);
+
+	machine_io_t *client;
+	rc = machine_accept(server, &client, 16, 1, UINT32_MAX);
+	test(rc == 0);
+
+	int i;
+	for (i = 0; i < PACKETS; i += 3)
+	{
+		uint32_t size = packet_size(i);
+		machine_msg_t *msg;
+		msg = machine_msg_create(0);
+		test(msg != NULL);
+		rc = machine_msg_write(msg, &size, sizeof(size));
+		test(rc == 0);
+		rc = machine_msg_write(msg, NULL, size);
+		test(rc == 0);
+		memset((char*)machine_msg_get_data(msg) + sizeof(size), i & 0xff, size);
+		rc = machine_write(client, msg);
+		test(rc == 0);
+	}
+
+	/* flushed io is closed and freed right away, its messages
+	 * are not referenced by the kernel anymore */
+	rc = machine_flush(client, UINT32_MAX);
+	test(rc == 0);
+	test(machine_get_zerocopy_queue_count(client) == 0);
+	rc = machine_close(client);
+	test(rc == 0);
+	machine_io_free(client);
+
+	/* reuse released messages */
+	for (i = 0; i < PACKETS; i += 3)
+	{
+		machine_msg_t *msg;
+		msg = machine_msg_create(0);
+		test(msg != NULL);
+		rc = machine_msg_write(msg, NULL, sizeof(uint32_t) + packet_size(i));
+		test(rc == 0);
+		memset(machine_msg_get_data(msg), 0xff, machine_msg_get_size(msg));
+		machine_msg_free(msg);
+	}
+
+	rc = machine_close(server);
+	test(rc == 0);
+	machine_io_free(server);
+}
+
+static void
+client_close(void *arg)
+{
+	(void)arg;
+	machine_io_t *client = machine_io_create();
+	test(client != NULL);
+
+	struct sockaddr_in sa;
+	sa.sin_family = AF_INET;
+	sa.sin_addr.s_addr = inet_addr("127.0.0.1");
+	sa.sin_port = htons(7778);
+	int rc;
+	rc = machine_connect(client, (struct sockaddr*)&sa, UINT32_MAX);
+	test(rc == 0);
+
+	/* let the server close first */
+	machine_sleep(100);
+
+	int i;
+	for (i = 0; i < PACKETS; i += 3)
+	{
+		machine_msg_t *msg;
+		msg = machine_read(client, sizeof(uint32_t), UINT32_MAX);
+		test(msg != NULL);
+		uint32_t size;
+		memcpy(&size, machine_msg_get_data(msg), sizeof(size));
+		test(size == (uint32_t)packet_size(i));
+		machine_msg_free(msg);
+
+		msg = machine_read(client, size, UINT32_MAX);
+		test(msg != NULL);
+		char *data = machine_msg_get_data(msg);
+		uint32_t j;
+		for (j = 0; j < size; j++)
+			test(data[j] == (char)(i & 0xff));
+		machine_msg_free(msg);
+	}
+
+	rc = machine_close(client);
+	test(rc == 0);
+	machine_io_free(client);
+}
+
+static int uring_skipped = 0;
+
+static void
+test_cs(void *arg)
+{
+	(void)arg;
+	/* epoll is used, if io_uring is not supported by the kernel */
+	char *poll = machine_poll();
+	test(strcmp(poll, "io_uring") == 0 || strcmp(poll, "epoll") == 0);
+	uring_skipped = strcmp(poll, "io_uring") != 0;
+
+	int rc;
+	rc = machine_coroutine_create(server, NULL);
+	test(rc != -1);
+
+	rc = machine_coroutine_create(client, NULL);
+	test(rc != -1);
+}
+
+static void
+test_close(void *arg)
+{
+	(void)arg;
+	int rc;
+	rc = machine_coroutine_create(server_close, NULL);
+	test(rc != -1);
+
+	rc = machine_coroutine_create(client_close, NULL);
+	test(rc != -1);
+}
+
+static void
+test_run(void)
+{
+	machinarium_init();
+
+	int id;
+	id = machine_create("test", test_cs, NULL);
+	test(id != -1);
+
+	int rc;
+	rc = machine_wait(id);
+	test(rc != -1);
+
+	/* flush, close and reuse messages */
+	id = machine_create("test", test_close, NULL);
+	test(id != -1);
+
+	rc = machine_wait(id);
+	test(rc != -1);
+
+	machinarium_free();
+}
+
+void
+machinarium_test_write_zerocopy(void)
+{
+	test_run();
+}
+
+void
+machinarium_test_write_zerocopy_uring(void)
+{
+	machinarium_set_poll("io_uring");
+	test_run();
+	machinarium_set_poll(NULL);
+
+	if (uring_skipped) {
+		printf("[io_uring is not supported, tested with epoll] ");
+		fflush(NULL);
+	}
+}
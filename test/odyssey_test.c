@@ -20,9 +20,12 @@ extern void machinarium_test_create0(void);
 extern void machinarium_test_create1(void);
 extern void machinarium_test_config(void);
 extern void machinarium_test_context_switch(void);
+extern void machinarium_test_stack_arena(void);
+extern void machinarium_test_coroutine_index(void);
 extern void machinarium_test_sleep(void);
 extern void machinarium_test_sleep_yield(void);
 extern void machinarium_test_sleep_cancel0(void);
+extern void machinarium_test_sleep_many(void);
 extern void machinarium_test_join(void);
 extern void machinarium_test_condition0(void);
 extern void machinarium_test_condition1(void);
@@ -43,6 +46,13 @@ extern void machinarium_test_channel_shared_create(void);
 extern void machinarium_test_channel_shared_rw0(void);
 extern void machinarium_test_channel_shared_rw1(void);
 extern void machinarium_test_channel_shared_rw2(void);
+extern void machinarium_test_channel_mpsc(void);
+extern void machinarium_test_channel_batch(void);
+extern void machinarium_test_eventmgr_wakeup(void);
+extern void machinarium_test_write_stage(void);
+extern void machinarium_test_write_zerocopy(void);
+extern void machinarium_test_write_zerocopy_uring(void);
+extern void machinarium_test_msg_cache(void);
 extern void machinarium_test_producer_consumer0(void);
 extern void machinarium_test_producer_consumer1(void);
 extern void machinarium_test_io_new(void);
@@ -52,9 +62,11 @@ extern void machinarium_test_connect_cancel0(void);
 extern void machinarium_test_connect_cancel1(void);
 extern void machinarium_test_accept_timeout(void);
 extern void machinarium_test_accept_cancel(void);
+extern void machinarium_test_accept_reuseport(void);
 extern void machinarium_test_getaddrinfo0(void);
 extern void machinarium_test_getaddrinfo1(void);
 extern void machinarium_test_getaddrinfo2(void);
+extern void machinarium_test_dns_cache(void);
 extern void machinarium_test_client_server0(void);
 extern void machinarium_test_client_server1(void);
 extern void machinarium_test_client_server2(void);
@@ -62,13 +74,17 @@ extern void machinarium_test_client_server_unix_socket(void);
 extern void machinarium_test_read_10mb0(void);
 extern void machinarium_test_read_10mb1(void);
 extern void machinarium_test_read_10mb2(void);
+extern void machinarium_test_read_10mb_uring(void);
+extern void machinarium_test_splice(void);
 extern void machinarium_test_read_timeout(void);
 extern void machinarium_test_read_cancel(void);
 extern void machinarium_test_read_poll0(void);
 extern void machinarium_test_read_poll1(void);
 extern void machinarium_test_read_poll2(void);
 extern void machinarium_test_read_poll3(void);
+extern void machinarium_test_pollgroup(void);
 extern void machinarium_test_read_var(void);
+extern void machinarium_test_read_slice(void);
 extern void machinarium_test_tls0(void);
 extern void machinarium_test_tls_unix_socket(void);
 extern void machinarium_test_tls_read_10mb0(void);
@@ -77,6 +93,8 @@ extern void machinarium_test_tls_read_10mb2(void);
 extern void machinarium_test_tls_read_10mb_poll(void);
 extern void machinarium_test_tls_read_multithread(void);
 extern void machinarium_test_tls_read_var(void);
+extern void machinarium_test_tls_ktls(void);
+extern void machinarium_test_tls_session(void);
 
 int main(int argc, char *argv[])
 {
@@ -87,9 +105,12 @@ int main(int argc, char *argv[])
 	odyssey_test(machinarium_test_create1);
 	odyssey_test(machinarium_test_config);
 	odyssey_test(machinarium_test_context_switch);
+	odyssey_test(machinarium_test_stack_arena);
+	odyssey_test(machinarium_test_coroutine_index);
 	odyssey_test(machinarium_test_sleep);
 	odyssey_test(machinarium_test_sleep_yield);
 	odyssey_test(machinarium_test_sleep_cancel0);
+	odyssey_test(machinarium_test_sleep_many);
 	odyssey_test(machinarium_test_join);
 	odyssey_test(machinarium_test_condition0);
 	odyssey_test(machinarium_test_condition1);
@@ -110,6 +131,13 @@ int main(int argc, char *argv[])
 	odyssey_test(machinarium_test_channel_shared_rw0);
 	odyssey_test(machinarium_test_channel_shared_rw1);
 	odyssey_test(machinarium_test_channel_shared_rw2);
+	odyssey_test(machinarium_test_channel_mpsc);
+	odyssey_test(machinarium_test_channel_batch);
+	odyssey_test(machinarium_test_eventmgr_wakeup);
+	odyssey_test(machinarium_test_write_stage);
+	odyssey_test(machinarium_test_write_zerocopy);
+	odyssey_test(machinarium_test_write_zerocopy_uring);
+	odyssey_test(machinarium_test_msg_cache);
 	odyssey_test(machinarium_test_producer_consumer0);
 	odyssey_test(machinarium_test_producer_consumer1);
 	odyssey_test(machinarium_test_io_new);
@@ -119,9 +147,11 @@ int main(int argc, char *argv[])
 	odyssey_test(machinarium_test_connect_cancel1);
 	odyssey_test(machinarium_test_accept_timeout);
 	odyssey_test(machinarium_test_accept_cancel);
+	odyssey_test(machinarium_test_accept_reuseport);
 	odyssey_test(machinarium_test_getaddrinfo0);
 	odyssey_test(machinarium_test_getaddrinfo1);
 	odyssey_test(machinarium_test_getaddrinfo2);
+	odyssey_test(machinarium_test_dns_cache);
 	odyssey_test(machinarium_test_client_server0);
 	odyssey_test(machinarium_test_client_server1);
 	odyssey_test(machinarium_test_client_server2);
@@ -129,13 +159,17 @@ int main(int argc, char *argv[])
 	odyssey_test(machinarium_test_read_10mb0);
 	odyssey_test(machinarium_test_read_10mb1);
 	odyssey_test(machinarium_test_read_10mb2);
+	odyssey_test(machinarium_test_read_10mb_uring);
+	odyssey_test(machinarium_test_splice);
 	odyssey_test(machinarium_test_read_timeout);
 	odyssey_test(machinarium_test_read_cancel);
 	odyssey_test(machinarium_test_read_poll0);
 	odyssey_test(machinarium_test_read_poll1);
 	odyssey_test(machinarium_test_read_poll2);
 	odyssey_test(machinarium_test_read_poll3);
+	odyssey_test(machinarium_test_pollgroup);
 	odyssey_test(machinarium_test_read_var);
+	odyssey_test(machinarium_test_read_slice);
 	odyssey_test(machinarium_test_tls0);
 	odyssey_test(machinarium_test_tls_unix_socket);
 	odyssey_test(machinarium_test_tls_read_10mb0);
@@ -144,5 +178,7 @@ int main(int argc, char *argv[])
 	odyssey_test(machinarium_test_tls_read_10mb_poll);
 	odyssey_test(machinarium_test_tls_read_multithread);
 	odyssey_test(machinarium_test_tls_read_var);
+	odyssey_test(machinarium_test_tls_ktls);
+	odyssey_test(machinarium_test_tls_session);
 	return 0;
 }
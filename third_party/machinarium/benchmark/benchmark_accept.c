@@ -0,0 +1,115 @@
+
+/*
+ * machinarium.
+ *
+ * Cooperative multitasking engine.
+*/
+
+/*
+ * This example shows number of connections accepted in one
+ * second, while many client coroutines connect over loopback
+ * in a separate thread:
+ *
+ * ./benchmark_accept [clients]
+*/
+
+#include <machinarium.h>
+#include <arpa/inet.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+static int clients = 64;
+static int accepted = 0;
+static volatile int active = 1;
+
+static uint64_t
+benchmark_cpu_us(void)
+{
+	struct timespec t;
+	clock_gettime(CLOCK_THREAD_CPUTIME_ID, &t);
+	return t.tv_sec * 1000000ULL + t.tv_nsec / 1000;
+}
+
+static void
+benchmark_set_addr(struct sockaddr_in *sa)
+{
+	memset(sa, 0, sizeof(*sa));
+	sa->sin_family = AF_INET;
+	sa->sin_addr.s_addr = inet_addr("127.0.0.1");
+	sa->sin_port = htons(7781);
+}
+
+static void
+benchmark_connect(void *arg)
+{
+	struct sockaddr_in sa;
+	benchmark_set_addr(&sa);
+	while (active) {
+		machine_io_t *client = machine_io_create();
+		machine_connect(client, (struct sockaddr*)&sa, 1000);
+		machine_close(client);
+		machine_io_free(client);
+	}
+}
+
+static void
+benchmark_client(void *arg)
+{
+	int i;
+	for (i = 0; i < clients; i++)
+		machine_coroutine_create(benchmark_connect, NULL);
+}
+
+static void
+benchmark_runner(void *arg)
+{
+	machine_io_t *server = machine_io_create();
+	struct sockaddr_in sa;
+	benchmark_set_addr(&sa);
+	machine_set_nodelay(server, 1);
+	machine_set_keepalive(server, 1, 7200);
+	machine_bind(server, (struct sockaddr*)&sa);
+
+	/* start listening before clients are connecting */
+	machine_io_t *client;
+	machine_accept(server, &client, 4096, 0, 0);
+
+	printf("benchmark started.\n");
+	int64_t id = machine_create("benchmark_client", benchmark_client, NULL);
+	uint64_t time_start = machine_time_ms();
+	uint64_t cpu_start = benchmark_cpu_us();
+	while (machine_time_ms() - time_start < 1000) {
+		int rc;
+		rc = machine_accept(server, &client, 4096, 0, 100);
+		if (rc == -1)
+			continue;
+		accepted++;
+		machine_close(client);
+		machine_io_free(client);
+	}
+	uint64_t cpu = benchmark_cpu_us() - cpu_start;
+	printf("done.\n");
+	printf("accepted %d connections in 1 sec.\n", accepted);
+	if (accepted > 0)
+		printf("acceptor cpu time %d ns per connection.\n",
+		       (int)(cpu * 1000 / accepted));
+
+	active = 0;
+	machine_wait(id);
+	machine_close(server);
+	machine_io_free(server);
+	machine_stop();
+}
+
+int
+main(int argc, char *argv[])
+{
+	if (argc > 1)
+		clients = atoi(argv[1]);
+	machinarium_init();
+	int id = machine_create("benchmark_accept", benchmark_runner, NULL);
+	machine_wait(id);
+	machinarium_free();
+	return 0;
+}
@@ -0,0 +1,87 @@
+
+/*
+ * machinarium.
+ *
+ * Cooperative multitasking engine.
+*/
+
+/*
+ * This example shows number of messages passed from several
+ * producer machines to a single consumer in one second,
+ * using selected channel type:
+ *
+ * ./benchmark_channel_mpsc [shared|mpsc]
+*/
+
+#include <machinarium.h>
+#include <string.h>
+#include <unistd.h>
+
+#define PRODUCERS 4
+
+static machine_channel_t *channel;
+static volatile int active = 1;
+static int ops = 0;
+
+static void
+benchmark_producer(void *arg)
+{
+	(void)arg;
+	while (active) {
+		int i;
+		for (i = 0; i < 64; i++) {
+			machine_msg_t *msg;
+			msg = machine_msg_create(0);
+			machine_channel_write(channel, msg);
+		}
+		machine_sleep(0);
+	}
+	/* wakeup consumer */
+	machine_msg_t *msg;
+	msg = machine_msg_create(0);
+	machine_msg_set_type(msg, 1);
+	machine_channel_write(channel, msg);
+}
+
+static void
+benchmark_consumer(void *arg)
+{
+	(void)arg;
+	int producers = PRODUCERS;
+	while (producers > 0) {
+		machine_msg_t *msg;
+		msg = machine_channel_read(channel, UINT32_MAX);
+		if (msg == NULL)
+			break;
+		if (machine_msg_get_type(msg) == 1)
+			producers--;
+		machine_msg_free(msg);
+		ops++;
+	}
+}
+
+int
+main(int argc, char *argv[])
+{
+	int type = MACHINE_CHANNEL_MPSC;
+	if (argc > 1 && strcmp(argv[1], "shared") == 0)
+		type = MACHINE_CHANNEL_SHARED;
+	machinarium_init();
+	channel = machine_channel_create(type);
+	printf("benchmark started.\n");
+	int consumer = machine_create("consumer", benchmark_consumer, NULL);
+	int producers[PRODUCERS];
+	int i;
+	for (i = 0; i < PRODUCERS; i++)
+		producers[i] = machine_create("producer", benchmark_producer, NULL);
+	sleep(1);
+	active = 0;
+	for (i = 0; i < PRODUCERS; i++)
+		machine_wait(producers[i]);
+	machine_wait(consumer);
+	printf("done.\n");
+	printf("channel messages %d in 1 sec.\n", ops);
+	machine_channel_free(channel);
+	machinarium_free();
+	return 0;
+}
@@ -0,0 +1,95 @@
+
+/*
+ * machinarium.
+ *
+ * Cooperative multitasking engine.
+*/
+
+/*
+ * This example shows request-response round trips done
+ * over loopback in one second, using selected poll backend:
+ *
+ * ./benchmark_io [epoll|io_uring]
+*/
+
+#include <machinarium.h>
+#include <arpa/inet.h>
+#include <string.h>
+
+static int ops = 0;
+
+static void
+benchmark_server(void *arg)
+{
+	machine_io_t *server = machine_io_create();
+	struct sockaddr_in sa;
+	sa.sin_family = AF_INET;
+	sa.sin_addr.s_addr = inet_addr("127.0.0.1");
+	sa.sin_port = htons(7780);
+	machine_bind(server, (struct sockaddr*)&sa);
+
+	machine_io_t *client;
+	machine_accept(server, &client, 16, 1, UINT32_MAX);
+	for (;;) {
+		machine_msg_t *msg;
+		msg = machine_read(client, 64, UINT32_MAX);
+		if (msg == NULL)
+			break;
+		machine_write(client, msg);
+		machine_flush(client, UINT32_MAX);
+	}
+	machine_close(client);
+	machine_io_free(client);
+	machine_close(server);
+	machine_io_free(server);
+}
+
+static void
+benchmark_client(void *arg)
+{
+	machine_io_t *client = machine_io_create();
+	struct sockaddr_in sa;
+	sa.sin_family = AF_INET;
+	sa.sin_addr.s_addr = inet_addr("127.0.0.1");
+	sa.sin_port = htons(7780);
+	machine_connect(client, (struct sockaddr*)&sa, UINT32_MAX);
+	while (machine_active()) {
+		machine_msg_t *msg;
+		msg = machine_msg_create(0);
+		machine_msg_write(msg, NULL, 64);
+		memset(machine_msg_get_data(msg), 'x', 64);
+		machine_write(client, msg);
+		machine_flush(client, UINT32_MAX);
+		msg = machine_read(client, 64, UINT32_MAX);
+		if (msg == NULL)
+			break;
+		machine_msg_free(msg);
+		ops++;
+	}
+	machine_close(client);
+	machine_io_free(client);
+}
+
+static void
+benchmark_runner(void *arg)
+{
+	printf("benchmark started.\n");
+	machine_coroutine_create(benchmark_server, NULL);
+	machine_coroutine_create(benchmark_client, NULL);
+	machine_sleep(1000);
+	printf("done.\n");
+	printf("round trips %d in 1 sec.\n", ops);
+	machine_stop();
+}
+
+int
+main(int argc, char *argv[])
+{
+	if (argc > 1)
+		machinarium_set_poll(argv[1]);
+	machinarium_init();
+	int id = machine_create("benchmark_io", benchmark_runner, NULL);
+	machine_wait(id);
+	machinarium_free();
+	return 0;
+}
@@ -0,0 +1,75 @@
+
+/*
+ * machinarium.
+ *
+ * Cooperative multitasking engine.
+*/
+
+/*
+ * This example shows time spent to signal many coroutines waiting
+ * on condition by id, in reverse order of their creation:
+ *
+ * ./benchmark_signal [coroutines]
+*/
+
+#include <machinarium.h>
+#include <stdlib.h>
+#include <time.h>
+
+static int coroutines = 10000;
+
+static uint64_t
+benchmark_time_us(void)
+{
+	struct timespec t;
+	clock_gettime(CLOCK_MONOTONIC, &t);
+	return t.tv_sec * 1000000ULL + t.tv_nsec / 1000;
+}
+
+static void
+benchmark_waiter(void *arg)
+{
+	machine_condition(UINT32_MAX);
+}
+
+static void
+benchmark_runner(void *arg)
+{
+	printf("benchmark started.\n");
+
+	int64_t *ids = malloc(sizeof(int64_t) * coroutines);
+	if (ids == NULL) {
+		machine_stop();
+		return;
+	}
+	int i;
+	for (i = 0; i < coroutines; i++)
+		ids[i] = machine_coroutine_create(benchmark_waiter, NULL);
+
+	/* wait on condition */
+	machine_sleep(0);
+
+	uint64_t time_start = benchmark_time_us();
+	for (i = coroutines - 1; i >= 0; i--)
+		machine_signal(ids[i]);
+	uint64_t time = benchmark_time_us() - time_start;
+
+	machine_sleep(0);
+
+	printf("done.\n");
+	printf("%d signals in %d us.\n", coroutines, (int)time);
+	free(ids);
+	machine_stop();
+}
+
+int
+main(int argc, char *argv[])
+{
+	if (argc > 1)
+		coroutines = atoi(argv[1]);
+	machinarium_init();
+	int id = machine_create("benchmark_signal", benchmark_runner, NULL);
+	machine_wait(id);
+	machinarium_free();
+	return 0;
+}
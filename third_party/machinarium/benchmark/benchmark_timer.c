@@ -0,0 +1,73 @@
+
+/*
+ * machinarium.
+ *
+ * Cooperative multitasking engine.
+*/
+
+/*
+ * This example shows time spent to start many sleeping coroutines
+ * with random timeouts, cancel every other one and wait for the rest:
+ *
+ * ./benchmark_timer [coroutines]
+*/
+
+#include <machinarium.h>
+#include <stdlib.h>
+
+static int coroutines = 10000;
+
+static void
+benchmark_sleeper(void *arg)
+{
+	uint32_t interval = (uintptr_t)arg;
+	machine_sleep(interval);
+}
+
+static void
+benchmark_runner(void *arg)
+{
+	printf("benchmark started.\n");
+
+	int64_t *ids = malloc(sizeof(int64_t) * coroutines);
+	if (ids == NULL) {
+		machine_stop();
+		return;
+	}
+	unsigned int seed = 7;
+	uint64_t time_start = machine_time_us();
+
+	int i;
+	for (i = 0; i < coroutines; i++) {
+		uintptr_t interval = 1 + rand_r(&seed) % 100;
+		ids[i] = machine_coroutine_create(benchmark_sleeper, (void*)interval);
+	}
+
+	/* start timers */
+	machine_sleep(0);
+
+	/* cancel timers in the middle of the heap */
+	for (i = 0; i < coroutines; i += 2)
+		machine_cancel(ids[i]);
+
+	for (i = 0; i < coroutines; i++)
+		machine_join(ids[i]);
+
+	printf("done.\n");
+	printf("%d timers in %d us.\n", coroutines,
+	       (int)(machine_time_us() - time_start));
+	free(ids);
+	machine_stop();
+}
+
+int
+main(int argc, char *argv[])
+{
+	if (argc > 1)
+		coroutines = atoi(argv[1]);
+	machinarium_init();
+	int id = machine_create("benchmark_timer", benchmark_runner, NULL);
+	machine_wait(id);
+	machinarium_free();
+	return 0;
+}
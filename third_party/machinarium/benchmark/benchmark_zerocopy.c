@@ -0,0 +1,118 @@
+/*
+ * machinarium.
+ *
+ * Cooperative multitasking engine.
+*/
+
+/*
+ * This example sends 1GB over loopback using 64KB messages and
+ * shows sender CPU time spent per GB with plain writes and with
+ * MSG_ZEROCOPY writes:
+ *
+ * ./benchmark_zerocopy
+ *
+ * Note that loopback traffic is always copied by the kernel, so
+ * zero-copy writes are expected to be disabled after the first
+ * completion reports it. Use a real device to see the difference.
+*/
+
+#define _GNU_SOURCE
+#include <machinarium.h>
+#include <arpa/inet.h>
+#include <string.h>
+#include <sys/time.h>
+#include <sys/resource.h>
+
+#define MSG_SIZE (64 * 1024)
+#define TOTAL    (1024ULL * 1024 * 1024)
+
+static int zerocopy = 0;
+
+static inline double
+cpu_time(void)
+{
+	struct rusage usage;
+	getrusage(RUSAGE_THREAD, &usage);
+	return usage.ru_utime.tv_sec + usage.ru_utime.tv_usec / 1000000.0 +
+	       usage.ru_stime.tv_sec + usage.ru_stime.tv_usec / 1000000.0;
+}
+
+static void
+benchmark_receiver(void *arg)
+{
+	machine_io_t *server = machine_io_create();
+	struct sockaddr_in sa;
+	sa.sin_family = AF_INET;
+	sa.sin_addr.s_addr = inet_addr("127.0.0.1");
+	sa.sin_port = htons(7780);
+	machine_bind(server, (struct sockaddr*)&sa);
+
+	machine_io_t *client;
+	machine_accept(server, &client, 16, 1, UINT32_MAX);
+	machine_set_readahead(client, MSG_SIZE);
+	for (;;) {
+		machine_msg_t *msg;
+		msg = machine_read(client, MSG_SIZE, UINT32_MAX);
+		if (msg == NULL)
+			break;
+		machine_msg_free(msg);
+	}
+	machine_close(client);
+	machine_io_free(client);
+	machine_close(server);
+	machine_io_free(server);
+}
+
+static void
+benchmark_sender(void *arg)
+{
+	machine_io_t *client = machine_io_create();
+	if (zerocopy)
+		machine_set_zerocopy(client, MSG_SIZE);
+	struct sockaddr_in sa;
+	sa.sin_family = AF_INET;
+	sa.sin_addr.s_addr = inet_addr("127.0.0.1");
+	sa.sin_port = htons(7780);
+	machine_sleep(10);
+	machine_connect(client, (struct sockaddr*)&sa, UINT32_MAX);
+
+	double start = cpu_time();
+	unsigned long long sent = 0;
+	while (sent < TOTAL) {
+		machine_msg_t *msg;
+		msg = machine_msg_create(MSG_SIZE);
+		memset(machine_msg_get_data(msg), 'x', MSG_SIZE);
+		machine_write(client, msg);
+		sent += MSG_SIZE;
+		if ((sent / MSG_SIZE) % 16 == 0)
+			machine_flush(client, UINT32_MAX);
+	}
+	machine_flush(client, UINT32_MAX);
+	double cpu = cpu_time() - start;
+
+	printf("%s: %.3f sec cpu per GB\n", zerocopy ? "zerocopy" : "writev",
+	       cpu / (TOTAL / (1024.0 * 1024 * 1024)));
+	machine_close(client);
+	machine_io_free(client);
+}
+
+static void
+benchmark_run(void)
+{
+	int receiver = machine_create("receiver", benchmark_receiver, NULL);
+	int sender = machine_create("sender", benchmark_sender, NULL);
+	machine_wait(sender);
+	machine_wait(receiver);
+}
+
+int
+main(int argc, char *argv[])
+{
+	machinarium_init();
+	zerocopy = 0;
+	benchmark_run();
+	zerocopy = 1;
+	benchmark_run();
+	machinarium_free();
+	return 0;
+}
@@ -19,12 +19,70 @@ mm_accept_on_read_cb(mm_fd_t *handle)
 	mm_scheduler_wakeup(&mm_self->scheduler, call->coroutine);
 }
 
+/*
+ * Pending connections are accepted without waiting for readiness,
+ * up to MM_ACCEPT_DRAIN in a row, so a backlog is drained with one
+ * accept4() per connection and other coroutines still get a chance
+ * to run during a connection storm.
+ *
+ * Accepted sockets are non-blocking from accept4() and inherit
+ * nodelay and keepalive settings from the listen socket, so these
+ * options are set once on the listener.
+*/
+
+#define MM_ACCEPT_DRAIN 64
+
+static inline int
+mm_accept_wait(mm_io_t *io, uint32_t time_ms)
+{
+	mm_machine_t *machine = mm_self;
+
+	/* subscribe for accept event */
+	int rc;
+	rc = mm_loop_read(&machine->loop, &io->handle,
+	                  mm_accept_on_read_cb,
+	                  io);
+	if (rc == -1) {
+		mm_errno_set(errno);
+		return -1;
+	}
+
+	/* wait for completion */
+	mm_call(&io->call, MM_CALL_ACCEPT, time_ms);
+
+	rc = mm_loop_read_stop(&machine->loop, &io->handle);
+	if (rc == -1) {
+		mm_errno_set(errno);
+		return -1;
+	}
+
+	rc = io->call.status;
+	if (rc != 0) {
+		mm_errno_set(rc);
+		return -1;
+	}
+	return 0;
+}
+
+static inline int
+mm_accept_socket_set(mm_io_t *io, mm_io_t *client_io, int fd)
+{
+#if defined(SOCK_NONBLOCK) && defined(SOCK_CLOEXEC)
+	client_io->fd = fd;
+	client_io->handle.fd = fd;
+	client_io->zerocopy_size = io->zerocopy_size;
+	return 0;
+#else
+	(void)io;
+	return mm_io_socket_set(client_io, fd);
+#endif
+}
+
 MACHINE_API int
 machine_accept(machine_io_t *obj, machine_io_t **client,
                int backlog, int attach, uint32_t time_ms)
 {
 	mm_io_t *io = mm_cast(mm_io_t*, obj);
-	mm_machine_t *machine = mm_self;
 	mm_errno_set(0);
 
 	if (mm_call_is_active(&io->call)) {
@@ -54,33 +112,32 @@ machine_accept(machine_io_t *obj, machine_io_t **client,
 		io->accept_listen = 1;
 	}
 
-	/* subscribe for accept event */
-	rc = mm_loop_read(&machine->loop, &io->handle,
-	                  mm_accept_on_read_cb,
-	                  io);
-	if (rc == -1) {
-		mm_errno_set(errno);
-		return -1;
-	}
-
-	/* wait for completion */
-	mm_call(&io->call, MM_CALL_ACCEPT, time_ms);
-
-	rc = mm_loop_read_stop(&machine->loop, &io->handle);
-	if (rc == -1) {
-		mm_errno_set(errno);
-		return -1;
+	/* drain pending connections, wait for readiness otherwise */
+	int fd = -1;
+	if (io->accept_drained < MM_ACCEPT_DRAIN) {
+		fd = mm_socket_accept(io->fd, NULL, NULL);
+		if (fd == -1 && errno != EAGAIN && errno != EWOULDBLOCK) {
+			mm_errno_set(errno);
+			return -1;
+		}
 	}
-
-	rc = io->call.status;
-	if (rc != 0) {
-		mm_errno_set(rc);
-		return -1;
+	if (fd == -1) {
+		io->accept_drained = 0;
+		rc = mm_accept_wait(io, time_ms);
+		if (rc == -1)
+			return -1;
+		fd = mm_socket_accept(io->fd, NULL, NULL);
+		if (fd == -1) {
+			mm_errno_set(errno);
+			return -1;
+		}
 	}
+	io->accept_drained++;
 
 	/* setup client io */
 	*client = machine_io_create();
-	if (client == NULL) {
+	if (*client == NULL) {
+		close(fd);
 		mm_errno_set(ENOMEM);
 		return -1;
 	}
@@ -90,16 +147,10 @@ machine_accept(machine_io_t *obj, machine_io_t **client,
 	client_io->opt_nodelay = io->opt_nodelay;
 	client_io->opt_keepalive = io->opt_keepalive;
 	client_io->opt_keepalive_delay = io->opt_keepalive_delay;
+	client_io->opt_zerocopy = io->opt_zerocopy;
 	client_io->accepted = 1;
 	client_io->connected = 1;
-	rc = mm_socket_accept(io->fd, NULL, NULL);
-	if (rc == -1) {
-		mm_errno_set(errno);
-		machine_io_free(*client);
-		*client = NULL;
-		return -1;
-	}
-	rc = mm_io_socket_set(client_io, rc);
+	rc = mm_accept_socket_set(io, client_io, fd);
 	if (rc == -1) {
 		machine_close(*client);
 		machine_io_free(*client);
@@ -10,6 +10,7 @@
 /* AUTO-GENERATED (see build.h.cmake) */
 
 #cmakedefine HAVE_VALGRIND 1
+#cmakedefine HAVE_IO_URING 1
 #cmakedefine USE_BORINGSSL 1
 
 #endif /* MM_BUILD_H */
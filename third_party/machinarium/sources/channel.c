@@ -10,7 +10,7 @@
 
 void mm_channel_init(mm_channel_t *channel)
 {
-	channel->type.is_shared = 1;
+	channel->type.type = MM_CHANNEL_SHARED;
 	mm_sleeplock_init(&channel->lock);
 
 	mm_list_init(&channel->msg_list);
@@ -27,7 +27,7 @@ void mm_channel_free(mm_channel_t *channel)
 	mm_list_t *i, *n;
 	mm_list_foreach_safe(&channel->msg_list, i, n) {
 		mm_msg_t *msg = mm_container_of(i, mm_msg_t, link);
-		mm_msg_unref(&mm_self->msg_cache, msg);
+		mm_msg_unref(mm_self->msg_cache, msg);
 	}
 }
 
@@ -100,9 +100,61 @@ mm_channel_read(mm_channel_t *channel, uint32_t time_ms)
 	/* timedout or cancel */
 	if (reader.event.call.status != 0) {
 		if (reader.result)
-			mm_msg_unref(&mm_self->msg_cache, reader.result);
+			mm_msg_unref(mm_self->msg_cache, reader.result);
 		return NULL;
 	}
 
 	return reader.result;
 }
+
+void mm_channel_write_batch(mm_channel_t *channel, mm_msg_t **msgs, int count)
+{
+	int i = 0;
+	while (i < count)
+	{
+		mm_sleeplock_lock(&channel->lock);
+		if (channel->readers_count) {
+			/* pass message to the waiting reader */
+			mm_sleeplock_unlock(&channel->lock);
+			mm_channel_write(channel, msgs[i]);
+			i++;
+			continue;
+		}
+		for (; i < count; i++) {
+			mm_list_append(&channel->msg_list, &msgs[i]->link);
+			channel->msg_list_count++;
+		}
+		mm_sleeplock_unlock(&channel->lock);
+	}
+}
+
+static inline int
+mm_channel_pop(mm_channel_t *channel, mm_msg_t **msgs, int count, int max)
+{
+	mm_sleeplock_lock(&channel->lock);
+	if (channel->readers_count == 0) {
+		while (count < max && channel->msg_list_count > 0) {
+			mm_list_t *next;
+			next = mm_list_pop(&channel->msg_list);
+			channel->msg_list_count--;
+			msgs[count++] = mm_container_of(next, mm_msg_t, link);
+		}
+	}
+	mm_sleeplock_unlock(&channel->lock);
+	return count;
+}
+
+int mm_channel_read_batch(mm_channel_t *channel, mm_msg_t **msgs, int max,
+                          uint32_t time_ms)
+{
+	int count;
+	count = mm_channel_pop(channel, msgs, 0, max);
+	if (count > 0)
+		return count;
+	mm_msg_t *msg;
+	msg = mm_channel_read(channel, time_ms);
+	if (msg == NULL)
+		return -1;
+	msgs[0] = msg;
+	return mm_channel_pop(channel, msgs, 1, max);
+}
@@ -34,4 +34,7 @@ void mm_channel_write(mm_channel_t*, mm_msg_t*);
 mm_msg_t*
 mm_channel_read(mm_channel_t*, uint32_t);
 
+void mm_channel_write_batch(mm_channel_t*, mm_msg_t**, int);
+int  mm_channel_read_batch(mm_channel_t*, mm_msg_t**, int, uint32_t);
+
 #endif /* MM_CHANNEL_H */
@@ -9,9 +9,20 @@
 #include <machinarium_private.h>
 
 MACHINE_API machine_channel_t*
-machine_channel_create(int shared)
+machine_channel_create(int type)
 {
-	if (shared) {
+	if (type == MM_CHANNEL_MPSC) {
+		mm_channelmpsc_t *channel;
+		channel = malloc(sizeof(mm_channelmpsc_t));
+		if (channel == NULL) {
+			mm_errno_set(ENOMEM);
+			return NULL;
+		}
+		mm_channelmpsc_init(channel);
+		return (machine_channel_t*)channel;
+	}
+
+	if (type == MM_CHANNEL_SHARED) {
 		mm_channel_t *channel;
 		channel = malloc(sizeof(mm_channel_t));
 		if (channel == NULL) {
@@ -37,7 +48,14 @@ machine_channel_free(machine_channel_t *obj)
 {
 	mm_channeltype_t *type;
 	type = mm_cast(mm_channeltype_t*, obj);
-	if (type->is_shared) {
+	if (type->type == MM_CHANNEL_MPSC) {
+		mm_channelmpsc_t *channel;
+		channel = mm_cast(mm_channelmpsc_t*, obj);
+		mm_channelmpsc_free(channel);
+		free(channel);
+		return;
+	}
+	if (type->type == MM_CHANNEL_SHARED) {
 		mm_channel_t *channel;
 		channel = mm_cast(mm_channel_t*, obj);
 		mm_channel_free(channel);
@@ -55,16 +73,21 @@ machine_channel_write(machine_channel_t *obj, machine_msg_t *obj_msg)
 {
 	mm_channeltype_t *type;
 	type = mm_cast(mm_channeltype_t*, obj);
-	if (type->is_shared) {
+	mm_msg_t *msg = mm_cast(mm_msg_t*, obj_msg);
+	if (type->type == MM_CHANNEL_MPSC) {
+		mm_channelmpsc_t *channel;
+		channel = mm_cast(mm_channelmpsc_t*, obj);
+		mm_channelmpsc_write(channel, msg);
+		return;
+	}
+	if (type->type == MM_CHANNEL_SHARED) {
 		mm_channel_t *channel;
 		channel = mm_cast(mm_channel_t*, obj);
-		mm_msg_t *msg = mm_cast(mm_msg_t*, obj_msg);
 		mm_channel_write(channel, msg);
 		return;
 	}
 	mm_channelfast_t *channel;
 	channel = mm_cast(mm_channelfast_t*, obj);
-	mm_msg_t *msg = mm_cast(mm_msg_t*, obj_msg);
 	mm_channelfast_write(channel, msg);
 }
 
@@ -73,16 +96,71 @@ machine_channel_read(machine_channel_t *obj, uint32_t time_ms)
 {
 	mm_channeltype_t *type;
 	type = mm_cast(mm_channeltype_t*, obj);
-	if (type->is_shared) {
+	mm_msg_t *msg;
+	if (type->type == MM_CHANNEL_MPSC) {
+		mm_channelmpsc_t *channel;
+		channel = mm_cast(mm_channelmpsc_t*, obj);
+		msg = mm_channelmpsc_read(channel, time_ms);
+		return (machine_msg_t*)msg;
+	}
+	if (type->type == MM_CHANNEL_SHARED) {
 		mm_channel_t *channel;
 		channel = mm_cast(mm_channel_t*, obj);
-		mm_msg_t *msg;
 		msg = mm_channel_read(channel, time_ms);
 		return (machine_msg_t*)msg;
 	}
 	mm_channelfast_t *channel;
 	channel = mm_cast(mm_channelfast_t*, obj);
-	mm_msg_t *msg;
 	msg = mm_channelfast_read(channel, time_ms);
 	return (machine_msg_t*)msg;
 }
+
+MACHINE_API void
+machine_channel_write_batch(machine_channel_t *obj, machine_msg_t **obj_msgs,
+                            int count)
+{
+	mm_channeltype_t *type;
+	type = mm_cast(mm_channeltype_t*, obj);
+	mm_msg_t **msgs = mm_cast(mm_msg_t**, obj_msgs);
+	if (type->type == MM_CHANNEL_MPSC) {
+		mm_channelmpsc_t *channel;
+		channel = mm_cast(mm_channelmpsc_t*, obj);
+		mm_channelmpsc_write_batch(channel, msgs, count);
+		return;
+	}
+	if (type->type == MM_CHANNEL_SHARED) {
+		mm_channel_t *channel;
+		channel = mm_cast(mm_channel_t*, obj);
+		mm_channel_write_batch(channel, msgs, count);
+		return;
+	}
+	mm_channelfast_t *channel;
+	channel = mm_cast(mm_channelfast_t*, obj);
+	mm_channelfast_write_batch(channel, msgs, count);
+}
+
+MACHINE_API int
+machine_channel_read_batch(machine_channel_t *obj, machine_msg_t **obj_msgs,
+                           int max, uint32_t time_ms)
+{
+	mm_channeltype_t *type;
+	type = mm_cast(mm_channeltype_t*, obj);
+	mm_msg_t **msgs = mm_cast(mm_msg_t**, obj_msgs);
+	if (max <= 0) {
+		mm_errno_set(EINVAL);
+		return -1;
+	}
+	if (type->type == MM_CHANNEL_MPSC) {
+		mm_channelmpsc_t *channel;
+		channel = mm_cast(mm_channelmpsc_t*, obj);
+		return mm_channelmpsc_read_batch(channel, msgs, max, time_ms);
+	}
+	if (type->type == MM_CHANNEL_SHARED) {
+		mm_channel_t *channel;
+		channel = mm_cast(mm_channel_t*, obj);
+		return mm_channel_read_batch(channel, msgs, max, time_ms);
+	}
+	mm_channelfast_t *channel;
+	channel = mm_cast(mm_channelfast_t*, obj);
+	return mm_channelfast_read_batch(channel, msgs, max, time_ms);
+}
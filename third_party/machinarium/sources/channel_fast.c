@@ -10,7 +10,7 @@
 
 void mm_channelfast_init(mm_channelfast_t *channel)
 {
-	channel->type.is_shared = 0;
+	channel->type.type = MM_CHANNEL_FAST;
 	mm_list_init(&channel->incoming);
 	channel->incoming_count = 0;
 	mm_list_init(&channel->readers);
@@ -23,7 +23,7 @@ void mm_channelfast_free(mm_channelfast_t *channel)
 	mm_list_foreach_safe(&channel->incoming, i, n) {
 		mm_msg_t *msg;
 		msg = mm_container_of(i, mm_msg_t, link);
-		mm_msg_unref(&mm_self->msg_cache, msg);
+		mm_msg_unref(mm_self->msg_cache, msg);
 	}
 }
 
@@ -82,3 +82,31 @@ fetch:;
 	channel->incoming_count--;
 	return mm_container_of(first, mm_msg_t, link);
 }
+
+void mm_channelfast_write_batch(mm_channelfast_t *channel, mm_msg_t **msgs,
+                                int count)
+{
+	int i;
+	for (i = 0; i < count; i++)
+		mm_channelfast_write(channel, msgs[i]);
+}
+
+int mm_channelfast_read_batch(mm_channelfast_t *channel, mm_msg_t **msgs,
+                              int max, uint32_t time_ms)
+{
+	int count = 0;
+	if (channel->incoming_count == 0) {
+		mm_msg_t *msg;
+		msg = mm_channelfast_read(channel, time_ms);
+		if (msg == NULL)
+			return -1;
+		msgs[count++] = msg;
+	}
+	while (count < max && channel->incoming_count > 0) {
+		mm_list_t *first;
+		first = mm_list_pop(&channel->incoming);
+		channel->incoming_count--;
+		msgs[count++] = mm_container_of(first, mm_msg_t, link);
+	}
+	return count;
+}
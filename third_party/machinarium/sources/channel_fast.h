@@ -33,4 +33,7 @@ void mm_channelfast_write(mm_channelfast_t*, mm_msg_t*);
 mm_msg_t*
 mm_channelfast_read(mm_channelfast_t*, uint32_t);
 
+void mm_channelfast_write_batch(mm_channelfast_t*, mm_msg_t**, int);
+int  mm_channelfast_read_batch(mm_channelfast_t*, mm_msg_t**, int, uint32_t);
+
 #endif /* MM_CHANNEL_FAST_H */
@@ -0,0 +1,199 @@
+
+/*
+ * machinarium.
+ *
+ * cooperative multitasking engine.
+*/
+
+#include <machinarium.h>
+#include <machinarium_private.h>
+
+/*
+ * Writers push messages into the lock-free incoming stack, reader
+ * takes the whole stack at once and restores arrival order.
+ *
+ * Reader publishes its wait state before going to sleep, and only
+ * the writer which switches it from WAIT to SIGNAL wakes the reader
+ * up, so a burst of writes costs a single event signal.
+*/
+
+static inline mm_msg_t*
+mm_channelmpsc_incoming(mm_channelmpsc_t *channel)
+{
+	return *(mm_msg_t *volatile*)&channel->incoming;
+}
+
+static inline int
+mm_channelmpsc_state(mm_channelmpsc_t *channel)
+{
+	return *(volatile int*)&channel->reader_state;
+}
+
+void mm_channelmpsc_init(mm_channelmpsc_t *channel)
+{
+	channel->type.type = MM_CHANNEL_MPSC;
+	channel->incoming = NULL;
+	mm_list_init(&channel->msg_list);
+	channel->msg_list_count = 0;
+	channel->reader = NULL;
+	channel->reader_state = MM_CHANNELMPSC_IDLE;
+}
+
+static inline void
+mm_channelmpsc_collect(mm_channelmpsc_t *channel)
+{
+	assert(channel->msg_list_count == 0);
+	mm_msg_t *msg;
+	msg = __sync_lock_test_and_set(&channel->incoming, NULL);
+	while (msg) {
+		mm_msg_t *next = NULL;
+		if (msg->link.next)
+			next = mm_container_of(msg->link.next, mm_msg_t, link);
+		mm_list_push(&channel->msg_list, &msg->link);
+		channel->msg_list_count++;
+		msg = next;
+	}
+}
+
+static inline mm_msg_t*
+mm_channelmpsc_pop(mm_channelmpsc_t *channel)
+{
+	if (channel->msg_list_count == 0) {
+		if (mm_channelmpsc_incoming(channel) == NULL)
+			return NULL;
+		mm_channelmpsc_collect(channel);
+	}
+	mm_list_t *next;
+	next = mm_list_pop(&channel->msg_list);
+	channel->msg_list_count--;
+	return mm_container_of(next, mm_msg_t, link);
+}
+
+void mm_channelmpsc_free(mm_channelmpsc_t *channel)
+{
+	mm_msg_t *msg;
+	while ((msg = mm_channelmpsc_pop(channel)))
+		mm_msg_unref(mm_self->msg_cache, msg);
+}
+
+static inline void
+mm_channelmpsc_push(mm_channelmpsc_t *channel, mm_msg_t *first, mm_msg_t *last)
+{
+	/* push chain of messages linked from last to first */
+	mm_msg_t *head;
+	do {
+		head = mm_channelmpsc_incoming(channel);
+		first->link.next = NULL;
+		if (head)
+			first->link.next = &head->link;
+	} while (! __sync_bool_compare_and_swap(&channel->incoming, head, last));
+
+	/* wakeup reader, unless it is already signaled or running */
+	if (mm_channelmpsc_state(channel) != MM_CHANNELMPSC_WAIT)
+		return;
+	if (! __sync_bool_compare_and_swap(&channel->reader_state,
+	                                   MM_CHANNELMPSC_WAIT,
+	                                   MM_CHANNELMPSC_SIGNAL))
+		return;
+	int event_mgr_fd;
+	event_mgr_fd = mm_eventmgr_signal(channel->reader);
+	__sync_bool_compare_and_swap(&channel->reader_state,
+	                             MM_CHANNELMPSC_SIGNAL,
+	                             MM_CHANNELMPSC_SIGNALED);
+	if (event_mgr_fd > 0)
+		mm_eventmgr_wakeup(event_mgr_fd);
+}
+
+void mm_channelmpsc_write(mm_channelmpsc_t *channel, mm_msg_t *msg)
+{
+	mm_channelmpsc_push(channel, msg, msg);
+}
+
+void mm_channelmpsc_write_batch(mm_channelmpsc_t *channel, mm_msg_t **msgs,
+                                int count)
+{
+	if (count == 0)
+		return;
+	int i;
+	for (i = 1; i < count; i++)
+		msgs[i]->link.next = &msgs[i - 1]->link;
+	mm_channelmpsc_push(channel, msgs[0], msgs[count - 1]);
+}
+
+static inline void
+mm_channelmpsc_unwait(mm_channelmpsc_t *channel)
+{
+	/* make sure no writer is using the reader event */
+	unsigned int spin_count = 0U;
+	for (;;) {
+		if (__sync_bool_compare_and_swap(&channel->reader_state,
+		                                 MM_CHANNELMPSC_WAIT,
+		                                 MM_CHANNELMPSC_IDLE))
+			break;
+		if (__sync_bool_compare_and_swap(&channel->reader_state,
+		                                 MM_CHANNELMPSC_SIGNALED,
+		                                 MM_CHANNELMPSC_IDLE))
+			break;
+		MM_SLEEPLOCK_BACKOFF;
+		if (++spin_count > 30U)
+			usleep(1);
+	}
+	channel->reader = NULL;
+}
+
+mm_msg_t*
+mm_channelmpsc_read(mm_channelmpsc_t *channel, uint32_t time_ms)
+{
+	mm_errno_set(0);
+	if (channel->reader) {
+		mm_errno_set(EINPROGRESS);
+		return NULL;
+	}
+	mm_msg_t *msg;
+	msg = mm_channelmpsc_pop(channel);
+	if (msg)
+		return msg;
+
+	/* register reader and wait for writer event */
+	mm_event_t event;
+	mm_eventmgr_add(&mm_self->event_mgr, &event);
+	channel->reader = &event;
+	__sync_bool_compare_and_swap(&channel->reader_state,
+	                             MM_CHANNELMPSC_IDLE,
+	                             MM_CHANNELMPSC_WAIT);
+
+	/* check again for writes done before reader registration */
+	if (mm_channelmpsc_incoming(channel) == NULL)
+		mm_call(&event.call, MM_CALL_EVENT, time_ms);
+	else
+		event.call.status = 0;
+
+	mm_channelmpsc_unwait(channel);
+	mm_eventmgr_del(&mm_self->event_mgr, &event);
+
+	/* timedout or cancel */
+	int status = event.call.status;
+	if (status != 0) {
+		mm_errno_set(status);
+		return NULL;
+	}
+	return mm_channelmpsc_pop(channel);
+}
+
+int mm_channelmpsc_read_batch(mm_channelmpsc_t *channel, mm_msg_t **msgs,
+                              int max, uint32_t time_ms)
+{
+	int count = 0;
+	mm_msg_t *msg;
+	msg = mm_channelmpsc_read(channel, time_ms);
+	if (msg == NULL)
+		return -1;
+	msgs[count++] = msg;
+	while (count < max) {
+		msg = mm_channelmpsc_pop(channel);
+		if (msg == NULL)
+			break;
+		msgs[count++] = msg;
+	}
+	return count;
+}
@@ -0,0 +1,40 @@
+#ifndef MM_CHANNEL_MPSC_H
+#define MM_CHANNEL_MPSC_H
+
+/*
+ * machinarium.
+ *
+ * cooperative multitasking engine.
+*/
+
+typedef struct mm_channelmpsc mm_channelmpsc_t;
+
+enum
+{
+	MM_CHANNELMPSC_IDLE,
+	MM_CHANNELMPSC_WAIT,
+	MM_CHANNELMPSC_SIGNAL,
+	MM_CHANNELMPSC_SIGNALED
+};
+
+struct mm_channelmpsc
+{
+	mm_channeltype_t  type;
+	mm_msg_t         *incoming;
+	mm_list_t         msg_list;
+	int               msg_list_count;
+	mm_event_t       *reader;
+	int               reader_state;
+};
+
+void mm_channelmpsc_init(mm_channelmpsc_t*);
+void mm_channelmpsc_free(mm_channelmpsc_t*);
+void mm_channelmpsc_write(mm_channelmpsc_t*, mm_msg_t*);
+
+mm_msg_t*
+mm_channelmpsc_read(mm_channelmpsc_t*, uint32_t);
+
+void mm_channelmpsc_write_batch(mm_channelmpsc_t*, mm_msg_t**, int);
+int  mm_channelmpsc_read_batch(mm_channelmpsc_t*, mm_msg_t**, int, uint32_t);
+
+#endif /* MM_CHANNEL_MPSC_H */
@@ -9,9 +9,16 @@
 
 typedef struct mm_channeltype mm_channeltype_t;
 
+enum
+{
+	MM_CHANNEL_FAST   = MACHINE_CHANNEL_FAST,
+	MM_CHANNEL_SHARED = MACHINE_CHANNEL_SHARED,
+	MM_CHANNEL_MPSC   = MACHINE_CHANNEL_MPSC
+};
+
 struct mm_channeltype
 {
-	int is_shared;
+	int type;
 } __attribute__((packed));
 
 #endif /* MM_CHANNEL_TYPE_H */
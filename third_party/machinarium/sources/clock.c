@@ -8,18 +8,93 @@
 #include <machinarium.h>
 #include <machinarium_private.h>
 
-static int
-mm_clock_cmp(const void *a_ptr, const void *b_ptr)
+/*
+ * Timers are kept in a 4-ary min-heap ordered by timeout and
+ * insertion sequence. Each timer stores its heap position, so both
+ * insert and removal are O(log n).
+*/
+
+#define MM_CLOCK_HEAP_D 4
+
+static inline int
+mm_clock_less(mm_timer_t *a, mm_timer_t *b)
+{
+	if (a->timeout == b->timeout)
+		return a->seq < b->seq;
+	return a->timeout < b->timeout;
+}
+
+static inline mm_timer_t**
+mm_clock_heap(mm_clock_t *clock)
+{
+	return (mm_timer_t**)clock->timers.start;
+}
+
+static inline void
+mm_clock_heap_set(mm_timer_t **heap, int pos, mm_timer_t *timer)
+{
+	heap[pos] = timer;
+	timer->index = pos;
+}
+
+static void
+mm_clock_heap_up(mm_timer_t **heap, int pos)
+{
+	mm_timer_t *timer = heap[pos];
+	while (pos > 0) {
+		int parent = (pos - 1) / MM_CLOCK_HEAP_D;
+		if (! mm_clock_less(timer, heap[parent]))
+			break;
+		mm_clock_heap_set(heap, pos, heap[parent]);
+		pos = parent;
+	}
+	mm_clock_heap_set(heap, pos, timer);
+}
+
+static void
+mm_clock_heap_down(mm_timer_t **heap, int count, int pos)
 {
-	mm_timer_t *a = *(mm_timer_t**)a_ptr;
-	mm_timer_t *b = *(mm_timer_t**)b_ptr;
-	if (a->timeout == b->timeout) {
-		return (a->seq > b->seq) ? 1 : -1;
-	} else
-	if (a->timeout > b->timeout) {
-		return 1;
+	mm_timer_t *timer = heap[pos];
+	for (;;) {
+		int child = pos * MM_CLOCK_HEAP_D + 1;
+		if (child >= count)
+			break;
+		int last = child + MM_CLOCK_HEAP_D;
+		if (last > count)
+			last = count;
+		int min = child;
+		for (child++; child < last; child++) {
+			if (mm_clock_less(heap[child], heap[min]))
+				min = child;
+		}
+		if (! mm_clock_less(heap[min], timer))
+			break;
+		mm_clock_heap_set(heap, pos, heap[min]);
+		pos = min;
 	}
-	return -1;
+	mm_clock_heap_set(heap, pos, timer);
+}
+
+static void
+mm_clock_heap_remove(mm_clock_t *clock, mm_timer_t *timer)
+{
+	mm_timer_t **heap = mm_clock_heap(clock);
+	int pos = timer->index;
+	int last = clock->timers_count - 1;
+	assert(pos >= 0 && pos <= last);
+	assert(heap[pos] == timer);
+	clock->timers.pos -= sizeof(mm_timer_t*);
+	clock->timers_count = last;
+	timer->active = 0;
+	timer->index = -1;
+	if (pos == last)
+		return;
+	mm_timer_t *moved = heap[last];
+	mm_clock_heap_set(heap, pos, moved);
+	if (pos > 0 && mm_clock_less(moved, heap[(pos - 1) / MM_CLOCK_HEAP_D]))
+		mm_clock_heap_up(heap, pos);
+	else
+		mm_clock_heap_down(heap, last, pos);
 }
 
 void mm_clock_init(mm_clock_t *clock)
@@ -43,20 +118,18 @@ int mm_clock_timer_add(mm_clock_t *clock, mm_timer_t *timer)
 {
 	int count = clock->timers_count + 1;
 	int rc;
-	rc = mm_buf_ensure(&clock->timers, count * sizeof(mm_timer_t*));
+	rc = mm_buf_ensure(&clock->timers, sizeof(mm_timer_t*));
 	if (rc == -1)
 		return -1;
-	mm_timer_t **list;
-	list = (mm_timer_t**)clock->timers.start;
-	list[count - 1] = timer;
 	mm_buf_advance(&clock->timers, sizeof(mm_timer_t*));
 	timer->seq = clock->timers_seq++;
 	timer->timeout = clock->time_ms + timer->interval;
 	timer->active = 1;
 	timer->clock = clock;
-	qsort(list, count, sizeof(mm_timer_t*),
-	      mm_clock_cmp);
 	clock->timers_count = count;
+	mm_timer_t **heap = mm_clock_heap(clock);
+	mm_clock_heap_set(heap, count - 1, timer);
+	mm_clock_heap_up(heap, count - 1);
 	return 0;
 }
 
@@ -65,19 +138,7 @@ int mm_clock_timer_del(mm_clock_t *clock, mm_timer_t *timer)
 	if (! timer->active)
 		return -1;
 	assert(clock->timers_count >= 1);
-	mm_timer_t **list;
-	list = (mm_timer_t**)clock->timers.start;
-	int i = 0;
-	int j = 0;
-	for (; i < clock->timers_count; i++) {
-		if (list[i] == timer)
-			continue;
-		list[j] = list[i];
-		j++;
-	}
-	timer->active = 0;
-	clock->timers.pos -= sizeof(mm_timer_t*);
-	clock->timers_count -= 1;
+	mm_clock_heap_remove(clock, timer);
 	return 0;
 }
 
@@ -86,46 +147,21 @@ mm_clock_timer_min(mm_clock_t *clock)
 {
 	if (clock->timers_count == 0)
 		return NULL;
-	mm_timer_t **list;
-	list = (mm_timer_t**)clock->timers.start;
-	return list[0];
+	return mm_clock_heap(clock)[0];
 }
 
 int mm_clock_step(mm_clock_t *clock)
 {
-	if (clock->timers_count == 0)
-		return 0;
-	mm_timer_t **list;
-	list = (mm_timer_t**)clock->timers.start;
 	int timers_hit = 0;
-	int i = 0;
-	int j = 0;
-	for (; i < clock->timers_count; i++) {
-		mm_timer_t *timer = list[i];
+	while (clock->timers_count > 0)
+	{
+		mm_timer_t *timer = mm_clock_heap(clock)[0];
 		if (timer->timeout > clock->time_ms)
 			break;
+		mm_clock_heap_remove(clock, timer);
 		timer->callback(timer);
-		timer->active = 0;
 		timers_hit++;
-		list[i] = NULL;
-	}
-	if (! timers_hit)
-		return 0;
-	int timers_left = clock->timers_count - timers_hit;
-	if (timers_left == 0) {
-		mm_buf_reset(&clock->timers);
-		clock->timers_count = 0;
-		return timers_hit;
-	}
-	i = 0;
-	for (; i < clock->timers_count; i++) {
-		if (list[i] == NULL)
-			continue;
-		list[j] = list[i];
-		j++;
 	}
-	clock->timers.pos -= sizeof(mm_timer_t*) * timers_hit;
-	clock->timers_count -= timers_hit;
 	return timers_hit;
 }
 
@@ -12,18 +12,15 @@
 #  include <valgrind/valgrind.h>
 #endif
 
-int mm_contextstack_create(mm_contextstack_t *stack, size_t size, size_t size_guard)
+int mm_contextstack_create(mm_contextstack_t *stack, mm_stackarena_t *arena)
 {
-	char *base;
-	base = mmap(0, size_guard + size, PROT_READ|PROT_WRITE|PROT_EXEC,
-	            MAP_PRIVATE|MAP_ANONYMOUS, -1, 0);
-	if (base == MAP_FAILED)
+	mm_stackslot_t *slot;
+	slot = mm_stackarena_pop(arena);
+	if (slot == NULL)
 		return -1;
-	mprotect(base, size_guard, PROT_NONE);
-	base += size_guard;
-	stack->pointer = base;
-	stack->size = size;
-	stack->size_guard = size_guard;
+	stack->pointer = slot->pointer;
+	stack->size = arena->size;
+	stack->slot = slot;
 #ifdef HAVE_VALGRIND
 	stack->valgrind_stack =
 		VALGRIND_STACK_REGISTER(stack->pointer, stack->pointer + stack->size);
@@ -38,6 +35,6 @@ void mm_contextstack_free(mm_contextstack_t *stack)
 #ifdef HAVE_VALGRIND
 	VALGRIND_STACK_DEREGISTER(stack->valgrind_stack);
 #endif
-	char *base = stack->pointer - stack->size_guard;
-	munmap(base, stack->size_guard + stack->size);
+	mm_stackslot_t *slot = stack->slot;
+	mm_stackarena_push(slot->chunk->arena, slot);
 }
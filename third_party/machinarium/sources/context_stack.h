@@ -11,15 +11,15 @@ typedef struct mm_contextstack mm_contextstack_t;
 
 struct mm_contextstack
 {
-	char   *pointer;
-	size_t  size;
-	size_t  size_guard;
+	char           *pointer;
+	size_t          size;
+	mm_stackslot_t *slot;
 #ifdef HAVE_VALGRIND
-	int     valgrind_stack;
+	int             valgrind_stack;
 #endif
 };
 
-int  mm_contextstack_create(mm_contextstack_t*, size_t, size_t);
+int  mm_contextstack_create(mm_contextstack_t*, mm_stackarena_t*);
 void mm_contextstack_free(mm_contextstack_t*);
 
 #endif /* MM_CONTEXT_STACK_H */
@@ -18,10 +18,11 @@ void mm_coroutine_init(mm_coroutine_t *coroutine)
 	mm_list_init(&coroutine->joiners);
 	mm_list_init(&coroutine->link);
 	mm_list_init(&coroutine->link_join);
+	mm_list_init(&coroutine->link_id);
 }
 
 mm_coroutine_t*
-mm_coroutine_allocate(int stack_size, int stack_size_guard)
+mm_coroutine_allocate(mm_stackarena_t *arena)
 {
 	mm_coroutine_t *coroutine;
 	coroutine = malloc(sizeof(mm_coroutine_t));
@@ -29,7 +30,7 @@ mm_coroutine_allocate(int stack_size, int stack_size_guard)
 		return NULL;
 	mm_coroutine_init(coroutine);
 	int rc;
-	rc = mm_contextstack_create(&coroutine->stack, stack_size, stack_size_guard);
+	rc = mm_contextstack_create(&coroutine->stack, arena);
 	if (rc == -1) {
 		free(coroutine);
 		return NULL;
@@ -33,11 +33,12 @@ struct mm_coroutine
 	void               *call_ptr;
 	mm_list_t           joiners;
 	mm_list_t           link_join;
+	mm_list_t           link_id;
 	mm_list_t           link;
 };
 
 mm_coroutine_t*
-mm_coroutine_allocate(int, int);
+mm_coroutine_allocate(mm_stackarena_t*);
 
 void mm_coroutine_init(mm_coroutine_t*);
 void mm_coroutine_free(mm_coroutine_t*);
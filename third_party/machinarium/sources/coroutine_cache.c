@@ -8,17 +8,19 @@
 #include <machinarium.h>
 #include <machinarium_private.h>
 
-void mm_coroutine_cache_init(mm_coroutine_cache_t *cache,
-                             int stack_size,
-                             int stack_size_guard,
-                             int limit)
+int mm_coroutine_cache_init(mm_coroutine_cache_t *cache,
+                            int stack_size,
+                            int page_size,
+                            int hugepages,
+                            int guard,
+                            int limit)
 {
 	mm_list_init(&cache->list);
 	cache->count_free = 0;
 	cache->count_total = 0;
-	cache->stack_size = stack_size;
-	cache->stack_size_guard = stack_size_guard;
 	cache->limit = limit;
+	return mm_stackarena_init(&cache->arena, stack_size, page_size,
+	                          hugepages, guard);
 }
 
 void mm_coroutine_cache_free(mm_coroutine_cache_t *cache)
@@ -29,6 +31,7 @@ void mm_coroutine_cache_free(mm_coroutine_cache_t *cache)
 		coroutine = mm_container_of(i, mm_coroutine_t, link);
 		mm_coroutine_free(coroutine);
 	}
+	mm_stackarena_free(&cache->arena);
 }
 
 void mm_coroutine_cache_stat(mm_coroutine_cache_t *cache,
@@ -51,7 +54,7 @@ mm_coroutine_cache_pop(mm_coroutine_cache_t *cache)
 	}
 	cache->count_total++;
 
-	coroutine = mm_coroutine_allocate(cache->stack_size, cache->stack_size_guard);
+	coroutine = mm_coroutine_allocate(&cache->arena);
 	if (coroutine == NULL)
 		cache->count_total--;
 	return coroutine;
@@ -8,19 +8,349 @@
 #include <machinarium.h>
 #include <machinarium_private.h>
 
-typedef struct {
+/*
+ * Resolved addresses are cached per (address, service, hints) with
+ * ttl_ms, failures are cached with negative_ttl_ms. Entry which is
+ * close to expiration is refreshed by a resolver thread in the
+ * background, while callers keep using the cached result.
+ *
+ * Cache is disabled, when ttl_ms is zero.
+*/
+
+typedef struct
+{
+	int              refs;
+	int              refresh;
 	char            *addr;
 	char            *service;
-	struct addrinfo *hints;
-	struct addrinfo **res;
-	int             rc;
-} mm_getaddrinfo_t;
+	struct addrinfo  hints;
+	int              hints_set;
+	int              rc;
+	struct addrinfo *ai;
+} mm_dnsreq_t;
+
+static inline uint64_t
+mm_dns_time_ms(void)
+{
+	struct timespec t;
+	clock_gettime(CLOCK_MONOTONIC, &t);
+	return t.tv_sec * (uint64_t)1000 + t.tv_nsec / 1000000;
+}
+
+static inline void
+mm_addrinfo_free(struct addrinfo *ai)
+{
+	while (ai) {
+		struct addrinfo *next = ai->ai_next;
+		if (ai->ai_canonname)
+			free(ai->ai_canonname);
+		free(ai);
+		ai = next;
+	}
+}
+
+static struct addrinfo*
+mm_addrinfo_copy(struct addrinfo *ai)
+{
+	struct addrinfo *head = NULL;
+	struct addrinfo **tail = &head;
+	for (; ai; ai = ai->ai_next) {
+		struct addrinfo *copy;
+		copy = malloc(sizeof(struct addrinfo) + ai->ai_addrlen);
+		if (copy == NULL)
+			goto error;
+		*copy = *ai;
+		copy->ai_next = NULL;
+		copy->ai_canonname = NULL;
+		copy->ai_addr = (struct sockaddr*)(copy + 1);
+		memcpy(copy->ai_addr, ai->ai_addr, ai->ai_addrlen);
+		*tail = copy;
+		tail = &copy->ai_next;
+		if (ai->ai_canonname) {
+			copy->ai_canonname = strdup(ai->ai_canonname);
+			if (copy->ai_canonname == NULL)
+				goto error;
+		}
+	}
+	return head;
+error:
+	mm_addrinfo_free(head);
+	return NULL;
+}
+
+static inline int
+mm_dns_strcmp(char *a, char *b)
+{
+	if (a == NULL || b == NULL)
+		return a != b;
+	return strcmp(a, b);
+}
+
+static inline int
+mm_dns_match(mm_dnsentry_t *entry, mm_dnsreq_t *req)
+{
+	if (entry->hints_set != req->hints_set)
+		return 0;
+	if (entry->hints_set) {
+		if (entry->hints.ai_family   != req->hints.ai_family ||
+		    entry->hints.ai_socktype != req->hints.ai_socktype ||
+		    entry->hints.ai_protocol != req->hints.ai_protocol ||
+		    entry->hints.ai_flags    != req->hints.ai_flags)
+			return 0;
+	}
+	return !mm_dns_strcmp(entry->addr, req->addr) &&
+	       !mm_dns_strcmp(entry->service, req->service);
+}
+
+static inline mm_dnsentry_t*
+mm_dns_find(mm_dns_t *dns, mm_dnsreq_t *req)
+{
+	mm_list_t *i;
+	mm_list_foreach(&dns->list, i) {
+		mm_dnsentry_t *entry;
+		entry = mm_container_of(i, mm_dnsentry_t, link);
+		if (mm_dns_match(entry, req))
+			return entry;
+	}
+	return NULL;
+}
+
+static inline void
+mm_dnsentry_free(mm_dnsentry_t *entry)
+{
+	if (entry->addr)
+		free(entry->addr);
+	if (entry->service)
+		free(entry->service);
+	mm_addrinfo_free(entry->ai);
+	free(entry);
+}
+
+void mm_dns_init(mm_dns_t *dns, uint32_t ttl_ms, uint32_t negative_ttl_ms)
+{
+	mm_sleeplock_init(&dns->lock);
+	mm_list_init(&dns->list);
+	dns->count           = 0;
+	dns->ttl_ms          = ttl_ms;
+	dns->negative_ttl_ms = negative_ttl_ms;
+	dns->count_hit       = 0;
+	dns->count_miss      = 0;
+	dns->count_refresh   = 0;
+	dns->count_resolve   = 0;
+	dns->resolve_time_us = 0;
+}
+
+void mm_dns_free(mm_dns_t *dns)
+{
+	mm_list_t *i, *n;
+	mm_list_foreach_safe(&dns->list, i, n) {
+		mm_dnsentry_t *entry;
+		entry = mm_container_of(i, mm_dnsentry_t, link);
+		mm_dnsentry_free(entry);
+	}
+	mm_list_init(&dns->list);
+	dns->count = 0;
+}
+
+static mm_dnsreq_t*
+mm_dnsreq_create(char *addr, char *service, struct addrinfo *hints)
+{
+	mm_dnsreq_t *req;
+	req = malloc(sizeof(mm_dnsreq_t));
+	if (req == NULL)
+		return NULL;
+	memset(req, 0, sizeof(*req));
+	req->refs = 1;
+	if (hints) {
+		req->hints_set = 1;
+		req->hints.ai_family   = hints->ai_family;
+		req->hints.ai_socktype = hints->ai_socktype;
+		req->hints.ai_protocol = hints->ai_protocol;
+		req->hints.ai_flags    = hints->ai_flags;
+	}
+	if (addr) {
+		req->addr = strdup(addr);
+		if (req->addr == NULL)
+			goto error;
+	}
+	if (service) {
+		req->service = strdup(service);
+		if (req->service == NULL)
+			goto error;
+	}
+	return req;
+error:
+	if (req->addr)
+		free(req->addr);
+	free(req);
+	return NULL;
+}
+
+static void
+mm_dnsreq_unref(mm_dnsreq_t *req)
+{
+	if (__sync_sub_and_fetch(&req->refs, 1) > 0)
+		return;
+	if (req->ai)
+		freeaddrinfo(req->ai);
+	if (req->addr)
+		free(req->addr);
+	if (req->service)
+		free(req->service);
+	free(req);
+}
+
+static void
+mm_dns_update(mm_dns_t *dns, mm_dnsreq_t *req)
+{
+	struct addrinfo *ai = NULL;
+	if (req->rc == 0) {
+		ai = mm_addrinfo_copy(req->ai);
+		if (ai == NULL)
+			return;
+	}
+
+	mm_dnsentry_t *evicted = NULL;
+	mm_sleeplock_lock(&dns->lock);
+
+	mm_dnsentry_t *entry;
+	entry = mm_dns_find(dns, req);
+	if (entry) {
+		/* keep previous addresses on background refresh failure,
+		 * entry expires as usual */
+		if (req->refresh && req->rc != 0 && entry->rc == 0) {
+			entry->refreshing = 0;
+			mm_sleeplock_unlock(&dns->lock);
+			return;
+		}
+		mm_list_unlink(&entry->link);
+		dns->count--;
+		mm_addrinfo_free(entry->ai);
+	} else {
+		entry = malloc(sizeof(mm_dnsentry_t));
+		if (entry == NULL) {
+			mm_sleeplock_unlock(&dns->lock);
+			mm_addrinfo_free(ai);
+			return;
+		}
+		/* entry takes the key strings */
+		entry->addr = req->addr;
+		entry->service = req->service;
+		req->addr = NULL;
+		req->service = NULL;
+		entry->hints = req->hints;
+		entry->hints_set = req->hints_set;
+
+		/* evict least recently resolved entry */
+		if (dns->count >= MM_DNS_CACHE_MAX) {
+			mm_list_t *first = dns->list.next;
+			evicted = mm_container_of(first, mm_dnsentry_t, link);
+			mm_list_unlink(&evicted->link);
+			dns->count--;
+		}
+	}
+	entry->rc = req->rc;
+	entry->ai = ai;
+	entry->time_resolved = mm_dns_time_ms();
+	entry->refreshing = 0;
+	mm_list_append(&dns->list, &entry->link);
+	dns->count++;
+
+	mm_sleeplock_unlock(&dns->lock);
+
+	if (evicted)
+		mm_dnsentry_free(evicted);
+}
 
 static void
-mm_getaddrinfo_cb(void *arg)
+mm_dns_resolve_cb(void *arg)
+{
+	mm_dnsreq_t *req = arg;
+	mm_dns_t *dns = &machinarium.dns;
+
+	struct timespec t0, t1;
+	clock_gettime(CLOCK_MONOTONIC, &t0);
+	req->rc = mm_socket_getaddrinfo(req->addr, req->service,
+	                                req->hints_set ? &req->hints : NULL,
+	                                &req->ai);
+	clock_gettime(CLOCK_MONOTONIC, &t1);
+	uint64_t time_us;
+	time_us = (t1.tv_sec - t0.tv_sec) * (uint64_t)1000000 +
+	          (t1.tv_nsec - t0.tv_nsec) / 1000;
+	__sync_fetch_and_add(&dns->count_resolve, 1);
+	__sync_fetch_and_add(&dns->resolve_time_us, time_us);
+
+	if (dns->ttl_ms > 0)
+		mm_dns_update(dns, req);
+
+	mm_dnsreq_unref(req);
+}
+
+static inline void
+mm_dns_refresh(mm_dns_t *dns, mm_dnsreq_t *req)
+{
+	__sync_fetch_and_add(&dns->count_refresh, 1);
+	mm_dnsreq_t *refresh;
+	refresh = mm_dnsreq_create(req->addr, req->service,
+	                           req->hints_set ? &req->hints : NULL);
+	if (refresh) {
+		refresh->refresh = 1;
+		int rc;
+		rc = mm_taskmgr_post(&machinarium.task_mgr, mm_dns_resolve_cb,
+		                     refresh);
+		if (rc == 0)
+			return;
+		mm_dnsreq_unref(refresh);
+	}
+	/* retry on next lookup */
+	mm_sleeplock_lock(&dns->lock);
+	mm_dnsentry_t *entry;
+	entry = mm_dns_find(dns, req);
+	if (entry)
+		entry->refreshing = 0;
+	mm_sleeplock_unlock(&dns->lock);
+}
+
+static int
+mm_dns_lookup(mm_dns_t *dns, mm_dnsreq_t *req, struct addrinfo **res)
 {
-	mm_getaddrinfo_t *gai = arg;
-	gai->rc = mm_socket_getaddrinfo(gai->addr, gai->service, gai->hints, gai->res);
+	uint64_t now = mm_dns_time_ms();
+	mm_sleeplock_lock(&dns->lock);
+
+	mm_dnsentry_t *entry;
+	entry = mm_dns_find(dns, req);
+	if (entry == NULL)
+		goto miss;
+	uint64_t age = now - entry->time_resolved;
+	if (entry->rc != 0) {
+		if (age >= dns->negative_ttl_ms)
+			goto miss;
+		req->rc = entry->rc;
+		mm_sleeplock_unlock(&dns->lock);
+		__sync_fetch_and_add(&dns->count_hit, 1);
+		return 0;
+	}
+	if (age >= dns->ttl_ms)
+		goto miss;
+
+	/* refresh entry in background, ahead of expiration */
+	int refresh = 0;
+	if (age >= dns->ttl_ms - dns->ttl_ms / 4 && !entry->refreshing) {
+		entry->refreshing = 1;
+		refresh = 1;
+	}
+	*res = mm_addrinfo_copy(entry->ai);
+	req->rc = *res ? 0 : EAI_MEMORY;
+	mm_sleeplock_unlock(&dns->lock);
+	__sync_fetch_and_add(&dns->count_hit, 1);
+
+	if (refresh)
+		mm_dns_refresh(dns, req);
+	return 0;
+miss:
+	mm_sleeplock_unlock(&dns->lock);
+	__sync_fetch_and_add(&dns->count_miss, 1);
+	return -1;
 }
 
 MACHINE_API int
@@ -29,18 +359,63 @@ machine_getaddrinfo(char *addr, char *service,
                     struct addrinfo **res,
                     uint32_t time_ms)
 {
-	mm_getaddrinfo_t gai = {
-		.addr = addr,
-		.service = service,
-		.hints = hints,
-		.res = res,
-		.rc = 0
-	};
+	mm_dns_t *dns = &machinarium.dns;
+	mm_errno_set(0);
+	*res = NULL;
+	mm_dnsreq_t *req;
+	req = mm_dnsreq_create(addr, service, hints);
+	if (req == NULL) {
+		mm_errno_set(ENOMEM);
+		return -1;
+	}
+
 	int rc;
-	rc = mm_taskmgr_new(&machinarium.task_mgr, mm_getaddrinfo_cb, &gai, time_ms);
-	if (rc == -1)
+	if (dns->ttl_ms > 0) {
+		rc = mm_dns_lookup(dns, req, res);
+		if (rc == 0) {
+			rc = req->rc;
+			mm_dnsreq_unref(req);
+			return rc;
+		}
+	}
+
+	/* resolver thread keeps its own reference, which outlives
+	 * the waiter on timeout */
+	__sync_fetch_and_add(&req->refs, 1);
+	rc = mm_taskmgr_new(&machinarium.task_mgr, mm_dns_resolve_cb, req, time_ms);
+	if (rc == -1) {
+		/* task is not scheduled */
+		if (mm_errno_get() != ETIMEDOUT && mm_errno_get() != ECANCELED)
+			mm_dnsreq_unref(req);
+		mm_dnsreq_unref(req);
 		return -1;
-	return gai.rc;
+	}
+	rc = req->rc;
+	if (rc == 0) {
+		*res = mm_addrinfo_copy(req->ai);
+		if (*res == NULL)
+			rc = EAI_MEMORY;
+	}
+	mm_dnsreq_unref(req);
+	return rc;
+}
+
+MACHINE_API void
+machine_freeaddrinfo(struct addrinfo *ai)
+{
+	mm_addrinfo_free(ai);
+}
+
+MACHINE_API void
+machine_dns_stat(uint64_t *hit, uint64_t *miss, uint64_t *refresh,
+                 uint64_t *resolve_count, uint64_t *resolve_time_us)
+{
+	mm_dns_t *dns = &machinarium.dns;
+	*hit             = __sync_fetch_and_add(&dns->count_hit, 0);
+	*miss            = __sync_fetch_and_add(&dns->count_miss, 0);
+	*refresh         = __sync_fetch_and_add(&dns->count_refresh, 0);
+	*resolve_count   = __sync_fetch_and_add(&dns->count_resolve, 0);
+	*resolve_time_us = __sync_fetch_and_add(&dns->resolve_time_us, 0);
 }
 
 MACHINE_API int
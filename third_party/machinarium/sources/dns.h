@@ -0,0 +1,45 @@
+#ifndef MM_DNS_H
+#define MM_DNS_H
+
+/*
+ * machinarium.
+ *
+ * cooperative multitasking engine.
+*/
+
+typedef struct mm_dnsentry mm_dnsentry_t;
+typedef struct mm_dns      mm_dns_t;
+
+#define MM_DNS_CACHE_MAX 256
+
+struct mm_dnsentry
+{
+	char            *addr;
+	char            *service;
+	struct addrinfo  hints;
+	int              hints_set;
+	int              rc;
+	struct addrinfo *ai;
+	uint64_t         time_resolved;
+	int              refreshing;
+	mm_list_t        link;
+};
+
+struct mm_dns
+{
+	mm_sleeplock_t lock;
+	mm_list_t      list;
+	int            count;
+	uint32_t       ttl_ms;
+	uint32_t       negative_ttl_ms;
+	uint64_t       count_hit;
+	uint64_t       count_miss;
+	uint64_t       count_refresh;
+	uint64_t       count_resolve;
+	uint64_t       resolve_time_us;
+};
+
+void mm_dns_init(mm_dns_t*, uint32_t, uint32_t);
+void mm_dns_free(mm_dns_t*);
+
+#endif /* MM_DNS_H */
@@ -49,6 +49,8 @@ int mm_eventmgr_init(mm_eventmgr_t *mgr, mm_loop_t *loop)
 	mm_list_init(&mgr->list_wait);
 	mgr->count_ready = 0;
 	mgr->count_wait = 0;
+	mgr->count_wakeup = 0;
+	mgr->count_wakeup_coalesced = 0;
 
 	memset(&mgr->fd, 0, sizeof(mgr->fd));
 	mgr->fd.fd = mm_socket_eventfd(0);
@@ -99,7 +101,11 @@ int mm_eventmgr_wait(mm_eventmgr_t *mgr, mm_event_t *event, uint32_t time_ms)
 {
 	/* wait for event */
 	mm_call(&event->call, MM_CALL_EVENT, time_ms);
+	return mm_eventmgr_del(mgr, event);
+}
 
+int mm_eventmgr_del(mm_eventmgr_t *mgr, mm_event_t *event)
+{
 	/* maybe remove from wait list */
 	mm_sleeplock_lock(&mgr->lock);
 
@@ -136,9 +142,15 @@ int mm_eventmgr_signal(mm_event_t *event)
 		mm_sleeplock_unlock(&mgr->lock);
 		return 0;
 	}
+	/* machine is woken up only by the first ready event, the rest
+	 * are handled by the same eventfd read */
 	int fd = 0;
-	if (mgr->count_ready == 0)
+	if (mgr->count_ready == 0) {
+		mgr->count_wakeup++;
 		fd = mgr->fd.fd;
+	} else {
+		mgr->count_wakeup_coalesced++;
+	}
 	assert(event->state == MM_EVENT_WAIT);
 	mm_list_unlink(&event->link);
 	mgr->count_wait--;
@@ -159,3 +171,12 @@ void mm_eventmgr_wakeup(int fd)
 	(void)rc;
 	assert(rc == sizeof(id));
 }
+
+void mm_eventmgr_stat(mm_eventmgr_t *mgr, uint64_t *count_wakeup,
+                      uint64_t *count_wakeup_coalesced)
+{
+	mm_sleeplock_lock(&mgr->lock);
+	*count_wakeup = mgr->count_wakeup;
+	*count_wakeup_coalesced = mgr->count_wakeup_coalesced;
+	mm_sleeplock_unlock(&mgr->lock);
+}
@@ -17,13 +17,17 @@ struct mm_eventmgr_t
 	mm_list_t      list_wait;
 	int            count_ready;
 	int            count_wait;
+	uint64_t       count_wakeup;
+	uint64_t       count_wakeup_coalesced;
 };
 
 int  mm_eventmgr_init(mm_eventmgr_t*, mm_loop_t*);
 void mm_eventmgr_free(mm_eventmgr_t*, mm_loop_t*);
 void mm_eventmgr_add(mm_eventmgr_t*, mm_event_t*);
 int  mm_eventmgr_wait(mm_eventmgr_t*, mm_event_t*, uint32_t);
+int  mm_eventmgr_del(mm_eventmgr_t*, mm_event_t*);
 int  mm_eventmgr_signal(mm_event_t*);
 void mm_eventmgr_wakeup(int);
+void mm_eventmgr_stat(mm_eventmgr_t*, uint64_t*, uint64_t*);
 
 #endif /* MM_EVENT_MGR_H */
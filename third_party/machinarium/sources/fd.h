@@ -21,6 +21,7 @@ struct mm_fd
 {
 	int               fd;
 	int               mask;
+	int               poll_id;
 	mm_fd_callback_t  on_read;
 	void             *on_read_arg;
 	mm_fd_callback_t  on_write;
@@ -25,11 +25,17 @@ machine_io_create(void)
 
 	/* read */
 	io->readahead_size = 0;
-	mm_buf_init(&io->readahead_buf);
+	io->readahead_buf = NULL;
+
+	/* splice */
+	io->splice_pipe[0] = -1;
+	io->splice_pipe[1] = -1;
+	io->splice_pipe_size = 0;
 
 	/* write */
 	mm_list_init(&io->write_queue);
 	mm_buf_init(&io->write_iov);
+	mm_list_init(&io->zerocopy_queue);
 	return (machine_io_t*)io;
 }
 
@@ -38,7 +44,11 @@ machine_io_free(machine_io_t *obj)
 {
 	mm_io_t *io = mm_cast(mm_io_t*, obj);
 	mm_errno_set(0);
-	mm_buf_free(&io->readahead_buf);
+	if (io->poll_group)
+		mm_pollgroup_unlink(io);
+	mm_splice_free(io);
+	if (io->readahead_buf)
+		mm_msg_shared_unref(io->readahead_buf);
 	mm_buf_free(&io->write_iov);
 	mm_tlsio_free(&io->tls);
 	mm_list_t *i, *n;
@@ -47,6 +57,7 @@ machine_io_free(machine_io_t *obj)
 		msg = mm_container_of(i, mm_msg_t, link);
 		machine_msg_free((machine_msg_t*)msg);
 	}
+	mm_zerocopy_free(io);
 	free(io);
 }
 
@@ -107,6 +118,46 @@ machine_set_keepalive(machine_io_t *obj, int enable, int delay)
 	return 0;
 }
 
+MACHINE_API int
+machine_set_zerocopy(machine_io_t *obj, int size)
+{
+	mm_io_t *io = mm_cast(mm_io_t*, obj);
+	mm_errno_set(0);
+	if (size < 0) {
+		mm_errno_set(EINVAL);
+		return -1;
+	}
+	io->opt_zerocopy = size;
+	io->zerocopy_size = 0;
+	if (io->fd != -1 && size > 0) {
+		int rc;
+		rc = mm_socket_set_zerocopy(io->fd, 1);
+		if (rc == -1) {
+			mm_errno_set(errno);
+			return -1;
+		}
+		io->zerocopy_size = size;
+	}
+	return 0;
+}
+
+MACHINE_API int
+machine_set_reuseport(machine_io_t *obj, int enable)
+{
+	mm_io_t *io = mm_cast(mm_io_t*, obj);
+	mm_errno_set(0);
+	io->opt_reuseport = enable;
+	if (io->fd != -1) {
+		int rc;
+		rc = mm_socket_set_reuseport(io->fd, enable);
+		if (rc == -1) {
+			mm_errno_set(errno);
+			return -1;
+		}
+	}
+	return 0;
+}
+
 MACHINE_API int
 machine_io_attach(machine_io_t *obj)
 {
@@ -123,6 +174,9 @@ machine_io_attach(machine_io_t *obj)
 		return -1;
 	}
 	io->attached = 1;
+	/* keep receiving pending zero-copy completions */
+	if (io->zerocopy_queue_count > 0)
+		mm_zerocopy_attach(io);
 	return 0;
 }
 
@@ -135,6 +189,8 @@ machine_io_detach(machine_io_t *obj)
 		mm_errno_set(ENOTCONN);
 		return -1;
 	}
+	if (io->poll_group)
+		mm_pollgroup_unlink(io);
 	int rc;
 	rc = mm_loop_delete(&mm_self->loop, &io->handle);
 	if (rc == -1) {
@@ -152,6 +208,22 @@ machine_get_write_queue_count(machine_io_t *obj)
 	return io->write_queue_count;
 }
 
+MACHINE_API int
+machine_get_zerocopy_queue_count(machine_io_t *obj)
+{
+	mm_io_t *io = mm_cast(mm_io_t*, obj);
+	return io->zerocopy_queue_count;
+}
+
+MACHINE_API int
+machine_get_ktls(machine_io_t *obj)
+{
+	/* sent data is encrypted by kernel tls */
+	mm_io_t *io = mm_cast(mm_io_t*, obj);
+	mm_errno_set(0);
+	return mm_tlsio_ktls_send(&io->tls);
+}
+
 MACHINE_API int
 machine_io_verify(machine_io_t *obj, char *common_name)
 {
@@ -195,6 +267,13 @@ int mm_io_socket_set(mm_io_t *io, int fd)
 				return -1;
 			}
 		}
+		/* zero-copy is an optimization, fallback to plain
+		 * writes when it is not supported */
+		if (io->opt_zerocopy) {
+			rc = mm_socket_set_zerocopy(io->fd, 1);
+			if (rc == 0)
+				io->zerocopy_size = io->opt_zerocopy;
+		}
 	}
 	io->handle.fd = io->fd;
 	return 0;
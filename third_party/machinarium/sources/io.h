@@ -19,31 +19,49 @@ struct mm_io
 	int         opt_nodelay;
 	int         opt_keepalive;
 	int         opt_keepalive_delay;
+	int         opt_zerocopy;
+	int         opt_reuseport;
 	mm_tlsio_t  tls;
 	mm_tls_t   *tls_obj;
 	mm_call_t   call;
 	mm_call_t  *poll_call;
 	int         poll_ready;
+	/* poll group */
+	struct mm_pollgroup *poll_group;
+	mm_list_t   poll_link;
+	mm_fd_callback_t poll_on_read;
+	int         poll_paused;
 	/* connect */
 	int         connected;
 	/* accept */
 	int         accepted;
 	int         accept_listen;
+	int         accept_drained;
 	/* read */
 	char       *read_buf;
 	int         read_size;
 	int         read_pos;
 	int         read_eof;
-	mm_buf_t    readahead_buf;
+	mm_msg_t   *readahead_buf;
 	int         readahead_size;
 	int         readahead_pos;
 	int         readahead_pos_read;
 	int         readahead_status;
+	/* splice */
+	int         splice_pipe[2];
+	int         splice_pipe_size;
 	/* write */
 	mm_buf_t    write_iov;
 	int         write_iov_pos;
 	mm_list_t   write_queue;
 	int         write_queue_count;
+	mm_msg_t   *write_stage;
+	/* zero-copy write */
+	int         zerocopy_size;
+	int         zerocopy_partial;
+	uint32_t    zerocopy_id;
+	mm_list_t   zerocopy_queue;
+	int         zerocopy_queue_count;
 	int         write_status;
 };
 
@@ -10,7 +10,12 @@
 
 int mm_loop_init(mm_loop_t *loop)
 {
-	loop->poll = mm_epoll_if.create();
+	mm_pollif_t *iface = machinarium.config.poll;
+	loop->poll = iface->create();
+	if (loop->poll == NULL && iface != &mm_epoll_if) {
+		/* fallback to epoll, if selected backend is not supported */
+		loop->poll = mm_epoll_if.create();
+	}
 	if (loop->poll == NULL)
 		return -1;
 	mm_clock_init(&loop->clock);
@@ -67,4 +67,13 @@ mm_loop_write_stop(mm_loop_t *loop, mm_fd_t *fd)
 	return loop->poll->iface->write(loop->poll, fd, NULL, NULL, 0);
 }
 
+static inline int
+mm_loop_write_errors(mm_loop_t *loop,
+                     mm_fd_t *fd,
+                     mm_fd_callback_t on_write, void *arg)
+{
+	/* keep write callback only for error notifications */
+	return loop->poll->iface->write(loop->poll, fd, on_write, arg, 0);
+}
+
 #endif /* MM_LOOP_H */
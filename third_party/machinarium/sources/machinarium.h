@@ -29,18 +29,29 @@ extern "C" {
 
 typedef void (*machine_coroutine_t)(void *arg);
 
+/* number of message cache size classes, see machine_stat() */
+
+#define MACHINE_MSG_CACHE_CLASSES 10
+
 /* library handles */
 
-typedef struct machine_msg_private     machine_msg_t;
-typedef struct machine_channel_private machine_channel_t;
-typedef struct machine_tls_private     machine_tls_t;
-typedef struct machine_io_private      machine_io_t;
+typedef struct machine_msg_private       machine_msg_t;
+typedef struct machine_channel_private   machine_channel_t;
+typedef struct machine_tls_private       machine_tls_t;
+typedef struct machine_io_private        machine_io_t;
+typedef struct machine_pollgroup_private machine_pollgroup_t;
 
 /* configuration */
 
 MACHINE_API void
 machinarium_set_stack_size(int size);
 
+MACHINE_API void
+machinarium_set_stack_hugepages(int enable);
+
+MACHINE_API void
+machinarium_set_stack_guard(int enable);
+
 MACHINE_API void
 machinarium_set_pool_size(int size);
 
@@ -50,6 +61,15 @@ machinarium_set_coroutine_cache_size(int size);
 MACHINE_API void
 machinarium_set_msg_cache_gc_size(int size);
 
+MACHINE_API void
+machinarium_set_dns_ttl(int ttl_ms);
+
+MACHINE_API void
+machinarium_set_dns_negative_ttl(int ttl_ms);
+
+MACHINE_API void
+machinarium_set_poll(char *name);
+
 /* main */
 
 MACHINE_API int
@@ -72,6 +92,9 @@ machine_active(void);
 MACHINE_API uint64_t
 machine_self(void);
 
+MACHINE_API char*
+machine_poll(void);
+
 MACHINE_API int
 machine_wait(uint64_t machine_id);
 
@@ -87,7 +110,18 @@ machine_stat(uint64_t *coroutine_count,
              uint64_t *msg_allocated,
              uint64_t *msg_cache_count,
              uint64_t *msg_cache_gc_count,
-             uint64_t *msg_cache_size);
+             uint64_t *msg_cache_size,
+             uint64_t *msg_cache_hit,
+             uint64_t *msg_cache_miss,
+             uint64_t *wakeup_count,
+             uint64_t *wakeup_coalesced_count);
+
+MACHINE_API void
+machine_stack_stat(uint64_t *reserved,
+                   uint64_t *used_avg,
+                   uint64_t *used_p99,
+                   uint64_t *used_max,
+                   uint64_t *used_count);
 
 /* signals */
 
@@ -151,8 +185,12 @@ machine_msg_write(machine_msg_t*, void *buf, int size);
 
 /* channel */
 
+#define MACHINE_CHANNEL_FAST   0 /* single machine */
+#define MACHINE_CHANNEL_SHARED 1 /* multiple producers and consumers */
+#define MACHINE_CHANNEL_MPSC   2 /* multiple producers, single consumer */
+
 MACHINE_API machine_channel_t*
-machine_channel_create(int shared);
+machine_channel_create(int type);
 
 MACHINE_API void
 machine_channel_free(machine_channel_t*);
@@ -163,6 +201,13 @@ machine_channel_write(machine_channel_t*, machine_msg_t*);
 MACHINE_API machine_msg_t*
 machine_channel_read(machine_channel_t*, uint32_t time_ms);
 
+MACHINE_API void
+machine_channel_write_batch(machine_channel_t*, machine_msg_t **msgs, int count);
+
+MACHINE_API int
+machine_channel_read_batch(machine_channel_t*, machine_msg_t **msgs, int max,
+                           uint32_t time_ms);
+
 /* tls */
 
 MACHINE_API machine_tls_t*
@@ -192,6 +237,12 @@ machine_tls_set_cert_file(machine_tls_t*, char*);
 MACHINE_API int
 machine_tls_set_key_file(machine_tls_t*, char*);
 
+MACHINE_API int
+machine_tls_set_ktls(machine_tls_t*, int enable);
+
+MACHINE_API void
+machine_tls_stat(machine_tls_t*, uint64_t *handshakes, uint64_t *reused);
+
 /* io control */
 
 MACHINE_API machine_io_t*
@@ -221,12 +272,24 @@ machine_set_keepalive(machine_io_t*, int enable, int delay);
 MACHINE_API int
 machine_set_readahead(machine_io_t*, int size);
 
+MACHINE_API int
+machine_set_zerocopy(machine_io_t*, int size);
+
+MACHINE_API int
+machine_set_reuseport(machine_io_t*, int enable);
+
 MACHINE_API int
 machine_set_tls(machine_io_t*, machine_tls_t*);
 
 MACHINE_API int
 machine_get_write_queue_count(machine_io_t*);
 
+MACHINE_API int
+machine_get_zerocopy_queue_count(machine_io_t*);
+
+MACHINE_API int
+machine_get_ktls(machine_io_t*);
+
 MACHINE_API int
 machine_io_verify(machine_io_t*, char *common_name);
 
@@ -244,6 +307,13 @@ machine_getaddrinfo(char *addr, char *service,
                     struct addrinfo **res,
                     uint32_t time_ms);
 
+MACHINE_API void
+machine_freeaddrinfo(struct addrinfo*);
+
+MACHINE_API void
+machine_dns_stat(uint64_t *hit, uint64_t *miss, uint64_t *refresh,
+                 uint64_t *resolve_count, uint64_t *resolve_time_us);
+
 /* io */
 
 MACHINE_API int
@@ -267,6 +337,23 @@ machine_read_poll(machine_io_t**, machine_io_t**, int count, uint32_t time_ms);
 MACHINE_API int
 machine_read_pending(machine_io_t*);
 
+/* poll group */
+
+MACHINE_API machine_pollgroup_t*
+machine_pollgroup_create(void);
+
+MACHINE_API void
+machine_pollgroup_free(machine_pollgroup_t*);
+
+MACHINE_API int
+machine_pollgroup_add(machine_pollgroup_t*, machine_io_t*);
+
+MACHINE_API int
+machine_pollgroup_del(machine_pollgroup_t*, machine_io_t*);
+
+MACHINE_API int
+machine_pollgroup_wait(machine_pollgroup_t*, machine_io_t**, int count, uint32_t time_ms);
+
 MACHINE_API machine_msg_t*
 machine_read(machine_io_t*, int size, uint32_t time_ms);
 
@@ -276,6 +363,9 @@ machine_read_to(machine_io_t*, machine_msg_t*, int size, uint32_t time_ms);
 MACHINE_API int
 machine_write_batch(machine_io_t*, machine_channel_t*);
 
+MACHINE_API int
+machine_splice(machine_io_t *dst, machine_io_t *src, int size, uint32_t time_ms);
+
 MACHINE_API int
 machine_write(machine_io_t*, machine_msg_t*);
 
@@ -24,6 +24,7 @@
 #include <sys/types.h>
 #include <sys/mman.h>
 #include <sys/socket.h>
+#include <sys/uio.h>
 #include <sys/un.h>
 #include <netinet/tcp.h>
 #include <arpa/inet.h>
@@ -31,6 +32,8 @@
 #include <sys/epoll.h>
 #include <sys/eventfd.h>
 #include <sys/signalfd.h>
+#include <linux/errqueue.h>
+#include <linux/tls.h>
 
 #include <openssl/opensslv.h>
 #include <openssl/ssl.h>
@@ -41,6 +44,13 @@
 #include <openssl/err.h>
 
 #include "build.h"
+
+#ifdef HAVE_IO_URING
+#  include <sys/poll.h>
+#  include <sys/syscall.h>
+#  include <linux/io_uring.h>
+#endif
+
 #include "macro.h"
 #include "util.h"
 #include "sleep_lock.h"
@@ -54,8 +64,10 @@
 #include "idle.h"
 #include "loop.h"
 #include "epoll.h"
+#include "uring.h"
 #include "socket.h"
 
+#include "stack_arena.h"
 #include "context_stack.h"
 #include "context.h"
 #include "coroutine.h"
@@ -74,9 +86,11 @@
 #include "channel_type.h"
 #include "channel.h"
 #include "channel_fast.h"
+#include "channel_mpsc.h"
 
 #include "task.h"
 #include "task_mgr.h"
+#include "dns.h"
 
 #include "machine.h"
 #include "machine_mgr.h"
@@ -86,7 +100,9 @@
 #include "tls.h"
 
 #include "io.h"
+#include "pollgroup.h"
 #include "read.h"
 #include "write.h"
+#include "splice.h"
 
 #endif
@@ -23,12 +23,12 @@ machine_free(mm_machine_t *machine)
 {
 	/* todo: check active timers and other allocated
 	 *       resources */
-	mm_msgcache_free(&machine->msg_cache);
+	mm_msgcache_free(machine->msg_cache);
+	mm_scheduler_free(&machine->scheduler);
 	mm_coroutine_cache_free(&machine->coroutine_cache);
 	mm_eventmgr_free(&machine->event_mgr, &machine->loop);
 	mm_signalmgr_free(&machine->signal_mgr, &machine->loop);
 	mm_loop_shutdown(&machine->loop);
-	mm_scheduler_free(&machine->scheduler);
 }
 
 static void*
@@ -82,20 +82,42 @@ machine_create(char *name, machine_coroutine_t function, void *arg)
 	}
 	mm_list_init(&machine->link);
 
-	mm_msgcache_init(&machine->msg_cache);
-	mm_msgcache_set_gc_watermark(&machine->msg_cache,
+	machine->msg_cache = mm_msgcache_create();
+	if (machine->msg_cache == NULL) {
+		if (machine->name)
+			free(machine->name);
+		free(machine);
+		return -1;
+	}
+	mm_msgcache_set_gc_watermark(machine->msg_cache,
 	                              machinarium.config.msg_cache_gc_size);
 
-	mm_coroutine_cache_init(&machine->coroutine_cache,
-	                        machinarium.config.stack_size * machinarium.config.page_size,
-	                        machinarium.config.page_size,
-	                        machinarium.config.coroutine_cache_size);
-
-	mm_scheduler_init(&machine->scheduler);
 	int rc;
+	rc = mm_coroutine_cache_init(&machine->coroutine_cache,
+	                             machinarium.config.stack_size * machinarium.config.page_size,
+	                             machinarium.config.page_size,
+	                             machinarium.config.stack_hugepages,
+	                             machinarium.config.stack_guard,
+	                             machinarium.config.coroutine_cache_size);
+	if (rc == -1) {
+		mm_coroutine_cache_free(&machine->coroutine_cache);
+		mm_msgcache_free(machine->msg_cache);
+		free(machine);
+		return -1;
+	}
+
+	rc = mm_scheduler_init(&machine->scheduler);
+	if (rc == -1) {
+		mm_coroutine_cache_free(&machine->coroutine_cache);
+		mm_msgcache_free(machine->msg_cache);
+		free(machine);
+		return -1;
+	}
 	rc = mm_loop_init(&machine->loop);
 	if (rc < 0) {
 		mm_scheduler_free(&machine->scheduler);
+		mm_coroutine_cache_free(&machine->coroutine_cache);
+		mm_msgcache_free(machine->msg_cache);
 		free(machine);
 		return -1;
 	}
@@ -104,6 +126,8 @@ machine_create(char *name, machine_coroutine_t function, void *arg)
 	if (rc == -1) {
 		mm_loop_shutdown(&machine->loop);
 		mm_scheduler_free(&machine->scheduler);
+		mm_coroutine_cache_free(&machine->coroutine_cache);
+		mm_msgcache_free(machine->msg_cache);
 		free(machine);
 		return -1;
 	}
@@ -112,6 +136,8 @@ machine_create(char *name, machine_coroutine_t function, void *arg)
 		mm_eventmgr_free(&machine->event_mgr, &machine->loop);
 		mm_loop_shutdown(&machine->loop);
 		mm_scheduler_free(&machine->scheduler);
+		mm_coroutine_cache_free(&machine->coroutine_cache);
+		mm_msgcache_free(machine->msg_cache);
 		free(machine);
 		return -1;
 	}
@@ -122,6 +148,8 @@ machine_create(char *name, machine_coroutine_t function, void *arg)
 		mm_eventmgr_free(&machine->event_mgr, &machine->loop);
 		mm_loop_shutdown(&machine->loop);
 		mm_scheduler_free(&machine->scheduler);
+		mm_coroutine_cache_free(&machine->coroutine_cache);
+		mm_msgcache_free(machine->msg_cache);
 		free(machine);
 		return -1;
 	}
@@ -155,6 +183,14 @@ machine_self(void)
 	return mm_self->id;
 }
 
+MACHINE_API char*
+machine_poll(void)
+{
+	/* poll backend used by the machine, which is epoll if the
+	 * selected one is not supported */
+	return mm_self->loop.poll->iface->name;
+}
+
 MACHINE_API void
 machine_stop(void)
 {
@@ -284,12 +320,30 @@ machine_stat(uint64_t *coroutine_count,
              uint64_t *msg_allocated,
              uint64_t *msg_cache_count,
              uint64_t *msg_cache_gc_count,
-             uint64_t *msg_cache_size)
+             uint64_t *msg_cache_size,
+             uint64_t *msg_cache_hit,
+             uint64_t *msg_cache_miss,
+             uint64_t *wakeup_count,
+             uint64_t *wakeup_coalesced_count)
 {
 	mm_coroutine_cache_stat(&mm_self->coroutine_cache,
 	                        coroutine_count,
 	                        coroutine_cache_count);
 
-	mm_msgcache_stat(&mm_self->msg_cache, msg_allocated, msg_cache_gc_count,
-	                 msg_cache_count, msg_cache_size);
+	mm_msgcache_stat(mm_self->msg_cache, msg_allocated, msg_cache_gc_count,
+	                 msg_cache_count, msg_cache_size,
+	                 msg_cache_hit, msg_cache_miss);
+
+	mm_eventmgr_stat(&mm_self->event_mgr, wakeup_count, wakeup_coalesced_count);
+}
+
+MACHINE_API void
+machine_stack_stat(uint64_t *reserved,
+                   uint64_t *used_avg,
+                   uint64_t *used_p99,
+                   uint64_t *used_max,
+                   uint64_t *used_count)
+{
+	mm_stackarena_stat(&mm_self->coroutine_cache.arena,
+	                   reserved, used_avg, used_p99, used_max, used_count);
 }
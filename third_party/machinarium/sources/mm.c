@@ -9,9 +9,14 @@
 #include <machinarium_private.h>
 
 static int machinarium_stack_size = 0;
+static int machinarium_stack_hugepages = 0;
+static int machinarium_stack_guard = 1;
 static int machinarium_pool_size = 0;
 static int machinarium_coroutine_cache_size = 0;
 static int machinarium_msg_cache_gc_size = 0;
+static int machinarium_dns_ttl = 0;
+static int machinarium_dns_negative_ttl = 0;
+static char *machinarium_poll = NULL;
 static int machinarium_initialized = 0;
 mm_t       machinarium;
 
@@ -27,6 +32,18 @@ machinarium_set_stack_size(int size)
 	machinarium_stack_size = size;
 }
 
+MACHINE_API void
+machinarium_set_stack_hugepages(int enable)
+{
+	machinarium_stack_hugepages = enable;
+}
+
+MACHINE_API void
+machinarium_set_stack_guard(int enable)
+{
+	machinarium_stack_guard = enable;
+}
+
 MACHINE_API void
 machinarium_set_pool_size(int size)
 {
@@ -45,6 +62,32 @@ machinarium_set_msg_cache_gc_size(int size)
 	machinarium_msg_cache_gc_size = size;
 }
 
+MACHINE_API void
+machinarium_set_dns_ttl(int ttl_ms)
+{
+	machinarium_dns_ttl = ttl_ms;
+}
+
+MACHINE_API void
+machinarium_set_dns_negative_ttl(int ttl_ms)
+{
+	machinarium_dns_negative_ttl = ttl_ms;
+}
+
+MACHINE_API void
+machinarium_set_poll(char *name)
+{
+	machinarium_poll = name;
+}
+
+static inline mm_pollif_t*
+machinarium_poll_of(char *name)
+{
+	if (name && strcmp(name, mm_uring_if.name) == 0)
+		return &mm_uring_if;
+	return &mm_epoll_if;
+}
+
 MACHINE_API int
 machinarium_init(void)
 {
@@ -57,14 +100,25 @@ machinarium_init(void)
 	if (machinarium_pool_size == 0)
 		machinarium_pool_size = 1;
 
+	/* guard pages would split huge pages */
+	if (machinarium_stack_hugepages && machinarium_stack_guard)
+		return -1;
+
 	machinarium.config.page_size            = machinarium_page_size();
 	machinarium.config.stack_size           = machinarium_stack_size;
+	machinarium.config.stack_hugepages      = machinarium_stack_hugepages;
+	machinarium.config.stack_guard          = machinarium_stack_guard;
 	machinarium.config.pool_size            = machinarium_pool_size;
 	machinarium.config.coroutine_cache_size = machinarium_coroutine_cache_size;
 	machinarium.config.msg_cache_gc_size    = machinarium_msg_cache_gc_size;
+	machinarium.config.dns_ttl              = machinarium_dns_ttl;
+	machinarium.config.dns_negative_ttl     = machinarium_dns_negative_ttl;
+	machinarium.config.poll                 = machinarium_poll_of(machinarium_poll);
 
 	mm_machinemgr_init(&machinarium.machine_mgr);
 	mm_tls_init();
+	mm_dns_init(&machinarium.dns, machinarium.config.dns_ttl,
+	            machinarium.config.dns_negative_ttl);
 	mm_taskmgr_init(&machinarium.task_mgr);
 	mm_taskmgr_start(&machinarium.task_mgr, machinarium.config.pool_size);
 	machinarium_initialized = 1;
@@ -77,6 +131,7 @@ machinarium_free(void)
 	if (! machinarium_initialized)
 		return;
 	mm_taskmgr_stop(&machinarium.task_mgr);
+	mm_dns_free(&machinarium.dns);
 	mm_machinemgr_free(&machinarium.machine_mgr);
 	mm_tls_free();
 	machinarium_initialized = 0;
@@ -12,11 +12,16 @@ typedef struct mm        mm_t;
 
 struct mm_config
 {
-	int page_size;
-	int stack_size;
-	int pool_size;
-	int coroutine_cache_size;
-	int msg_cache_gc_size;
+	int          page_size;
+	int          stack_size;
+	int          stack_hugepages;
+	int          stack_guard;
+	int          pool_size;
+	int          coroutine_cache_size;
+	int          msg_cache_gc_size;
+	int          dns_ttl;
+	int          dns_negative_ttl;
+	mm_pollif_t *poll;
 };
 
 struct mm
@@ -24,6 +29,7 @@ struct mm
 	mm_config_t     config;
 	mm_machinemgr_t machine_mgr;
 	mm_taskmgr_t    task_mgr;
+	mm_dns_t        dns;
 };
 
 extern mm_t machinarium;
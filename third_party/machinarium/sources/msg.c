@@ -11,7 +11,7 @@
 MACHINE_API machine_msg_t*
 machine_msg_create(int reserve)
 {
-	mm_msg_t *msg = mm_msgcache_pop(&mm_self->msg_cache);
+	mm_msg_t *msg = mm_msgcache_pop(mm_self->msg_cache, reserve);
 	if (msg == NULL)
 		return NULL;
 	msg->type = 0;
@@ -19,7 +19,7 @@ machine_msg_create(int reserve)
 		int rc;
 		rc = mm_buf_ensure(&msg->data, reserve);
 		if (rc == -1) {
-			mm_msg_unref(&mm_self->msg_cache, msg);
+			mm_msg_unref(mm_self->msg_cache, msg);
 			return NULL;
 		}
 		mm_buf_advance(&msg->data, reserve);
@@ -31,7 +31,7 @@ MACHINE_API void
 machine_msg_free(machine_msg_t *obj)
 {
 	mm_msg_t *msg = mm_cast(mm_msg_t*, obj);
-	mm_msgcache_push(&mm_self->msg_cache, msg);
+	mm_msgcache_push(mm_self->msg_cache, msg);
 }
 
 MACHINE_API void
@@ -67,6 +67,9 @@ machine_msg_write(machine_msg_t *obj, void *buf, int size)
 {
 	mm_msg_t *msg = mm_cast(mm_msg_t*, obj);
 	int rc;
+	rc = mm_msg_unshare(msg);
+	if (rc == -1)
+		return -1;
 	if (buf == NULL) {
 		rc = mm_buf_ensure(&msg->data, size);
 		if (rc == -1)
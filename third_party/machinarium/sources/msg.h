@@ -11,10 +11,13 @@ typedef struct mm_msg mm_msg_t;
 
 struct mm_msg
 {
-	uint16_t  refs;
-	uint64_t  machine_id;
+	uint32_t  refs;
+	struct mm_msgcache *cache;
 	int       type;
+	uint32_t  zerocopy_id;
 	mm_buf_t  data;
+	mm_msg_t *origin;
+	mm_buf_t  own;
 	mm_list_t link;
 };
 
@@ -23,9 +26,99 @@ mm_msg_init(mm_msg_t *msg, int type)
 {
 	msg->refs = 0;
 	msg->type = type;
-	msg->machine_id = 0;
+	msg->cache = NULL;
+	msg->origin = NULL;
 	mm_buf_init(&msg->data);
+	mm_buf_init(&msg->own);
 	mm_list_init(&msg->link);
 }
 
+/*
+ * Shared message owns a buffer which might be referenced by
+ * slice messages (see mm_msg_slice()).
+ *
+ * Shared message is freed when the last reference is dropped,
+ * which might happen on any machine.
+*/
+
+static inline mm_msg_t*
+mm_msg_shared_create(void)
+{
+	mm_msg_t *msg = malloc(sizeof(mm_msg_t));
+	if (msg == NULL)
+		return NULL;
+	mm_msg_init(msg, 0);
+	return msg;
+}
+
+static inline void
+mm_msg_shared_ref(mm_msg_t *msg)
+{
+	__sync_fetch_and_add(&msg->refs, 1);
+}
+
+static inline void
+mm_msg_shared_unref(mm_msg_t *msg)
+{
+	if (__sync_fetch_and_sub(&msg->refs, 1) > 0)
+		return;
+	mm_buf_free(&msg->data);
+	free(msg);
+}
+
+static inline int
+mm_msg_is_shared(mm_msg_t *msg)
+{
+	return __sync_fetch_and_add(&msg->refs, 0) > 0;
+}
+
+static inline void
+mm_msg_slice(mm_msg_t *msg, mm_msg_t *origin, int offset, int size)
+{
+	assert(msg->origin == NULL);
+	assert(mm_buf_used(&msg->data) == 0);
+	mm_msg_shared_ref(origin);
+	msg->origin = origin;
+	msg->own = msg->data;
+	msg->data.start = origin->data.start + offset;
+	msg->data.pos   = msg->data.start + size;
+	msg->data.end   = msg->data.pos;
+}
+
+static inline void
+mm_msg_slice_extend(mm_msg_t *msg, int size)
+{
+	assert(msg->origin != NULL);
+	msg->data.pos += size;
+	msg->data.end  = msg->data.pos;
+}
+
+static inline void
+mm_msg_unslice(mm_msg_t *msg)
+{
+	if (msg->origin == NULL)
+		return;
+	mm_msg_t *origin = msg->origin;
+	msg->origin = NULL;
+	msg->data = msg->own;
+	mm_buf_init(&msg->own);
+	mm_msg_shared_unref(origin);
+}
+
+static inline int
+mm_msg_unshare(mm_msg_t *msg)
+{
+	/* copy referenced data into the message own buffer
+	 * before modifying it */
+	if (msg->origin == NULL)
+		return 0;
+	mm_buf_reset(&msg->own);
+	int rc;
+	rc = mm_buf_add(&msg->own, msg->data.start, mm_buf_used(&msg->data));
+	if (rc == -1)
+		return -1;
+	mm_msg_unslice(msg);
+	return 0;
+}
+
 #endif /* MM_MSG_H */
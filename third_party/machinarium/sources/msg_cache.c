@@ -8,75 +8,244 @@
 #include <machinarium.h>
 #include <machinarium_private.h>
 
-void mm_msgcache_init(mm_msgcache_t *cache)
+/*
+ * Each machine keeps messages it allocated in size-classed lists.
+ *
+ * Messages freed by other machines are returned to the owning
+ * machine through a lock-free stack and collected by the owner
+ * when its lists run empty. Cache memory is released when the
+ * owner machine and all messages it allocated are gone.
+*/
+
+#define MM_MSGCACHE_CLOSED ((mm_msg_t*)1)
+
+static inline int
+mm_msgcache_class_of(int size)
+{
+	int class = 0;
+	while (class < MM_MSGCACHE_CLASSES - 1 &&
+	       (MM_MSGCACHE_CLASS_MIN << (class + 1)) <= size)
+		class++;
+	return class;
+}
+
+static inline int
+mm_msgcache_class_for(int reserve)
+{
+	int class = 0;
+	while (class < MM_MSGCACHE_CLASSES &&
+	       (MM_MSGCACHE_CLASS_MIN << class) < reserve)
+		class++;
+	return class;
+}
+
+static inline int
+mm_msgcache_max(mm_msgcache_t *cache)
 {
-	mm_list_init(&cache->list);
+	if (cache->gc_watermark > 0)
+		return cache->gc_watermark;
+	return MM_MSGCACHE_CLASS_MIN << MM_MSGCACHE_CLASSES;
+}
+
+static inline void
+mm_msgcache_unref(mm_msgcache_t *cache)
+{
+	if (__sync_sub_and_fetch(&cache->refs, 1) > 0)
+		return;
+	free(cache);
+}
+
+static inline void
+mm_msgcache_release(mm_msg_t *msg)
+{
+	mm_msgcache_t *owner = msg->cache;
+	mm_buf_free(&msg->data);
+	free(msg);
+	mm_msgcache_unref(owner);
+}
+
+mm_msgcache_t*
+mm_msgcache_create(void)
+{
+	mm_msgcache_t *cache;
+	cache = malloc(sizeof(mm_msgcache_t));
+	if (cache == NULL)
+		return NULL;
+	int i;
+	for (i = 0; i < MM_MSGCACHE_CLASSES; i++) {
+		mm_list_init(&cache->classes[i]);
+		cache->classes_count[i] = 0;
+		cache->hit[i] = 0;
+		cache->miss[i] = 0;
+	}
 	cache->count = 0;
 	cache->count_allocated = 0;
 	cache->count_gc = 0;
 	cache->size = 0;
 	cache->gc_watermark = 0;
+	cache->returned = NULL;
+	/* owner machine reference */
+	cache->refs = 1;
+	return cache;
 }
 
 void mm_msgcache_free(mm_msgcache_t *cache)
 {
-	mm_list_t *i, *n;
-	mm_list_foreach_safe(&cache->list, i, n) {
-		mm_msg_t *msg = mm_container_of(i, mm_msg_t, link);
-		mm_buf_free(&msg->data);
-		free(msg);
+	/* make other machines free returned messages */
+	mm_msg_t *msg;
+	msg = __sync_lock_test_and_set(&cache->returned, MM_MSGCACHE_CLOSED);
+	while (msg) {
+		mm_msg_t *next = NULL;
+		if (msg->link.next)
+			next = mm_container_of(msg->link.next, mm_msg_t, link);
+		mm_msgcache_release(msg);
+		msg = next;
 	}
+
+	int i;
+	for (i = 0; i < MM_MSGCACHE_CLASSES; i++) {
+		mm_list_t *j, *n;
+		mm_list_foreach_safe(&cache->classes[i], j, n) {
+			msg = mm_container_of(j, mm_msg_t, link);
+			mm_msgcache_release(msg);
+		}
+	}
+	mm_msgcache_unref(cache);
 }
 
 void mm_msgcache_stat(mm_msgcache_t *cache,
                       uint64_t *count_allocated,
                       uint64_t *count_gc,
                       uint64_t *count,
-                      uint64_t *size)
+                      uint64_t *size,
+                      uint64_t *hit,
+                      uint64_t *miss)
 {
 	*count_allocated = cache->count_allocated;
 	*count_gc = cache->count_gc;
 	*count = cache->count;
 	*size  = cache->size;
+	if (hit)
+		memcpy(hit, cache->hit, sizeof(cache->hit));
+	if (miss)
+		memcpy(miss, cache->miss, sizeof(cache->miss));
 }
 
-mm_msg_t*
-mm_msgcache_pop(mm_msgcache_t *cache)
+static inline void
+mm_msgcache_collect(mm_msgcache_t *cache)
 {
-	mm_msg_t *msg = NULL;
-	if (cache->count > 0) {
-		mm_list_t *first = mm_list_pop(&cache->list);
+	mm_msg_t *msg;
+	msg = __sync_lock_test_and_set(&cache->returned, NULL);
+	while (msg) {
+		mm_msg_t *next = NULL;
+		if (msg->link.next)
+			next = mm_container_of(msg->link.next, mm_msg_t, link);
+		mm_msgcache_push(cache, msg);
+		msg = next;
+	}
+}
+
+static inline mm_msg_t*
+mm_msgcache_take(mm_msgcache_t *cache, int class)
+{
+	for (; class < MM_MSGCACHE_CLASSES; class++) {
+		if (cache->classes_count[class] == 0)
+			continue;
+		mm_list_t *first = mm_list_pop(&cache->classes[class]);
+		cache->classes_count[class]--;
 		cache->count--;
+		mm_msg_t *msg;
 		msg = mm_container_of(first, mm_msg_t, link);
 		cache->size -= mm_buf_size(&msg->data);
-		goto init;
+		return msg;
 	}
+	return NULL;
+}
+
+mm_msg_t*
+mm_msgcache_pop(mm_msgcache_t *cache, int reserve)
+{
+	mm_msg_t *msg = NULL;
+	int class = mm_msgcache_class_for(reserve);
+	if (class < MM_MSGCACHE_CLASSES) {
+		msg = mm_msgcache_take(cache, class);
+		if (msg == NULL && cache->returned) {
+			mm_msgcache_collect(cache);
+			msg = mm_msgcache_take(cache, class);
+		}
+		if (msg) {
+			cache->hit[class]++;
+			goto init;
+		}
+	} else {
+		class = MM_MSGCACHE_CLASSES - 1;
+	}
+	cache->miss[class]++;
 	cache->count_allocated++;
 
 	msg = malloc(sizeof(mm_msg_t));
 	if (msg == NULL)
 		return NULL;
 	mm_buf_init(&msg->data);
+	if (reserve > 0) {
+		/* round buffer up to the class size, so it could be
+		 * reused for the same class */
+		int size = MM_MSGCACHE_CLASS_MIN << class;
+		if (size < reserve)
+			size = reserve;
+		if (mm_buf_ensure(&msg->data, size) == -1) {
+			free(msg);
+			return NULL;
+		}
+	}
+	msg->cache = cache;
+	__sync_fetch_and_add(&cache->refs, 1);
 init:
-	msg->machine_id = mm_self->id;
 	msg->refs       = 0;
 	msg->type       = 0;
+	msg->origin     = NULL;
 	mm_buf_reset(&msg->data);
 	mm_list_init(&msg->link);
 	return msg;
 }
 
+static inline void
+mm_msgcache_return(mm_msgcache_t *owner, mm_msg_t *msg)
+{
+	for (;;) {
+		mm_msg_t *head = owner->returned;
+		if (head == MM_MSGCACHE_CLOSED) {
+			mm_msgcache_release(msg);
+			return;
+		}
+		msg->link.next = NULL;
+		if (head)
+			msg->link.next = &head->link;
+		if (__sync_bool_compare_and_swap(&owner->returned, head, msg))
+			return;
+	}
+}
+
 void mm_msgcache_push(mm_msgcache_t *cache, mm_msg_t *msg)
 {
-	if (msg->machine_id != mm_self->id ||
-	    mm_buf_size(&msg->data) > cache->gc_watermark) {
+	mm_msg_unslice(msg);
+
+	if (msg->cache != cache) {
+		mm_msgcache_return(msg->cache, msg);
+		return;
+	}
+
+	int size = mm_buf_size(&msg->data);
+	int class = mm_msgcache_class_of(size);
+	if (size > mm_msgcache_max(cache) ||
+	    cache->classes_count[class] >= MM_MSGCACHE_CLASS_LIMIT) {
 		cache->count_gc++;
-		mm_buf_free(&msg->data);
-		free(msg);
+		mm_msgcache_release(msg);
 		return;
 	}
 
-	mm_list_append(&cache->list, &msg->link);
+	mm_list_push(&cache->classes[class], &msg->link);
+	cache->classes_count[class]++;
 	cache->count++;
-	cache->size += mm_buf_size(&msg->data);
+	cache->size += size;
 }
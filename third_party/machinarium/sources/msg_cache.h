@@ -9,22 +9,37 @@
 
 typedef struct mm_msgcache mm_msgcache_t;
 
+/* size class i keeps messages with buffer size in
+ * [64 << i, 64 << (i + 1)), first class also keeps smaller ones */
+#define MM_MSGCACHE_CLASSES     MACHINE_MSG_CACHE_CLASSES
+#define MM_MSGCACHE_CLASS_MIN   64
+#define MM_MSGCACHE_CLASS_LIMIT 256
+
 struct mm_msgcache
 {
-	mm_list_t list;
-	uint64_t  count;
-	uint64_t  count_allocated;
-	uint64_t  count_gc;
-	uint64_t  size;
-	int       gc_watermark;
+	mm_list_t  classes[MM_MSGCACHE_CLASSES];
+	int        classes_count[MM_MSGCACHE_CLASSES];
+	uint64_t   hit[MM_MSGCACHE_CLASSES];
+	uint64_t   miss[MM_MSGCACHE_CLASSES];
+	uint64_t   count;
+	uint64_t   count_allocated;
+	uint64_t   count_gc;
+	uint64_t   size;
+	int        gc_watermark;
+	/* messages returned by other machines */
+	mm_msg_t  *returned;
+	uint32_t   refs;
 };
 
-void mm_msgcache_init(mm_msgcache_t*);
+mm_msgcache_t*
+mm_msgcache_create(void);
+
 void mm_msgcache_free(mm_msgcache_t*);
-void mm_msgcache_stat(mm_msgcache_t*, uint64_t*, uint64_t*, uint64_t*, uint64_t*);
+void mm_msgcache_stat(mm_msgcache_t*, uint64_t*, uint64_t*, uint64_t*, uint64_t*,
+                      uint64_t*, uint64_t*);
 
 mm_msg_t*
-mm_msgcache_pop(mm_msgcache_t*);
+mm_msgcache_pop(mm_msgcache_t*, int);
 
 void mm_msgcache_push(mm_msgcache_t*, mm_msg_t*);
 
@@ -0,0 +1,267 @@
+
+/*
+ * machinarium.
+ *
+ * cooperative multitasking engine.
+*/
+
+#include <machinarium.h>
+#include <machinarium_private.h>
+
+/*
+ * Poll group keeps member ios registered for read events with a single
+ * callback for the lifetime of the group, so waiting for readiness
+ * does not require switching io read handlers and updating the
+ * poller on every call (see machine_read_poll()).
+ *
+ * Reads done on a member io install their callback as io->poll_on_read,
+ * which is invoked by the group callback.
+*/
+
+static inline int
+mm_pollgroup_pause(mm_io_t *io)
+{
+	if (io->poll_paused)
+		return 0;
+	int rc;
+	rc = mm_loop_read_stop(&mm_self->loop, &io->handle);
+	if (rc == -1) {
+		mm_errno_set(errno);
+		return -1;
+	}
+	io->handle.on_read_arg = io;
+	io->poll_paused = 1;
+	return 0;
+}
+
+static void
+mm_pollgroup_cb(mm_fd_t *handle)
+{
+	mm_io_t *io = handle->on_read_arg;
+	mm_pollgroup_t *group = io->poll_group;
+	assert(group != NULL);
+
+	if (io->poll_on_read)
+		io->poll_on_read(handle);
+	else
+	if (mm_readahead_enabled(io))
+		mm_readahead_cb(handle);
+	else
+		io->poll_ready = 1;
+
+	/* stop polling io which has nothing to consume the event,
+	 * until it is read */
+	int full = mm_readahead_enabled(io) &&
+	           io->readahead_pos == io->readahead_size;
+	if (io->poll_ready || full || !io->connected)
+		mm_pollgroup_pause(io);
+
+	mm_call_t *call = group->call;
+	if (call) {
+		group->call = NULL;
+		mm_scheduler_wakeup(&mm_self->scheduler, call->coroutine);
+	}
+}
+
+int
+mm_pollgroup_resume(mm_io_t *io)
+{
+	if (! io->poll_paused)
+		return 0;
+	int rc;
+	rc = mm_loop_read(&mm_self->loop, &io->handle, mm_pollgroup_cb, io);
+	if (rc == -1) {
+		mm_errno_set(errno);
+		return -1;
+	}
+	io->poll_paused = 0;
+	return 0;
+}
+
+void
+mm_pollgroup_unlink(mm_io_t *io)
+{
+	mm_pollgroup_t *group = io->poll_group;
+	mm_list_unlink(&io->poll_link);
+	group->count--;
+	io->poll_group   = NULL;
+	io->poll_on_read = NULL;
+	io->poll_ready   = 0;
+	io->poll_paused  = 0;
+}
+
+MACHINE_API machine_pollgroup_t*
+machine_pollgroup_create(void)
+{
+	mm_errno_set(0);
+	mm_pollgroup_t *group;
+	group = malloc(sizeof(mm_pollgroup_t));
+	if (group == NULL) {
+		mm_errno_set(ENOMEM);
+		return NULL;
+	}
+	group->call  = NULL;
+	group->count = 0;
+	mm_list_init(&group->list);
+	return (machine_pollgroup_t*)group;
+}
+
+MACHINE_API void
+machine_pollgroup_free(machine_pollgroup_t *obj)
+{
+	mm_pollgroup_t *group = mm_cast(mm_pollgroup_t*, obj);
+	mm_list_t *i, *n;
+	mm_list_foreach_safe(&group->list, i, n) {
+		mm_io_t *io;
+		io = mm_container_of(i, mm_io_t, poll_link);
+		machine_pollgroup_del(obj, (machine_io_t*)io);
+	}
+	free(group);
+}
+
+MACHINE_API int
+machine_pollgroup_add(machine_pollgroup_t *obj, machine_io_t *io_obj)
+{
+	mm_pollgroup_t *group = mm_cast(mm_pollgroup_t*, obj);
+	mm_io_t *io = mm_cast(mm_io_t*, io_obj);
+	mm_errno_set(0);
+	if (io->poll_group == group)
+		return 0;
+	if (io->poll_group) {
+		mm_errno_set(EINPROGRESS);
+		return -1;
+	}
+	if (! io->attached) {
+		mm_errno_set(ENOTCONN);
+		return -1;
+	}
+	int rc;
+	if (mm_readahead_enabled(io)) {
+		rc = mm_readahead_alloc(io, io->readahead_size);
+		if (rc == -1) {
+			mm_errno_set(ENOMEM);
+			return -1;
+		}
+	}
+
+	/* keep read handler installed by previous reads */
+	mm_fd_callback_t on_read = NULL;
+	if (io->handle.mask & MM_R)
+		on_read = io->handle.on_read;
+
+	rc = mm_loop_read(&mm_self->loop, &io->handle, mm_pollgroup_cb, io);
+	if (rc == -1) {
+		mm_errno_set(errno);
+		return -1;
+	}
+	io->poll_group   = group;
+	io->poll_on_read = on_read;
+	io->poll_ready   = 0;
+	io->poll_paused  = 0;
+	mm_list_append(&group->list, &io->poll_link);
+	group->count++;
+	return 0;
+}
+
+MACHINE_API int
+machine_pollgroup_del(machine_pollgroup_t *obj, machine_io_t *io_obj)
+{
+	mm_pollgroup_t *group = mm_cast(mm_pollgroup_t*, obj);
+	mm_io_t *io = mm_cast(mm_io_t*, io_obj);
+	mm_errno_set(0);
+	if (io->poll_group != group) {
+		mm_errno_set(EINVAL);
+		return -1;
+	}
+	mm_fd_callback_t on_read = io->poll_on_read;
+	mm_pollgroup_unlink(io);
+
+	/* restore read handler */
+	int rc;
+	if (on_read)
+		rc = mm_loop_read(&mm_self->loop, &io->handle, on_read, io);
+	else
+		rc = mm_loop_read_stop(&mm_self->loop, &io->handle);
+	if (rc == -1) {
+		mm_errno_set(errno);
+		return -1;
+	}
+	return 0;
+}
+
+static inline int
+mm_pollgroup_rearm(mm_io_t *io)
+{
+	/* io paused on full readahead buffer has its buffered data
+	 * consumed by now, start filling the buffer from the beginning */
+	if (mm_readahead_enabled(io)) {
+		int rc;
+		rc = mm_readahead_reset(io);
+		if (rc == -1) {
+			mm_errno_set(ENOMEM);
+			return -1;
+		}
+	}
+	return mm_pollgroup_resume(io);
+}
+
+static inline int
+mm_pollgroup_ready(mm_pollgroup_t *group, mm_io_t **io_ready, int count)
+{
+	int ready = 0;
+	mm_list_t *i;
+	mm_list_foreach(&group->list, i) {
+		mm_io_t *io;
+		io = mm_container_of(i, mm_io_t, poll_link);
+		int rc;
+		rc = machine_read_pending((machine_io_t*)io);
+		if (rc == -1)
+			return -1;
+		if (rc == 0 && io->poll_paused && ! io->poll_ready) {
+			rc = mm_pollgroup_rearm(io);
+			if (rc == -1)
+				return -1;
+			continue;
+		}
+		if (rc > 0 || io->poll_ready) {
+			if (ready == count)
+				break;
+			io_ready[ready] = io;
+			ready++;
+		}
+	}
+	return ready;
+}
+
+MACHINE_API int
+machine_pollgroup_wait(machine_pollgroup_t *obj, machine_io_t **obj_ready,
+                       int count, uint32_t time_ms)
+{
+	mm_pollgroup_t *group = mm_cast(mm_pollgroup_t*, obj);
+	mm_io_t **io_ready = mm_cast(mm_io_t**, obj_ready);
+	mm_errno_set(0);
+	if (count <= 0 || group->count == 0) {
+		mm_errno_set(EINVAL);
+		return -1;
+	}
+	if (group->call) {
+		mm_errno_set(EINPROGRESS);
+		return -1;
+	}
+
+	/* check for any pending events or data */
+	int ready;
+	ready = mm_pollgroup_ready(group, io_ready, count);
+	if (ready != 0)
+		return ready;
+
+	mm_call_t call;
+	group->call = &call;
+	mm_call(&call, MM_CALL_READ_POLL, time_ms);
+	group->call = NULL;
+	if (call.status != 0) {
+		mm_errno_set(call.status);
+		return -1;
+	}
+	return mm_pollgroup_ready(group, io_ready, count);
+}
@@ -0,0 +1,22 @@
+#ifndef MM_POLLGROUP_H
+#define MM_POLLGROUP_H
+
+/*
+ * machinarium.
+ *
+ * cooperative multitasking engine.
+*/
+
+typedef struct mm_pollgroup mm_pollgroup_t;
+
+struct mm_pollgroup
+{
+	mm_call_t *call;
+	mm_list_t  list;
+	int        count;
+};
+
+int  mm_pollgroup_resume(mm_io_t*);
+void mm_pollgroup_unlink(mm_io_t*);
+
+#endif /* MM_POLLGROUP_H */
@@ -8,6 +8,70 @@
 #include <machinarium.h>
 #include <machinarium_private.h>
 
+/*
+ * Readahead buffer is a shared message, so messages returned
+ * by machine_read() can reference its data instead of copying
+ * it (see mm_readahead_slice()).
+ *
+ * Data before readahead_pos_read is never overwritten while
+ * the buffer is referenced, instead io switches to a new buffer.
+*/
+
+int
+mm_readahead_alloc(mm_io_t *io, int size)
+{
+	mm_msg_t *buf = io->readahead_buf;
+	if (buf && mm_buf_size(&buf->data) >= size)
+		return 0;
+	int rc;
+	if (buf && ! mm_msg_is_shared(buf))
+		return mm_buf_ensure(&buf->data, size);
+
+	mm_msg_t *next = mm_msg_shared_create();
+	if (next == NULL)
+		return -1;
+	rc = mm_buf_ensure(&next->data, size);
+	if (rc == -1) {
+		mm_msg_shared_unref(next);
+		return -1;
+	}
+	if (buf) {
+		/* move unread data */
+		int ra_left = io->readahead_pos - io->readahead_pos_read;
+		memcpy(next->data.start, buf->data.start + io->readahead_pos_read,
+		       ra_left);
+		io->readahead_pos = ra_left;
+		io->readahead_pos_read = 0;
+		mm_msg_shared_unref(buf);
+	}
+	io->readahead_buf = next;
+	return 0;
+}
+
+int
+mm_readahead_reset(mm_io_t *io)
+{
+	assert(io->readahead_pos_read == io->readahead_pos);
+	mm_msg_t *buf = io->readahead_buf;
+	if (buf && mm_msg_is_shared(buf)) {
+		/* buffer is still referenced by messages */
+		mm_msg_t *next = mm_msg_shared_create();
+		if (next == NULL)
+			return -1;
+		int rc;
+		rc = mm_buf_ensure(&next->data, io->readahead_size);
+		if (rc == -1) {
+			mm_msg_shared_unref(next);
+			return -1;
+		}
+		io->readahead_buf = next;
+		mm_msg_shared_unref(buf);
+	}
+	io->readahead_pos = 0;
+	io->readahead_pos_read = 0;
+	return 0;
+}
+
 int
 mm_read_start(mm_io_t *io, mm_fd_callback_t callback, void *arg)
 {
@@ -15,12 +79,18 @@ mm_read_start(mm_io_t *io, mm_fd_callback_t callback, void *arg)
 
 	int rc;
 	if (mm_readahead_enabled(io)) {
-		rc = mm_buf_ensure(&io->readahead_buf, io->readahead_size);
+		rc = mm_readahead_alloc(io, io->readahead_size);
 		if (rc == -1) {
 			mm_errno_set(ENOMEM);
 			return -1;
 		}
 	}
+	if (io->poll_group) {
+		/* read events are delivered by the poll group */
+		assert(arg == io);
+		io->poll_on_read = callback;
+		return mm_pollgroup_resume(io);
+	}
 	rc = mm_loop_read(&machine->loop, &io->handle, callback, arg);
 	if (rc == -1) {
 		mm_errno_set(errno);
@@ -33,6 +103,10 @@ int
 mm_read_stop(mm_io_t *io)
 {
 	mm_machine_t *machine = mm_self;
+	if (io->poll_group) {
+		io->poll_on_read = NULL;
+		return 0;
+	}
 	int rc;
 	rc = mm_loop_read_stop(&machine->loop, &io->handle);
 	if (rc == -1) {
@@ -54,7 +128,7 @@ mm_readahead_cb(mm_fd_t *handle)
 	int rc;
 	while (left > 0)
 	{
-		rc = mm_socket_read(io->fd, io->readahead_buf.start + io->readahead_pos, left);
+		rc = mm_socket_read(io->fd, io->readahead_buf->data.start + io->readahead_pos, left);
 		if (rc == -1) {
 			int errno_ = errno;
 			if (errno_ == EAGAIN ||
@@ -105,7 +179,7 @@ mm_readahead_read(mm_io_t *io, uint32_t time_ms)
 	assert(io->readahead_pos >= io->readahead_pos_read);
 	int ra_left = io->readahead_pos - io->readahead_pos_read;
 	if (ra_left >= io->read_size) {
-		memcpy(io->read_buf, io->readahead_buf.start + io->readahead_pos_read,
+		memcpy(io->read_buf, io->readahead_buf->data.start + io->readahead_pos_read,
 		       io->read_size);
 		io->readahead_pos_read += io->read_size;
 		return 0;
@@ -123,7 +197,7 @@ mm_readahead_read(mm_io_t *io, uint32_t time_ms)
 	int copy_pos = 0;
 	if (ra_left > 0) {
 		memcpy(io->read_buf,
-		       io->readahead_buf.start + io->readahead_pos_read,
+		       io->readahead_buf->data.start + io->readahead_pos_read,
 		       ra_left);
 		io->readahead_pos_read += ra_left;
 		io->read_size -= ra_left;
@@ -131,13 +205,14 @@ mm_readahead_read(mm_io_t *io, uint32_t time_ms)
 	}
 
 	/* reset readahead position */
-	assert(io->readahead_pos_read == io->readahead_pos);
-	io->readahead_pos = 0;
-	io->readahead_pos_read = 0;
-	mm_buf_reset(&io->readahead_buf);
+	int rc;
+	rc = mm_readahead_reset(io);
+	if (rc == -1) {
+		mm_errno_set(ENOMEM);
+		return -1;
+	}
 
 	/* maybe allocate readahead buffer and-or start io */
-	int rc;
 	rc = mm_read_start(io, mm_readahead_cb, io);
 	if (rc == -1)
 		return -1;
@@ -159,12 +234,100 @@ mm_readahead_read(mm_io_t *io, uint32_t time_ms)
 	}
 
 	memcpy(io->read_buf + copy_pos,
-	       io->readahead_buf.start + io->readahead_pos_read,
+	       io->readahead_buf->data.start + io->readahead_pos_read,
 	       io->read_size);
 	io->readahead_pos_read += io->read_size;
 	return 0;
 }
 
+static int
+mm_readahead_slice(mm_io_t *io, mm_msg_t *msg, int size, uint32_t time_ms)
+{
+	/* reference readahead data by the message, or return 1 if
+	 * the data can not be placed contiguously in the buffer */
+	mm_msg_t *buf = io->readahead_buf;
+	if (size > io->readahead_size)
+		return 1;
+	int extend = msg->origin != NULL;
+	if (extend) {
+		/* continue message slice */
+		if (msg->origin != buf ||
+		    msg->data.pos != buf->data.start + io->readahead_pos_read)
+			return 1;
+	} else
+	if (mm_buf_used(&msg->data) > 0) {
+		return 1;
+	}
+
+	mm_errno_set(0);
+	if (mm_call_is_active(&io->call)) {
+		mm_errno_set(EINPROGRESS);
+		return -1;
+	}
+	if (! io->attached) {
+		mm_errno_set(ENOTCONN);
+		return -1;
+	}
+
+	int rc;
+	int ra_left = io->readahead_pos - io->readahead_pos_read;
+	if (ra_left < size)
+	{
+		if (io->readahead_status != 0) {
+			mm_errno_set(io->readahead_status);
+			return -1;
+		}
+		if (io->read_eof || !io->connected) {
+			mm_errno_set(ECONNRESET);
+			return -1;
+		}
+
+		/* keep filling referenced buffer while it has space left,
+		 * otherwise start from the beginning */
+		int space = io->readahead_size - io->readahead_pos;
+		int reset = buf == NULL || space < size - ra_left;
+		if (! reset && ra_left == 0)
+			reset = ! mm_msg_is_shared(buf);
+		if (reset) {
+			if (ra_left > 0 || extend)
+				return 1;
+			rc = mm_readahead_reset(io);
+			if (rc == -1) {
+				mm_errno_set(ENOMEM);
+				return -1;
+			}
+		}
+
+		io->read_size = size;
+		rc = mm_read_start(io, mm_readahead_cb, io);
+		if (rc == -1)
+			return -1;
+
+		/* wait for completion */
+		mm_call(&io->call, MM_CALL_READ, time_ms);
+
+		rc = io->call.status;
+		if (rc == 0)
+			rc = io->readahead_status;
+		if (rc != 0) {
+			mm_errno_set(rc);
+			return -1;
+		}
+		ra_left = io->readahead_pos - io->readahead_pos_read;
+		if (ra_left < size) {
+			mm_errno_set(ECONNRESET);
+			return -1;
+		}
+	}
+
+	if (extend)
+		mm_msg_slice_extend(msg, size);
+	else
+		mm_msg_slice(msg, io->readahead_buf, io->readahead_pos_read, size);
+	io->readahead_pos_read += size;
+	return 0;
+}
+
 static void
 mm_readraw_cb(mm_fd_t *handle)
 {
@@ -214,7 +377,8 @@ mm_readraw(mm_io_t *io, char *buf, int size, uint32_t time_ms)
 	io->read_pos  = 0;
 
 	/* try optimistic first */
-	io->handle.on_read = mm_readraw_cb;
+	if (! io->poll_group)
+		io->handle.on_read = mm_readraw_cb;
 	io->handle.on_read_arg = io;
 	mm_call_fast(&io->call, MM_CALL_READ, (void(*)(void*))mm_readraw_cb,
 	             &io->handle);
@@ -263,8 +427,17 @@ int mm_read(mm_io_t *io, char *buf, int size, uint32_t time_ms)
 		return -1;
 	}
 
-	if (! mm_readahead_enabled(io))
-		return mm_readraw(io, buf, size, time_ms);
+	if (! mm_readahead_enabled(io)) {
+		if (! io->poll_group)
+			return mm_readraw(io, buf, size, time_ms);
+		io->poll_ready = 0;
+		int rc;
+		rc = mm_readraw(io, buf, size, time_ms);
+		io->poll_on_read = NULL;
+		if (mm_pollgroup_resume(io) == -1)
+			return -1;
+		return rc;
+	}
 
 	/* split read buffer into readahead-sized chunks */
 	int total = 0;
@@ -289,14 +462,19 @@ MACHINE_API int
 machine_read_to(machine_io_t *obj, machine_msg_t *msg, int size, uint32_t time_ms)
 {
 	mm_io_t *io = mm_cast(mm_io_t*, obj);
-	int position = machine_msg_get_size(msg);
 	int rc;
+	if (mm_readahead_enabled(io) && !mm_tlsio_read_is_active(&io->tls)) {
+		rc = mm_readahead_slice(io, mm_cast(mm_msg_t*, msg), size, time_ms);
+		if (rc != 1)
+			return rc;
+	}
+	int position = machine_msg_get_size(msg);
 	rc = machine_msg_write(msg, NULL, size);
 	if (rc == -1)
 		return -1;
 	char *buf;
 	buf = (char*)machine_msg_get_data(msg) + position;
-	if (mm_tlsio_is_active(&io->tls))
+	if (mm_tlsio_read_is_active(&io->tls))
 		rc = mm_tlsio_read(&io->tls, buf, size, time_ms);
 	else
 		rc = mm_read(io, buf, size, time_ms);
@@ -325,7 +503,7 @@ machine_set_readahead(machine_io_t *obj, int size)
 	mm_io_t *io = mm_cast(mm_io_t*, obj);
 	mm_errno_set(0);
 	int rc;
-	rc = mm_buf_ensure(&io->readahead_buf, size);
+	rc = mm_readahead_alloc(io, size);
 	if (rc == -1) {
 		mm_errno_set(ENOMEM);
 		return -1;
@@ -350,7 +528,7 @@ machine_read_pending(machine_io_t *obj)
 	}
 
 	/* check if there are any data buffered inside SSL context */
-	if (mm_tlsio_is_active(&io->tls) && mm_tlsio_read_pending(&io->tls))
+	if (mm_tlsio_read_is_active(&io->tls) && mm_tlsio_read_pending(&io->tls))
 		return 1;
 
 	if (mm_readahead_enabled(io)) {
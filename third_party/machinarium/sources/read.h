@@ -15,6 +15,8 @@ mm_readahead_enabled(mm_io_t *io)
 	return io->readahead_size > 0;
 }
 
+int  mm_readahead_alloc(mm_io_t*, int);
+int  mm_readahead_reset(mm_io_t*);
 int  mm_read_start(mm_io_t*, mm_fd_callback_t, void*);
 int  mm_read_stop(mm_io_t*);
 int  mm_read(mm_io_t*, char*, int, uint32_t);
@@ -40,6 +40,10 @@ machine_read_poll(machine_io_t **obj_set, machine_io_t **obj_set_ready, int coun
 	int ready = 0;
 	int i;
 	for (i = 0; i < count; i++) {
+		if (io_set[i]->poll_group) {
+			mm_errno_set(EINPROGRESS);
+			return -1;
+		}
 		rc = machine_read_pending(obj_set[i]);
 		if (rc == -1)
 			return -1;
@@ -36,15 +36,82 @@ mm_scheduler_main(void *arg)
 	mm_scheduler_yield(scheduler);
 }
 
+/*
+ * Coroutines are indexed by id in a hash table, so signal, cancel
+ * and join do not depend on the number of coroutines. Ids are
+ * allocated sequentially, which makes the low bits a perfect hash.
+*/
+
+static inline mm_list_t*
+mm_scheduler_id_hash_allocate(int size)
+{
+	mm_list_t *hash;
+	hash = malloc(sizeof(mm_list_t) * size);
+	if (hash == NULL)
+		return NULL;
+	int i;
+	for (i = 0; i < size; i++)
+		mm_list_init(&hash[i]);
+	return hash;
+}
+
+static inline void
+mm_scheduler_id_hash_grow(mm_scheduler_t *scheduler)
+{
+	int size = scheduler->id_hash_size * 2;
+	mm_list_t *hash;
+	hash = mm_scheduler_id_hash_allocate(size);
+	/* keep longer chains on allocation failure */
+	if (hash == NULL)
+		return;
+	int i;
+	for (i = 0; i < scheduler->id_hash_size; i++) {
+		mm_list_t *j, *n;
+		mm_list_foreach_safe(&scheduler->id_hash[i], j, n) {
+			mm_coroutine_t *coroutine;
+			coroutine = mm_container_of(j, mm_coroutine_t, link_id);
+			mm_list_append(&hash[coroutine->id & (size - 1)],
+			               &coroutine->link_id);
+		}
+	}
+	free(scheduler->id_hash);
+	scheduler->id_hash = hash;
+	scheduler->id_hash_size = size;
+}
+
+static inline void
+mm_scheduler_id_add(mm_scheduler_t *scheduler, mm_coroutine_t *coroutine)
+{
+	if (scheduler->id_hash_count >= scheduler->id_hash_size)
+		mm_scheduler_id_hash_grow(scheduler);
+	mm_list_t *bucket;
+	bucket = &scheduler->id_hash[coroutine->id & (scheduler->id_hash_size - 1)];
+	mm_list_append(bucket, &coroutine->link_id);
+	scheduler->id_hash_count++;
+}
+
+static inline void
+mm_scheduler_id_delete(mm_scheduler_t *scheduler, mm_coroutine_t *coroutine)
+{
+	mm_list_unlink(&coroutine->link_id);
+	mm_list_init(&coroutine->link_id);
+	scheduler->id_hash_count--;
+}
+
 int mm_scheduler_init(mm_scheduler_t *scheduler)
 {
 	mm_list_init(&scheduler->list_ready);
 	mm_list_init(&scheduler->list_active);
-	scheduler->id_seq       = 0;
-	scheduler->count_ready  = 0;
-	scheduler->count_active = 0;
+	scheduler->id_seq        = 0;
+	scheduler->count_ready   = 0;
+	scheduler->count_active  = 0;
+	scheduler->id_hash_size  = MM_SCHEDULER_ID_HASH;
+	scheduler->id_hash_count = 0;
+	scheduler->id_hash = mm_scheduler_id_hash_allocate(scheduler->id_hash_size);
+	if (scheduler->id_hash == NULL)
+		return -1;
 	mm_coroutine_init(&scheduler->main);
-	scheduler->current      = &scheduler->main;
+	scheduler->current       = &scheduler->main;
 	return 0;
 }
 
@@ -60,6 +127,8 @@ void mm_scheduler_free(mm_scheduler_t *scheduler)
 		coroutine = mm_container_of(i, mm_coroutine_t, link);
 		mm_coroutine_free(coroutine);
 	}
+	free(scheduler->id_hash);
+	scheduler->id_hash = NULL;
 }
 
 void mm_scheduler_run(mm_scheduler_t *scheduler, mm_coroutine_cache_t *cache)
@@ -70,8 +139,10 @@ void mm_scheduler_run(mm_scheduler_t *scheduler, mm_coroutine_cache_t *cache)
 		coroutine = mm_container_of(scheduler->list_ready.next, mm_coroutine_t, link);
 		mm_scheduler_set(&mm_self->scheduler, coroutine, MM_CACTIVE);
 		mm_scheduler_call(&mm_self->scheduler, coroutine);
-		if (coroutine->state == MM_CFREE)
+		if (coroutine->state == MM_CFREE) {
+			mm_stackarena_sample(&cache->arena, coroutine->stack.slot);
 			mm_coroutine_cache_push(cache, coroutine);
+		}
 	}
 }
 
@@ -84,6 +155,7 @@ void mm_scheduler_new(mm_scheduler_t *scheduler,
 	mm_list_init(&coroutine->joiners);
 	coroutine->cancel = 0;
 	coroutine->id = scheduler->id_seq++;
+	mm_scheduler_id_add(scheduler, coroutine);
 	coroutine->function = function;
 	coroutine->function_arg = arg;
 	mm_context_create(&coroutine->context,
@@ -94,15 +166,12 @@ void mm_scheduler_new(mm_scheduler_t *scheduler,
 mm_coroutine_t*
 mm_scheduler_find(mm_scheduler_t *scheduler, uint64_t id)
 {
-	mm_coroutine_t *coroutine;
+	mm_list_t *bucket;
+	bucket = &scheduler->id_hash[id & (scheduler->id_hash_size - 1)];
 	mm_list_t *i;
-	mm_list_foreach(&scheduler->list_ready, i) {
-		coroutine = mm_container_of(i, mm_coroutine_t, link);
-		if (coroutine->id == id)
-			return coroutine;
-	}
-	mm_list_foreach(&scheduler->list_active, i) {
-		coroutine = mm_container_of(i, mm_coroutine_t, link);
+	mm_list_foreach(bucket, i) {
+		mm_coroutine_t *coroutine;
+		coroutine = mm_container_of(i, mm_coroutine_t, link_id);
 		if (coroutine->id == id)
 			return coroutine;
 	}
@@ -143,6 +212,8 @@ void mm_scheduler_set(mm_scheduler_t *scheduler, mm_coroutine_t *coroutine,
 	mm_list_init(&coroutine->link);
 	if (state != MM_CFREE)
 		mm_list_append(target, &coroutine->link);
+	else
+		mm_scheduler_id_delete(scheduler, coroutine);
 	coroutine->state = state;
 }
 
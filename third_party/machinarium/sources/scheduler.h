@@ -9,6 +9,8 @@
 
 typedef struct mm_scheduler mm_scheduler_t;
 
+#define MM_SCHEDULER_ID_HASH 64
+
 struct mm_scheduler
 {
 	mm_coroutine_t *current;
@@ -17,6 +19,9 @@ struct mm_scheduler
 	int             count_active;
 	mm_list_t       list_ready;
 	mm_list_t       list_active;
+	mm_list_t      *id_hash;
+	int             id_hash_size;
+	int             id_hash_count;
 	uint64_t        id_seq;
 };
 
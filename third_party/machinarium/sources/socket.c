@@ -84,6 +84,14 @@ int mm_socket_set_reuseaddr(int fd, int enable)
 	return rc;
 }
 
+int mm_socket_set_reuseport(int fd, int enable)
+{
+	int rc;
+	rc = setsockopt(fd, SOL_SOCKET, SO_REUSEPORT, &enable,
+	                sizeof(enable));
+	return rc;
+}
+
 int mm_socket_set_ipv6only(int fd, int enable)
 {
 	int rc;
@@ -154,7 +162,11 @@ int mm_socket_listen(int fd, int backlog)
 int mm_socket_accept(int fd, struct sockaddr *sa, socklen_t *slen)
 {
 	int rc;
+#if defined(SOCK_NONBLOCK) && defined(SOCK_CLOEXEC)
+	rc = accept4(fd, sa, slen, SOCK_NONBLOCK|SOCK_CLOEXEC);
+#else
 	rc = accept(fd, sa, slen);
+#endif
 	return rc;
 }
 
@@ -172,6 +184,106 @@ int mm_socket_writev(int fd, struct iovec *iov, int iovc)
 	return rc;
 }
 
+int mm_socket_set_zerocopy(int fd, int enable)
+{
+#if defined(SO_ZEROCOPY) && defined(MSG_ZEROCOPY)
+	int rc;
+	rc = setsockopt(fd, SOL_SOCKET, SO_ZEROCOPY, &enable,
+	                sizeof(enable));
+	return rc;
+#else
+	(void)fd;
+	(void)enable;
+	errno = ENOTSUP;
+	return -1;
+#endif
+}
+
+int mm_socket_writev_zerocopy(int fd, struct iovec *iov, int iovc)
+{
+#if defined(SO_ZEROCOPY) && defined(MSG_ZEROCOPY)
+	struct msghdr msg;
+	memset(&msg, 0, sizeof(msg));
+	msg.msg_iov = iov;
+	msg.msg_iovlen = iovc;
+	int rc;
+	rc = sendmsg(fd, &msg, MSG_ZEROCOPY);
+	return rc;
+#else
+	return writev(fd, iov, iovc);
+#endif
+}
+
+int mm_socket_zerocopy_complete(int fd, uint32_t *id, int *copied)
+{
+#if defined(SO_ZEROCOPY) && defined(MSG_ZEROCOPY)
+	char control[CMSG_SPACE(sizeof(struct sock_extended_err))];
+	struct msghdr msg;
+	memset(&msg, 0, sizeof(msg));
+	msg.msg_control = control;
+	msg.msg_controllen = sizeof(control);
+	int rc;
+	rc = recvmsg(fd, &msg, MSG_ERRQUEUE);
+	if (rc == -1)
+		return -1;
+	struct cmsghdr *cmsg;
+	cmsg = CMSG_FIRSTHDR(&msg);
+	if (cmsg == NULL)
+		return 0;
+	struct sock_extended_err *ee;
+	ee = (struct sock_extended_err*)CMSG_DATA(cmsg);
+	if (ee->ee_errno != 0 || ee->ee_origin != SO_EE_ORIGIN_ZEROCOPY)
+		return 0;
+	/* notification covers send calls in range [ee_info, ee_data] */
+	*id = ee->ee_data;
+	*copied = (ee->ee_code & SO_EE_CODE_ZEROCOPY_COPIED) != 0;
+	return 1;
+#else
+	(void)fd;
+	(void)id;
+	(void)copied;
+	errno = EAGAIN;
+	return -1;
+#endif
+}
+
+int mm_socket_set_ulp(int fd, char *name)
+{
+	int rc;
+	rc = setsockopt(fd, SOL_TCP, TCP_ULP, name, strlen(name) + 1);
+	return rc;
+}
+
+int mm_socket_set_tls(int fd, int tx, void *crypto_info, int size)
+{
+	int rc;
+	rc = setsockopt(fd, SOL_TLS, tx ? TLS_TX : TLS_RX, crypto_info, size);
+	return rc;
+}
+
+int mm_socket_write_record(int fd, int type, void *buf, int size)
+{
+	char control[CMSG_SPACE(sizeof(unsigned char))];
+	struct iovec iov;
+	iov.iov_base = buf;
+	iov.iov_len = size;
+	struct msghdr msg;
+	memset(&msg, 0, sizeof(msg));
+	msg.msg_iov = &iov;
+	msg.msg_iovlen = 1;
+	msg.msg_control = control;
+	msg.msg_controllen = sizeof(control);
+	struct cmsghdr *cmsg;
+	cmsg = CMSG_FIRSTHDR(&msg);
+	cmsg->cmsg_level = SOL_TLS;
+	cmsg->cmsg_type = TLS_SET_RECORD_TYPE;
+	cmsg->cmsg_len = CMSG_LEN(sizeof(unsigned char));
+	*((unsigned char*)CMSG_DATA(cmsg)) = type;
+	int rc;
+	rc = sendmsg(fd, &msg, 0);
+	return rc;
+}
+
 int mm_socket_read(int fd, void *buf, int size)
 {
 	int rc;
@@ -179,6 +291,21 @@ int mm_socket_read(int fd, void *buf, int size)
 	return rc;
 }
 
+int mm_socket_pipe(int *fds)
+{
+	int rc;
+	rc = pipe2(fds, O_NONBLOCK|O_CLOEXEC);
+	return rc;
+}
+
+int mm_socket_splice(int fd_in, int fd_out, int size)
+{
+	int rc;
+	rc = splice(fd_in, NULL, fd_out, NULL, size,
+	            SPLICE_F_MOVE|SPLICE_F_NONBLOCK);
+	return rc;
+}
+
 int mm_socket_getsockname(int fd, struct sockaddr *sa, socklen_t *salen)
 {
 	int rc;
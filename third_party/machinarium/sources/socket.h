@@ -14,6 +14,7 @@ int mm_socket_set_nodelay(int, int);
 int mm_socket_set_keepalive(int, int, int);
 int mm_socket_set_nosigpipe(int, int);
 int mm_socket_set_reuseaddr(int, int);
+int mm_socket_set_reuseport(int, int);
 int mm_socket_set_ipv6only(int, int);
 int mm_socket_error(int);
 int mm_socket_connect(int, struct sockaddr*);
@@ -22,7 +23,15 @@ int mm_socket_listen(int, int);
 int mm_socket_accept(int, struct sockaddr*, socklen_t*);
 int mm_socket_write(int, void*, int);
 int mm_socket_writev(int, struct iovec*, int);
+int mm_socket_set_zerocopy(int, int);
+int mm_socket_writev_zerocopy(int, struct iovec*, int);
+int mm_socket_zerocopy_complete(int, uint32_t*, int*);
+int mm_socket_set_ulp(int, char*);
+int mm_socket_set_tls(int, int, void*, int);
+int mm_socket_write_record(int, int, void*, int);
 int mm_socket_read(int, void*, int);
+int mm_socket_pipe(int*);
+int mm_socket_splice(int, int, int);
 int mm_socket_getsockname(int, struct sockaddr*, socklen_t*);
 int mm_socket_getpeername(int, struct sockaddr*, socklen_t*);
 int mm_socket_getaddrinfo(char*, char*, struct addrinfo*,
@@ -0,0 +1,259 @@
+
+/*
+ * machinarium.
+ *
+ * cooperative multitasking engine.
+*/
+
+#include <machinarium.h>
+#include <machinarium_private.h>
+
+/*
+ * Move data between two sockets through a pipe owned by destination
+ * io, without copying it to the user space.
+*/
+
+#define MM_SPLICE_PIPE_SIZE (256 * 1024)
+
+void
+mm_splice_free(mm_io_t *io)
+{
+	if (io->splice_pipe[0] != -1) {
+		close(io->splice_pipe[0]);
+		close(io->splice_pipe[1]);
+	}
+	io->splice_pipe[0] = -1;
+	io->splice_pipe[1] = -1;
+	io->splice_pipe_size = 0;
+}
+
+static inline int
+mm_splice_pipe(mm_io_t *io)
+{
+	if (io->splice_pipe[0] != -1)
+		return 0;
+	int rc;
+	rc = mm_socket_pipe(io->splice_pipe);
+	if (rc == -1) {
+		mm_errno_set(errno);
+		return -1;
+	}
+	/* try to use larger pipe buffer */
+	fcntl(io->splice_pipe[1], F_SETPIPE_SZ, MM_SPLICE_PIPE_SIZE);
+	rc = fcntl(io->splice_pipe[1], F_GETPIPE_SZ);
+	if (rc == -1) {
+		mm_errno_set(errno);
+		mm_splice_free(io);
+		return -1;
+	}
+	io->splice_pipe_size = rc;
+	return 0;
+}
+
+static void
+mm_splice_read_cb(mm_fd_t *handle)
+{
+	mm_io_t *io = handle->on_read_arg;
+	mm_call_t *call = &io->call;
+	if (mm_call_is(call, MM_CALL_READ)) {
+		if (call->coroutine)
+			mm_scheduler_wakeup(&mm_self->scheduler, call->coroutine);
+	}
+}
+
+static void
+mm_splice_write_cb(mm_fd_t *handle)
+{
+	mm_io_t *io = handle->on_write_arg;
+	mm_call_t *call = &io->call;
+	if (mm_call_is(call, MM_CALL_FLUSH)) {
+		if (call->coroutine)
+			mm_scheduler_wakeup(&mm_self->scheduler, call->coroutine);
+	}
+}
+
+static inline int
+mm_splice_wait_write(mm_io_t *io, uint32_t time_ms)
+{
+	mm_machine_t *machine = mm_self;
+	int rc;
+	rc = mm_loop_write(&machine->loop, &io->handle, mm_splice_write_cb, io);
+	if (rc == -1) {
+		mm_errno_set(errno);
+		return -1;
+	}
+	mm_call(&io->call, MM_CALL_FLUSH, time_ms);
+	mm_loop_write_stop(&machine->loop, &io->handle);
+	rc = io->call.status;
+	if (rc != 0) {
+		mm_errno_set(rc);
+		return -1;
+	}
+	return 0;
+}
+
+static inline int
+mm_splice_wait_read(mm_io_t *io, uint32_t time_ms)
+{
+	mm_call(&io->call, MM_CALL_READ, time_ms);
+	int rc;
+	rc = io->call.status;
+	if (rc != 0) {
+		mm_errno_set(rc);
+		return -1;
+	}
+	return 0;
+}
+
+static int
+mm_splice(mm_io_t *dst, mm_io_t *src, int size, uint32_t time_ms)
+{
+	int left = size;
+	int pending = 0;
+	while (left > 0 || pending > 0)
+	{
+		int progress = 0;
+		int write_blocked = 0;
+		int rc;
+
+		/* socket to pipe */
+		if (left > 0 && pending < dst->splice_pipe_size) {
+			rc = mm_socket_splice(src->fd, dst->splice_pipe[1], left);
+			if (rc == -1) {
+				int errno_ = errno;
+				if (errno_ != EAGAIN && errno_ != EWOULDBLOCK &&
+				    errno_ != EINTR) {
+					src->connected = 0;
+					mm_errno_set(errno_);
+					return -1;
+				}
+			} else
+			if (rc == 0) {
+				/* eof */
+				src->connected = 0;
+				src->read_eof  = 1;
+				mm_errno_set(ECONNRESET);
+				return -1;
+			} else {
+				left    -= rc;
+				pending += rc;
+				progress = 1;
+			}
+		}
+
+		/* pipe to socket */
+		if (pending > 0) {
+			rc = mm_socket_splice(dst->splice_pipe[0], dst->fd, pending);
+			if (rc == -1) {
+				int errno_ = errno;
+				if (errno_ != EAGAIN && errno_ != EWOULDBLOCK &&
+				    errno_ != EINTR) {
+					dst->write_status = errno_;
+					mm_errno_set(errno_);
+					return -1;
+				}
+				write_blocked = 1;
+			} else {
+				pending -= rc;
+				progress = 1;
+			}
+		}
+
+		if (progress)
+			continue;
+
+		/* wait for socket to become ready */
+		if (write_blocked)
+			rc = mm_splice_wait_write(dst, time_ms);
+		else
+			rc = mm_splice_wait_read(src, time_ms);
+		if (rc == -1)
+			return -1;
+	}
+	return 0;
+}
+
+static inline int
+mm_splice_copy(mm_io_t *dst, mm_io_t *src, int size, uint32_t time_ms)
+{
+	machine_msg_t *msg;
+	msg = machine_read((machine_io_t*)src, size, time_ms);
+	if (msg == NULL)
+		return -1;
+	return machine_write((machine_io_t*)dst, msg);
+}
+
+MACHINE_API int
+machine_splice(machine_io_t *obj_dst, machine_io_t *obj_src, int size,
+               uint32_t time_ms)
+{
+	mm_io_t *dst = mm_cast(mm_io_t*, obj_dst);
+	mm_io_t *src = mm_cast(mm_io_t*, obj_src);
+	mm_errno_set(0);
+
+	if (mm_call_is_active(&src->call) || mm_call_is_active(&dst->call)) {
+		mm_errno_set(EINPROGRESS);
+		return -1;
+	}
+	if (! src->attached || ! dst->attached || ! dst->connected) {
+		mm_errno_set(ENOTCONN);
+		return -1;
+	}
+	if (dst->write_status != 0) {
+		mm_errno_set(dst->write_status);
+		return -1;
+	}
+	if (size <= 0)
+		return 0;
+
+	/* data has to be decrypted or framed, copy it */
+	if (mm_tlsio_read_is_active(&src->tls) || mm_tlsio_write_is_active(&dst->tls) ||
+	    src->is_eventfd || dst->is_eventfd)
+		return mm_splice_copy(dst, src, size, time_ms);
+
+	/* keep order with queued messages */
+	int rc;
+	rc = machine_flush(obj_dst, time_ms);
+	if (rc == -1)
+		return -1;
+
+	rc = mm_splice_pipe(dst);
+	if (rc == -1)
+		return -1;
+
+	/* take over read events, so readahead does not consume
+	 * spliced data */
+	rc = mm_read_start(src, mm_splice_read_cb, src);
+	if (rc == -1)
+		return -1;
+
+	/* forward buffered data first */
+	if (mm_readahead_enabled(src)) {
+		int ra_left = src->readahead_pos - src->readahead_pos_read;
+		if (ra_left > size)
+			ra_left = size;
+		if (ra_left > 0) {
+			rc = mm_splice_copy(dst, src, ra_left, time_ms);
+			if (rc == 0)
+				rc = machine_flush(obj_dst, time_ms);
+			if (rc == -1)
+				goto done;
+			size -= ra_left;
+		}
+	}
+	if (size > 0 && (src->read_eof || ! src->connected)) {
+		mm_errno_set(ECONNRESET);
+		rc = -1;
+		goto done;
+	}
+
+	rc = mm_splice(dst, src, size, time_ms);
+	if (rc == -1) {
+		/* pipe might keep data of unfinished transfer */
+		mm_splice_free(dst);
+	}
+
+done:
+	mm_read_stop(src);
+	return rc;
+}
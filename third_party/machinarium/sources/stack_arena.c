@@ -0,0 +1,291 @@
+
+/*
+ * machinarium.
+ *
+ * cooperative multitasking engine.
+*/
+
+#include <machinarium.h>
+#include <machinarium_private.h>
+
+/*
+ * Coroutine stacks are carved out of large reservations.
+ *
+ * A chunk is reserved without access rights and a slot stack is
+ * made writable only when the slot is carved for the first time,
+ * its guard page keeps PROT_NONE and is reused together with the
+ * slot. Released slots return their pages to the kernel but stay
+ * mapped, so reuse costs no syscalls.
+ *
+ * With huge pages enabled a chunk is mapped writable at once and
+ * advised for THP. A guard page or a per-slot madvise() would split
+ * the huge page, so this mode requires guard pages to be disabled
+ * and released slots keep their pages.
+ *
+ * Stack usage is sampled when a coroutine finishes. Pages below the
+ * painted area are only looked up with mincore(), the painted area
+ * is filled with a canary pattern and scanned word by word. Once
+ * sampled, the used part of the stack is painted again, so the next
+ * coroutine on this slot is measured on its own.
+*/
+
+int mm_stackarena_init(mm_stackarena_t *arena, size_t size, size_t page_size,
+                       int hugepages, int guard)
+{
+	assert(! (hugepages && guard));
+	arena->size         = size;
+	arena->size_guard   = guard ? page_size : 0;
+	arena->size_slot    = arena->size + arena->size_guard;
+	arena->page_size    = page_size;
+	arena->hugepages    = hugepages;
+	arena->chunk_slots  = MM_STACKARENA_CHUNK / arena->size_slot;
+	if (arena->chunk_slots == 0)
+		arena->chunk_slots = 1;
+	arena->count_chunks = 0;
+	arena->count_free   = 0;
+	arena->used_count   = 0;
+	arena->used_sum     = 0;
+	arena->used_max     = 0;
+	arena->used_pages   = calloc(size / page_size + 1, sizeof(uint64_t));
+	mm_list_init(&arena->chunks);
+	mm_list_init(&arena->free_list);
+	if (arena->used_pages == NULL)
+		return -1;
+	return 0;
+}
+
+static inline void
+mm_stackchunk_free(mm_stackchunk_t *chunk)
+{
+	munmap(chunk->base, chunk->size);
+	free(chunk->slots);
+	free(chunk->vec);
+	free(chunk);
+}
+
+void mm_stackarena_free(mm_stackarena_t *arena)
+{
+	mm_list_t *i, *n;
+	mm_list_foreach_safe(&arena->chunks, i, n) {
+		mm_stackchunk_t *chunk;
+		chunk = mm_container_of(i, mm_stackchunk_t, link);
+		mm_stackchunk_free(chunk);
+	}
+	mm_list_init(&arena->chunks);
+	mm_list_init(&arena->free_list);
+	arena->count_chunks = 0;
+	arena->count_free = 0;
+	free(arena->used_pages);
+	arena->used_pages = NULL;
+}
+
+static inline char*
+mm_stackarena_reserve(mm_stackarena_t *arena, size_t size)
+{
+	int flags = MAP_PRIVATE|MAP_ANONYMOUS|MAP_NORESERVE;
+	if (! arena->hugepages) {
+		char *base;
+		base = mmap(NULL, size, PROT_NONE, flags, -1, 0);
+		if (base == MAP_FAILED)
+			return NULL;
+		return base;
+	}
+
+	/* huge pages require chunk alignment */
+	size_t align = MM_STACKARENA_CHUNK;
+	char *base;
+	base = mmap(NULL, size + align, PROT_READ|PROT_WRITE, flags, -1, 0);
+	if (base == MAP_FAILED)
+		return NULL;
+	char *aligned;
+	aligned = (char*)(((uintptr_t)base + align - 1) & ~(uintptr_t)(align - 1));
+	if (aligned > base)
+		munmap(base, aligned - base);
+	char *end = base + size + align;
+	if (aligned + size < end)
+		munmap(aligned + size, end - (aligned + size));
+#ifdef MADV_HUGEPAGE
+	madvise(aligned, size, MADV_HUGEPAGE);
+#endif
+	return aligned;
+}
+
+static inline mm_stackchunk_t*
+mm_stackchunk_create(mm_stackarena_t *arena)
+{
+	mm_stackchunk_t *chunk;
+	chunk = malloc(sizeof(mm_stackchunk_t));
+	if (chunk == NULL)
+		return NULL;
+	chunk->count        = arena->chunk_slots;
+	chunk->count_carved = 0;
+	chunk->size         = arena->size_slot * chunk->count;
+	chunk->arena        = arena;
+	chunk->slots        = malloc(sizeof(mm_stackslot_t) * chunk->count);
+	chunk->vec          = malloc(chunk->size / arena->page_size);
+	if (chunk->slots == NULL || chunk->vec == NULL)
+		goto error;
+	chunk->base = mm_stackarena_reserve(arena, chunk->size);
+	if (chunk->base == NULL)
+		goto error;
+	mm_list_init(&chunk->link);
+	return chunk;
+error:
+	free(chunk->slots);
+	free(chunk->vec);
+	free(chunk);
+	return NULL;
+}
+
+static inline void
+mm_stackarena_paint(char *pointer, size_t size)
+{
+	uint64_t *word = (uint64_t*)pointer;
+	uint64_t *end  = (uint64_t*)(pointer + size);
+	while (word < end)
+		*word++ = MM_STACKARENA_CANARY;
+}
+
+static inline mm_stackslot_t*
+mm_stackchunk_carve(mm_stackarena_t *arena, mm_stackchunk_t *chunk)
+{
+	mm_stackslot_t *slot;
+	slot = &chunk->slots[chunk->count_carved];
+	slot->pointer = chunk->base + arena->size_slot * chunk->count_carved +
+	                arena->size_guard;
+	slot->painted = 0;
+	slot->chunk = chunk;
+	mm_list_init(&slot->link);
+	if (arena->hugepages) {
+		/* huge page is committed as a whole anyway */
+		mm_stackarena_paint(slot->pointer, arena->size);
+		slot->painted = arena->size;
+	} else {
+		int rc;
+		rc = mprotect(slot->pointer, arena->size, PROT_READ|PROT_WRITE);
+		if (rc == -1)
+			return NULL;
+	}
+	chunk->count_carved++;
+	return slot;
+}
+
+mm_stackslot_t*
+mm_stackarena_pop(mm_stackarena_t *arena)
+{
+	/* reuse released slot */
+	if (arena->count_free > 0) {
+		mm_list_t *first = mm_list_pop(&arena->free_list);
+		arena->count_free--;
+		return mm_container_of(first, mm_stackslot_t, link);
+	}
+
+	/* carve new slot from the last chunk */
+	mm_stackchunk_t *chunk = NULL;
+	if (arena->count_chunks > 0) {
+		chunk = mm_container_of(arena->chunks.prev, mm_stackchunk_t, link);
+		if (chunk->count_carved == chunk->count)
+			chunk = NULL;
+	}
+	if (chunk == NULL) {
+		chunk = mm_stackchunk_create(arena);
+		if (chunk == NULL)
+			return NULL;
+		mm_list_append(&arena->chunks, &chunk->link);
+		arena->count_chunks++;
+	}
+	return mm_stackchunk_carve(arena, chunk);
+}
+
+static inline uint64_t
+mm_stackarena_used(mm_stackarena_t *arena, mm_stackslot_t *slot)
+{
+	/* stack grows down, so the lowest touched address gives
+	 * the high-water mark */
+	char *top = slot->pointer + arena->size;
+	size_t unpainted = arena->size - slot->painted;
+	if (unpainted > 0) {
+		mm_stackchunk_t *chunk = slot->chunk;
+		unsigned char *vec;
+		vec = chunk->vec + (slot->pointer - chunk->base) / arena->page_size;
+		int rc;
+		rc = mincore(slot->pointer, unpainted, vec);
+		if (rc == 0) {
+			size_t pages = unpainted / arena->page_size;
+			size_t i;
+			for (i = 0; i < pages; i++)
+				if (vec[i] & 1)
+					return top - (slot->pointer + i * arena->page_size);
+		}
+	}
+	uint64_t *word = (uint64_t*)(top - slot->painted);
+	uint64_t *end  = (uint64_t*)top;
+	while (word < end && *word == MM_STACKARENA_CANARY)
+		word++;
+	return (char*)end - (char*)word;
+}
+
+uint64_t mm_stackarena_sample(mm_stackarena_t *arena, mm_stackslot_t *slot)
+{
+	uint64_t used;
+	used = mm_stackarena_used(arena, slot);
+
+	size_t pages;
+	pages = (used + arena->page_size - 1) / arena->page_size;
+	arena->used_pages[pages]++;
+	arena->used_count++;
+	arena->used_sum += used;
+	if (used > arena->used_max)
+		arena->used_max = used;
+
+	/* paint used pages again, they are resident already */
+	size_t paint = pages * arena->page_size;
+	mm_stackarena_paint(slot->pointer + arena->size - paint, paint);
+	if (paint > slot->painted)
+		slot->painted = paint;
+	return used;
+}
+
+void mm_stackarena_push(mm_stackarena_t *arena, mm_stackslot_t *slot)
+{
+	/* keep huge pages intact */
+	if (! arena->hugepages) {
+		madvise(slot->pointer, arena->size, MADV_DONTNEED);
+		slot->painted = 0;
+	}
+	mm_list_init(&slot->link);
+	mm_list_push(&arena->free_list, &slot->link);
+	arena->count_free++;
+}
+
+void mm_stackarena_stat(mm_stackarena_t *arena,
+                        uint64_t *reserved,
+                        uint64_t *used_avg,
+                        uint64_t *used_p99,
+                        uint64_t *used_max,
+                        uint64_t *used_count)
+{
+	*reserved = (uint64_t)arena->count_chunks * arena->chunk_slots *
+	            arena->size_slot;
+	*used_max = arena->used_max;
+	*used_count = arena->used_count;
+	*used_avg = 0;
+	*used_p99 = 0;
+	if (arena->used_count == 0)
+		return;
+	*used_avg = arena->used_sum / arena->used_count;
+
+	/* page granular percentile over sampled coroutines */
+	uint64_t skip = arena->used_count / 100;
+	size_t pages = arena->size / arena->page_size;
+	size_t i = pages;
+	for (;;) {
+		if (arena->used_pages[i] > skip || i == 0)
+			break;
+		skip -= arena->used_pages[i];
+		i--;
+	}
+	*used_p99 = i * arena->page_size;
+	if (*used_p99 > arena->used_max)
+		*used_p99 = arena->used_max;
+}
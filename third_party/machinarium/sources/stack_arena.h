@@ -0,0 +1,69 @@
+#ifndef MM_STACK_ARENA_H
+#define MM_STACK_ARENA_H
+
+/*
+ * machinarium.
+ *
+ * cooperative multitasking engine.
+*/
+
+typedef struct mm_stackslot  mm_stackslot_t;
+typedef struct mm_stackchunk mm_stackchunk_t;
+typedef struct mm_stackarena mm_stackarena_t;
+
+/* size of a single reservation, sized for one huge page */
+#define MM_STACKARENA_CHUNK (2 * 1024 * 1024)
+
+/* pattern of stack words not written since the last sample */
+#define MM_STACKARENA_CANARY 0x6d6d737461636b21ULL
+
+struct mm_stackslot
+{
+	char            *pointer;
+	size_t           painted;
+	mm_stackchunk_t *chunk;
+	mm_list_t        link;
+};
+
+struct mm_stackchunk
+{
+	char            *base;
+	size_t           size;
+	int              count;
+	int              count_carved;
+	mm_stackslot_t  *slots;
+	unsigned char   *vec;
+	mm_stackarena_t *arena;
+	mm_list_t        link;
+};
+
+struct mm_stackarena
+{
+	size_t     size;
+	size_t     size_guard;
+	size_t     size_slot;
+	size_t     page_size;
+	int        hugepages;
+	int        chunk_slots;
+	mm_list_t  chunks;
+	int        count_chunks;
+	mm_list_t  free_list;
+	int        count_free;
+	uint64_t   used_count;
+	uint64_t   used_sum;
+	uint64_t   used_max;
+	uint64_t  *used_pages;
+};
+
+int  mm_stackarena_init(mm_stackarena_t*, size_t, size_t, int, int);
+void mm_stackarena_free(mm_stackarena_t*);
+void mm_stackarena_stat(mm_stackarena_t*, uint64_t*, uint64_t*,
+                        uint64_t*, uint64_t*, uint64_t*);
+
+mm_stackslot_t*
+mm_stackarena_pop(mm_stackarena_t*);
+
+void     mm_stackarena_push(mm_stackarena_t*, mm_stackslot_t*);
+uint64_t mm_stackarena_sample(mm_stackarena_t*, mm_stackslot_t*);
+
+#endif /* MM_STACK_ARENA_H */
@@ -11,11 +11,21 @@ typedef struct mm_task mm_task_t;
 
 typedef void (*mm_task_function_t)(void*);
 
+enum
+{
+	MM_TASK_WAIT,
+	MM_TASK_SIGNAL,
+	MM_TASK_SIGNALED,
+	MM_TASK_DETACHED
+};
+
 struct mm_task
 {
 	mm_task_function_t function;
 	void              *arg;
 	mm_event_t         on_complete;
+	int                state;
+	int                refs;
 };
 
 #endif /* MM_TASK_H */
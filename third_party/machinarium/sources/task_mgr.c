@@ -13,6 +13,21 @@ enum {
 	MM_TASK_EXIT
 };
 
+/*
+ * Task message is shared by the waiter and the resolver thread and
+ * is freed by the last one. Waiter which gives up on timeout detaches
+ * from the task, so the result is dropped and no signal is sent.
+*/
+
+static inline void
+mm_task_unref(mm_msg_t *msg)
+{
+	mm_task_t *task;
+	task = (mm_task_t*)msg->data.start;
+	if (__sync_sub_and_fetch(&task->refs, 1) == 0)
+		machine_msg_free((machine_msg_t*)msg);
+}
+
 static void
 mm_taskmgr_main(void *arg __attribute__((unused)))
 {
@@ -34,8 +49,18 @@ mm_taskmgr_main(void *arg __attribute__((unused)))
 		mm_task_t *task;
 		task = (mm_task_t*)msg->data.start;
 		task->function(task->arg);
+
+		/* wakeup waiter, unless it is detached */
+		if (! __sync_bool_compare_and_swap(&task->state, MM_TASK_WAIT,
+		                                   MM_TASK_SIGNAL)) {
+			mm_task_unref(msg);
+			continue;
+		}
 		int event_mgr_fd;
 		event_mgr_fd = mm_eventmgr_signal(&task->on_complete);
+		__sync_bool_compare_and_swap(&task->state, MM_TASK_SIGNAL,
+		                             MM_TASK_SIGNALED);
+		mm_task_unref(msg);
 		if (event_mgr_fd > 0)
 			mm_eventmgr_wakeup(event_mgr_fd);
 	}
@@ -99,22 +124,55 @@ int mm_taskmgr_new(mm_taskmgr_t *mgr,
 	task = (mm_task_t*)msg->data.start;
 	task->function = function;
 	task->arg = arg;
+	task->state = MM_TASK_WAIT;
+	task->refs = 2;
 	mm_eventmgr_add(&mm_self->event_mgr, &task->on_complete);
 
 	/* schedule task */
 	mm_channel_write(&mgr->channel, msg);
 
 	/* wait for completion */
-	time_ms = UINT32_MAX;
-
-	int ready;
-	ready = mm_eventmgr_wait(&mm_self->event_mgr, &task->on_complete, time_ms);
-	if (! ready) {
-		/* todo: */
-		abort();
-		return 0;
+	mm_call(&task->on_complete.call, MM_CALL_EVENT, time_ms);
+	int status = task->on_complete.call.status;
+
+	if (__sync_bool_compare_and_swap(&task->state, MM_TASK_WAIT,
+	                                 MM_TASK_DETACHED)) {
+		/* timedout or cancelled, task continues without waiter */
+		mm_eventmgr_del(&mm_self->event_mgr, &task->on_complete);
+		mm_task_unref(msg);
+		mm_errno_set(status ? status : ETIMEDOUT);
+		return -1;
 	}
 
-	machine_msg_free((machine_msg_t*)msg);
+	/* task is complete, make sure signal is done */
+	unsigned int spin_count = 0U;
+	while (*(volatile int*)&task->state != MM_TASK_SIGNALED) {
+		MM_SLEEPLOCK_BACKOFF;
+		if (++spin_count > 30U)
+			usleep(1);
+	}
+	mm_eventmgr_del(&mm_self->event_mgr, &task->on_complete);
+	mm_task_unref(msg);
+	return 0;
+}
+
+int mm_taskmgr_post(mm_taskmgr_t *mgr,
+                    mm_task_function_t function, void *arg)
+{
+	mm_msg_t *msg;
+	msg = (mm_msg_t*)machine_msg_create(sizeof(mm_task_t));
+	if (msg == NULL)
+		return -1;
+	msg->type = MM_TASK;
+
+	mm_task_t *task;
+	task = (mm_task_t*)msg->data.start;
+	task->function = function;
+	task->arg = arg;
+	task->state = MM_TASK_DETACHED;
+	task->refs = 1;
+
+	/* schedule task, nobody waits for completion */
+	mm_channel_write(&mgr->channel, msg);
 	return 0;
 }
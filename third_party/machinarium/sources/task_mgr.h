@@ -21,5 +21,6 @@ void mm_taskmgr_init(mm_taskmgr_t*);
 int  mm_taskmgr_start(mm_taskmgr_t*, int);
 void mm_taskmgr_stop(mm_taskmgr_t*);
 int  mm_taskmgr_new(mm_taskmgr_t*, mm_task_function_t, void*, uint32_t);
+int  mm_taskmgr_post(mm_taskmgr_t*, mm_task_function_t, void*);
 
 #endif /* MM_TASK_MGR_H */
@@ -17,6 +17,7 @@ struct mm_timer
 	uint64_t             timeout;
 	uint32_t             interval;
 	int                  seq;
+	int                  index;
 	mm_timer_callback_t  callback;
 	void                *arg;
 	void                *clock;
@@ -30,6 +31,7 @@ mm_timer_init(mm_timer_t *timer, mm_timer_callback_t cb, void *arg,
 	timer->interval = interval;
 	timer->timeout = 0;
 	timer->seq = 0;
+	timer->index = -1;
 	timer->callback = cb;
 	timer->arg = arg;
 	timer->clock = NULL;
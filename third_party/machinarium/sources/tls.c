@@ -57,6 +57,96 @@ mm_tls_lock_free(void)
 
 #endif
 
+#if !USE_BORINGSSL && defined(SSL_OP_ENABLE_KTLS) && !defined(OPENSSL_NO_KTLS)
+
+/*
+ * Kernel TLS.
+ *
+ * OpenSSL switches the connection to kernel TLS itself, when the
+ * negotiated cipher allows it, by passing crypto state to the BIO.
+ * These BIO controls are not part of the public OpenSSL API and
+ * mirror the socket BIO implementation.
+ *
+ * Only transmit direction is offloaded. Kernel fails plain reads of
+ * non application data records (alerts, session tickets, key updates),
+ * so received records are always processed by OpenSSL.
+*/
+
+#define MM_TLS_KTLS
+
+#define MM_BIO_CTRL_SET_KTLS                  72
+#define MM_BIO_CTRL_SET_KTLS_TX_SEND_CTRL_MSG 74
+#define MM_BIO_CTRL_CLEAR_KTLS_TX_CTRL_MSG    75
+
+static inline int
+mm_tlsio_ktls_info_size(void *crypto_info)
+{
+	struct tls_crypto_info *info = crypto_info;
+	switch (info->cipher_type) {
+	case TLS_CIPHER_AES_GCM_128:
+		return sizeof(struct tls12_crypto_info_aes_gcm_128);
+	case TLS_CIPHER_AES_GCM_256:
+		return sizeof(struct tls12_crypto_info_aes_gcm_256);
+#ifdef TLS_CIPHER_AES_CCM_128
+	case TLS_CIPHER_AES_CCM_128:
+		return sizeof(struct tls12_crypto_info_aes_ccm_128);
+#endif
+#ifdef TLS_CIPHER_CHACHA20_POLY1305
+	case TLS_CIPHER_CHACHA20_POLY1305:
+		return sizeof(struct tls12_crypto_info_chacha20_poly1305);
+#endif
+	}
+	return 0;
+}
+
+static inline long
+mm_tlsio_ktls_start(mm_tlsio_t *io, int tx, void *crypto_info)
+{
+	mm_io_t *io_ = io->io;
+	if (! io->ktls || ! tx)
+		return 0;
+	/* queued records are already encrypted */
+	if (tx && io_->write_queue_count > 0)
+		return 0;
+	int size;
+	size = mm_tlsio_ktls_info_size(crypto_info);
+	if (size == 0)
+		return 0;
+	int rc;
+	if (! io->ktls_ulp) {
+		rc = mm_socket_set_ulp(io_->fd, "tls");
+		if (rc == -1)
+			return 0;
+		io->ktls_ulp = 1;
+	}
+	rc = mm_socket_set_tls(io_->fd, tx, crypto_info, size);
+	if (rc == -1)
+		return 0;
+	/* not supported by kernel tls */
+	io_->zerocopy_size = 0;
+	io->ktls_tx = 1;
+	return 1;
+}
+
+static inline int
+mm_tlsio_ktls_write_record(mm_tlsio_t *io, const char *buf, int size)
+{
+	mm_io_t *io_ = io->io;
+	int rc;
+	rc = machine_flush((machine_io_t*)io_, io->time_ms);
+	if (rc == -1)
+		return -1;
+	rc = mm_socket_write_record(io_->fd, io->ktls_record_type,
+	                            (void*)buf, size);
+	if (rc == -1) {
+		mm_errno_set(errno);
+		return -1;
+	}
+	return rc;
+}
+
+#endif
+
 static int
 mm_tlsio_write_cb(BIO *bio, const char *buf, int size)
 {
@@ -65,6 +155,10 @@ mm_tlsio_write_cb(BIO *bio, const char *buf, int size)
 	io = BIO_get_data(bio);
 #else
 	io = BIO_get_app_data(bio);
+#endif
+#ifdef MM_TLS_KTLS
+	if (io->ktls_record_type)
+		return mm_tlsio_ktls_write_record(io, buf, size);
 #endif
 	int rc = mm_write_buf(io->io, (char*)buf, size);
 	if (rc == -1)
@@ -81,7 +175,8 @@ mm_tlsio_read_cb(BIO *bio, char *buf, int size)
 #else
 	io = BIO_get_app_data(bio);
 #endif
-	int rc = mm_read(io->io, buf, size, io->time_ms);
+	int rc;
+	rc = mm_read(io->io, buf, size, io->time_ms);
 	if (rc == -1)
 		return -1;
 	return size;
@@ -92,6 +187,10 @@ mm_tlsio_ctrl_cb(BIO *bio, int cmd, long larg, void *parg)
 {
 	(void)parg;
 	long ret = 1;
+#ifdef MM_TLS_KTLS
+	mm_tlsio_t *io;
+	io = BIO_get_app_data(bio);
+#endif
 	switch (cmd) {
 #if !USE_BORINGSSL && (OPENSSL_VERSION_NUMBER < 0x10100000L)
 	case BIO_CTRL_SET_CLOSE:
@@ -111,7 +210,32 @@ mm_tlsio_ctrl_cb(BIO *bio, int cmd, long larg, void *parg)
 	case BIO_CTRL_DUP:
 		break;
 	case BIO_CTRL_FLUSH:
+#ifdef MM_TLS_KTLS
+		/* data must be written before kernel takes over encryption */
+		if (io->ktls) {
+			int rc;
+			rc = machine_flush((machine_io_t*)io->io, io->time_ms);
+			ret = rc == 0;
+		}
+#endif
+		break;
+#ifdef MM_TLS_KTLS
+	case MM_BIO_CTRL_SET_KTLS:
+		ret = mm_tlsio_ktls_start(io, larg, parg);
+		break;
+	case BIO_CTRL_GET_KTLS_SEND:
+		ret = io->ktls_tx;
+		break;
+	case BIO_CTRL_GET_KTLS_RECV:
+		ret = 0;
+		break;
+	case MM_BIO_CTRL_SET_KTLS_TX_SEND_CTRL_MSG:
+		io->ktls_record_type = larg;
+		break;
+	case MM_BIO_CTRL_CLEAR_KTLS_TX_CTRL_MSG:
+		io->ktls_record_type = 0;
 		break;
+#endif
 	case BIO_CTRL_INFO:
 	case BIO_CTRL_GET:
 	case BIO_CTRL_SET:
@@ -187,11 +311,14 @@ void mm_tlsio_init(mm_tlsio_t *io, void *io_arg)
 
 void mm_tlsio_free(mm_tlsio_t *io)
 {
-	if (io->ctx)
-		SSL_CTX_free(io->ctx);
-	/* free io->ssl and io->bio */
-	if (io->ssl)
+	/* free io->ssl and io->bio, context is owned by mm_tls_t */
+	if (io->ssl) {
+		/* connections are closed without close_notify, keep the
+		 * session resumable unless it was failed by an alert */
+		if (SSL_is_init_finished(io->ssl))
+			SSL_set_shutdown(io->ssl, SSL_SENT_SHUTDOWN);
 		SSL_free(io->ssl);
+	}
 }
 
 void mm_tlsio_error_reset(mm_tlsio_t *io)
@@ -264,13 +391,36 @@ mm_tlsio_error(mm_tlsio_t *io, int ssl_rc, char *fmt, ...)
 	io->error = 1;
 }
 
+/*
+ * SSL context is created once per machine_tls_t and shared by all
+ * connections, so that the server session cache and session ticket
+ * keys are common for a listener and a client keeps the last
+ * session of a storage to resume it on the next connect.
+ *
+ * Context is built without holding the lock, since it reads
+ * certificate and key files, and published by the first connection
+ * to finish it. Concurrent connections drop their own copy.
+*/
+
 static int
-mm_tlsio_prepare(mm_tls_t *tls, mm_tlsio_t *io, int client)
+mm_tls_session_new_cb(SSL *ssl, SSL_SESSION *session)
+{
+	mm_tls_t *tls = SSL_CTX_get_app_data(SSL_get_SSL_CTX(ssl));
+	mm_sleeplock_lock(&tls->lock);
+	SSL_SESSION *prev = tls->session;
+	tls->session = session;
+	mm_sleeplock_unlock(&tls->lock);
+	if (prev)
+		SSL_SESSION_free(prev);
+	/* keep the session reference */
+	return 1;
+}
+
+static SSL_CTX*
+mm_tls_ctx_create(mm_tls_t *tls, mm_tlsio_t *io, int client)
 {
 	SSL_CTX *ctx = NULL;
-	SSL *ssl = NULL;
-	SSL_METHOD *ssl_method = NULL;;
-	BIO *bio = NULL;
+	SSL_METHOD *ssl_method = NULL;
 	if (client)
 		ssl_method = (SSL_METHOD*)SSLv23_client_method();
 	else
@@ -278,14 +428,19 @@ mm_tlsio_prepare(mm_tls_t *tls, mm_tlsio_t *io, int client)
 	ctx = SSL_CTX_new(ssl_method);
 	if (ctx == NULL) {
 		mm_tlsio_error(io, 0, "SSL_CTX_new()");
-		return -1;
+		return NULL;
 	}
+	SSL_CTX_set_app_data(ctx, tls);
 
 	SSL_CTX_set_options(ctx, SSL_OP_NO_SSLv2);
 	SSL_CTX_set_options(ctx, SSL_OP_NO_SSLv3);
 	SSL_CTX_set_mode(ctx, SSL_MODE_ENABLE_PARTIAL_WRITE);
 	SSL_CTX_set_mode(ctx, SSL_MODE_ACCEPT_MOVING_WRITE_BUFFER);
 	SSL_CTX_set_mode(ctx, SSL_MODE_RELEASE_BUFFERS);
+#ifdef MM_TLS_KTLS
+	if (tls->ktls)
+		SSL_CTX_set_options(ctx, SSL_OP_ENABLE_KTLS);
+#endif
 
 	/* verify mode */
 	int verify = 0;
@@ -349,6 +504,61 @@ mm_tlsio_prepare(mm_tls_t *tls, mm_tlsio_t *io, int client)
 	if (! client)
 		SSL_CTX_set_options(ctx, SSL_OP_CIPHER_SERVER_PREFERENCE);
 
+	/* session cache and tickets */
+	if (client) {
+		SSL_CTX_set_session_cache_mode(ctx, SSL_SESS_CACHE_CLIENT|
+		                                    SSL_SESS_CACHE_NO_INTERNAL_STORE);
+		SSL_CTX_sess_set_new_cb(ctx, mm_tls_session_new_cb);
+	} else {
+		const unsigned char session_id_context[] = "machinarium";
+		SSL_CTX_set_session_cache_mode(ctx, SSL_SESS_CACHE_SERVER);
+		rc = SSL_CTX_set_session_id_context(ctx, session_id_context,
+		                                    sizeof(session_id_context) - 1);
+		if (rc != 1) {
+			mm_tlsio_error(io, 0, "SSL_CTX_set_session_id_context()");
+			goto error;
+		}
+	}
+	return ctx;
+error:
+	SSL_CTX_free(ctx);
+	return NULL;
+}
+
+static inline SSL_CTX*
+mm_tls_ctx(mm_tls_t *tls, mm_tlsio_t *io, int client)
+{
+	SSL_CTX **ptr = client ? &tls->ctx_client : &tls->ctx_server;
+	SSL_CTX *ctx;
+	ctx = __atomic_load_n(ptr, __ATOMIC_ACQUIRE);
+	if (ctx)
+		return ctx;
+	ctx = mm_tls_ctx_create(tls, io, client);
+	if (ctx == NULL)
+		return NULL;
+	SSL_CTX *prev;
+	prev = __sync_val_compare_and_swap(ptr, NULL, ctx);
+	if (prev) {
+		SSL_CTX_free(ctx);
+		ctx = prev;
+	}
+	return ctx;
+}
+
+static int
+mm_tlsio_prepare(mm_tls_t *tls, mm_tlsio_t *io, int client)
+{
+	SSL_CTX *ctx = NULL;
+	SSL *ssl = NULL;
+	BIO *bio = NULL;
+	ctx = mm_tls_ctx(tls, io, client);
+	if (ctx == NULL)
+		return -1;
+#ifdef MM_TLS_KTLS
+	io->ktls = tls->ktls;
+#endif
+
+	int rc;
 	ssl = SSL_new(ctx);
 	if (ssl == NULL) {
 		mm_tlsio_error(io, 0, "SSL_new()");
@@ -364,6 +574,14 @@ mm_tlsio_prepare(mm_tls_t *tls, mm_tlsio_t *io, int client)
 		}
 	}
 
+	/* resume last session */
+	if (client) {
+		mm_sleeplock_lock(&tls->lock);
+		if (tls->session)
+			SSL_set_session(ssl, tls->session);
+		mm_sleeplock_unlock(&tls->lock);
+	}
+
 	bio = BIO_new(mm_tls_method);
 	if (bio == NULL) {
 		mm_tlsio_error(io, 0, "BIO_new()");
@@ -387,7 +605,6 @@ mm_tlsio_prepare(mm_tls_t *tls, mm_tlsio_t *io, int client)
 	io->bio = bio;
 	return 0;
 error:
-	SSL_CTX_free(ctx);
 	if (ssl)
 		SSL_free(ssl);
 	if (bio)
@@ -395,6 +612,14 @@ error:
 	return -1;
 }
 
+static inline void
+mm_tlsio_handshake_stat(mm_tlsio_t *io, mm_tls_t *tls)
+{
+	__sync_fetch_and_add(&tls->handshakes, 1);
+	if (SSL_session_reused(io->ssl))
+		__sync_fetch_and_add(&tls->reused, 1);
+}
+
 static inline int
 mm_tlsio_verify_name(char *cert_name, const char *name)
 {
@@ -511,6 +736,7 @@ int mm_tlsio_connect(mm_tlsio_t *io, mm_tls_t *tls)
 		mm_tlsio_error(io, rc, "SSL_connect()");
 		return -1;
 	}
+	mm_tlsio_handshake_stat(io, tls);
 	if (tls->server) {
 		rc = mm_tlsio_verify_common_name(io, tls->server);
 		if (rc == -1)
@@ -536,6 +762,7 @@ int mm_tlsio_accept(mm_tlsio_t *io, mm_tls_t *tls)
 		mm_tlsio_error(io, rc, "SSL_accept()");
 		return -1;
 	}
+	mm_tlsio_handshake_stat(io, tls);
 	return 0;
 }
 
@@ -564,6 +791,17 @@ int mm_tlsio_write(mm_tlsio_t *io, char *buf, int size)
 	return 0;
 }
 
+int mm_tlsio_ktls_send(mm_tlsio_t *io)
+{
+#ifdef MM_TLS_KTLS
+	return io->ktls_tx;
+#else
+	(void)io;
+	mm_errno_set(ENOTSUP);
+	return -1;
+#endif
+}
+
 int mm_tlsio_read_pending(mm_tlsio_t *io)
 {
 	return SSL_pending(io->ssl) > 0;
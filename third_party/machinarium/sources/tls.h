@@ -18,6 +18,11 @@ struct mm_tlsio
 	char      error_msg[128];
 	uint32_t  time_ms;
 	void     *io;
+	/* kernel tls */
+	int       ktls;
+	int       ktls_ulp;
+	int       ktls_tx;
+	int       ktls_record_type;
 };
 
 void mm_tls_init(void);
@@ -28,6 +33,18 @@ mm_tlsio_is_active(mm_tlsio_t *io) {
 	return io->ssl != NULL;
 }
 
+/* read is always done by OpenSSL, write is done by OpenSSL
+ * unless it is offloaded to kernel tls */
+static inline int
+mm_tlsio_read_is_active(mm_tlsio_t *io) {
+	return io->ssl != NULL;
+}
+
+static inline int
+mm_tlsio_write_is_active(mm_tlsio_t *io) {
+	return io->ssl != NULL && !io->ktls_tx;
+}
+
 void mm_tlsio_init(mm_tlsio_t*, void*);
 void mm_tlsio_free(mm_tlsio_t*);
 void mm_tlsio_error_reset(mm_tlsio_t*);
@@ -35,6 +52,7 @@ int  mm_tlsio_connect(mm_tlsio_t*, mm_tls_t*);
 int  mm_tlsio_accept(mm_tlsio_t*, mm_tls_t*);
 int  mm_tlsio_close(mm_tlsio_t*);
 int  mm_tlsio_write(mm_tlsio_t*, char*, int);
+int  mm_tlsio_ktls_send(mm_tlsio_t*);
 int  mm_tlsio_read_pending(mm_tlsio_t*);
 int  mm_tlsio_read(mm_tlsio_t*, char*, int, uint32_t);
 int  mm_tlsio_verify_common_name(mm_tlsio_t*, char*);
@@ -25,6 +25,13 @@ machine_tls_create(void)
 	tls->ca_file   = NULL;
 	tls->cert_file = NULL;
 	tls->key_file  = NULL;
+	tls->ktls      = 0;
+	mm_sleeplock_init(&tls->lock);
+	tls->ctx_client = NULL;
+	tls->ctx_server = NULL;
+	tls->session    = NULL;
+	tls->handshakes = 0;
+	tls->reused     = 0;
 	return (machine_tls_t*)tls;
 }
 
@@ -45,6 +52,12 @@ machine_tls_free(machine_tls_t *obj)
 		free(tls->cert_file);
 	if (tls->key_file)
 		free(tls->key_file);
+	if (tls->ctx_client)
+		SSL_CTX_free(tls->ctx_client);
+	if (tls->ctx_server)
+		SSL_CTX_free(tls->ctx_server);
+	if (tls->session)
+		SSL_SESSION_free(tls->session);
 	free(tls);
 }
 
@@ -161,6 +174,23 @@ machine_tls_set_key_file(machine_tls_t *obj, char *path)
 	return 0;
 }
 
+MACHINE_API int
+machine_tls_set_ktls(machine_tls_t *obj, int enable)
+{
+	mm_tls_t *tls = mm_cast(mm_tls_t*, obj);
+	mm_errno_set(0);
+	tls->ktls = enable;
+	return 0;
+}
+
+MACHINE_API void
+machine_tls_stat(machine_tls_t *obj, uint64_t *handshakes, uint64_t *reused)
+{
+	mm_tls_t *tls = mm_cast(mm_tls_t*, obj);
+	*handshakes = __sync_fetch_and_add(&tls->handshakes, 0);
+	*reused     = __sync_fetch_and_add(&tls->reused, 0);
+}
+
 MACHINE_API int
 machine_set_tls(machine_io_t *obj, machine_tls_t *tls_obj)
 {
@@ -25,6 +25,15 @@ struct mm_tls
 	char          *ca_file;
 	char          *cert_file;
 	char          *key_file;
+	int            ktls;
+	/* contexts are shared by connections and published once,
+	 * lock guards the client session */
+	SSL_CTX       *ctx_client;
+	SSL_CTX       *ctx_server;
+	mm_sleeplock_t lock;
+	SSL_SESSION   *session;
+	uint64_t       handshakes;
+	uint64_t       reused;
 };
 
 #endif /* MM_TLS_API_H */
@@ -0,0 +1,516 @@
+
+/*
+ * machinarium.
+ *
+ * cooperative multitasking engine.
+*/
+
+#include <machinarium.h>
+#include <machinarium_private.h>
+
+#ifdef HAVE_IO_URING
+
+/*
+ * io_uring poll backend.
+ *
+ * Every registered fd owns a slot. Poll requests are tagged with
+ * (slot generation << 32 | slot index), so completions of removed or
+ * re-armed polls are recognised and dropped.
+ *
+ * Polls are one-shot and re-armed after dispatch: read and write
+ * callbacks rely on level-triggered readiness, the same way they
+ * do with epoll. All arm and remove requests produced during a loop
+ * iteration are submitted together with the wait, using a single
+ * io_uring_enter() call.
+ *
+ * Like epoll, an fd with a write callback but no events enabled still
+ * gets error notifications, which is used to reap zero-copy send
+ * completions of an idle io.
+ *
+ * A failed poll request runs the fd callbacks, so the waiter gets the
+ * error from its io call, and the poll is not re-armed until the fd
+ * read or write events are requested again.
+*/
+
+#define MM_URING_ENTRIES 1024
+#define MM_URING_IGNORE  UINT64_MAX
+
+typedef struct mm_uring_slot mm_uring_slot_t;
+typedef struct mm_uring      mm_uring_t;
+
+struct mm_uring_slot
+{
+	mm_fd_t  *fd;
+	uint32_t  gen;
+	int       armed;
+	int       failed;
+	int       next;
+};
+
+struct mm_uring
+{
+	mm_poll_t            poll;
+	int                  fd;
+	void                *sq_ptr;
+	size_t               sq_size;
+	void                *cq_ptr;
+	size_t               cq_size;
+	struct io_uring_sqe *sqes;
+	size_t               sqes_size;
+	unsigned            *sq_head;
+	unsigned            *sq_tail;
+	unsigned            *sq_mask;
+	unsigned            *sq_array;
+	unsigned            *cq_head;
+	unsigned            *cq_tail;
+	unsigned            *cq_mask;
+	struct io_uring_cqe *cqes;
+	unsigned             pending;
+	mm_uring_slot_t     *slots;
+	int                  slots_size;
+	int                  slots_free;
+	int                  count;
+};
+
+static inline int
+mm_uring_setup(unsigned entries, struct io_uring_params *params)
+{
+	return syscall(__NR_io_uring_setup, entries, params);
+}
+
+static inline int
+mm_uring_enter(int fd, unsigned to_submit, unsigned min_complete,
+               unsigned flags, void *arg, size_t arg_size)
+{
+	return syscall(__NR_io_uring_enter, fd, to_submit, min_complete,
+	               flags, arg, arg_size);
+}
+
+static inline uint64_t
+mm_uring_data(mm_uring_t *uring, int id)
+{
+	return ((uint64_t)uring->slots[id].gen << 32) | (uint32_t)id;
+}
+
+static int
+mm_uring_submit(mm_uring_t *uring)
+{
+	while (uring->pending > 0) {
+		int rc;
+		rc = mm_uring_enter(uring->fd, uring->pending, 0, 0, NULL, 0);
+		if (rc == -1) {
+			if (errno == EINTR)
+				continue;
+			return -1;
+		}
+		uring->pending -= rc;
+	}
+	return 0;
+}
+
+static struct io_uring_sqe*
+mm_uring_sqe(mm_uring_t *uring)
+{
+	unsigned head = __atomic_load_n(uring->sq_head, __ATOMIC_ACQUIRE);
+	unsigned tail = *uring->sq_tail;
+	if ((tail - head) > *uring->sq_mask) {
+		/* submission queue is full */
+		int rc = mm_uring_submit(uring);
+		if (rc == -1)
+			return NULL;
+	}
+	unsigned id = tail & *uring->sq_mask;
+	struct io_uring_sqe *sqe = &uring->sqes[id];
+	memset(sqe, 0, sizeof(*sqe));
+	uring->sq_array[id] = id;
+	__atomic_store_n(uring->sq_tail, tail + 1, __ATOMIC_RELEASE);
+	uring->pending++;
+	return sqe;
+}
+
+static inline int
+mm_uring_wanted(mm_fd_t *fd)
+{
+	return fd->mask != 0 || fd->on_write != NULL;
+}
+
+static int
+mm_uring_arm(mm_uring_t *uring, mm_fd_t *fd)
+{
+	mm_uring_slot_t *slot = &uring->slots[fd->poll_id];
+	assert(! slot->armed);
+	if (! mm_uring_wanted(fd))
+		return 0;
+	struct io_uring_sqe *sqe = mm_uring_sqe(uring);
+	if (sqe == NULL)
+		return -1;
+	sqe->opcode = IORING_OP_POLL_ADD;
+	sqe->fd = fd->fd;
+	if (fd->mask & MM_R)
+		sqe->poll32_events |= POLLIN;
+	if (fd->mask & MM_W)
+		sqe->poll32_events |= POLLOUT;
+	if (fd->on_write)
+		sqe->poll32_events |= POLLERR;
+	sqe->user_data = mm_uring_data(uring, fd->poll_id);
+	slot->armed = 1;
+	slot->failed = 0;
+	return 0;
+}
+
+static int
+mm_uring_disarm(mm_uring_t *uring, mm_fd_t *fd)
+{
+	mm_uring_slot_t *slot = &uring->slots[fd->poll_id];
+	if (slot->armed) {
+		struct io_uring_sqe *sqe = mm_uring_sqe(uring);
+		if (sqe == NULL)
+			return -1;
+		sqe->opcode = IORING_OP_POLL_REMOVE;
+		sqe->fd = -1;
+		sqe->addr = mm_uring_data(uring, fd->poll_id);
+		sqe->user_data = MM_URING_IGNORE;
+		slot->armed = 0;
+	}
+	/* invalidate in-flight completions */
+	slot->gen++;
+	return 0;
+}
+
+static mm_poll_t*
+mm_uring_create(void)
+{
+	mm_uring_t *uring;
+	uring = malloc(sizeof(mm_uring_t));
+	if (uring == NULL)
+		return NULL;
+	memset(uring, 0, sizeof(*uring));
+	uring->poll.iface = &mm_uring_if;
+	uring->slots_free = -1;
+
+	struct io_uring_params params;
+	memset(&params, 0, sizeof(params));
+	uring->fd = mm_uring_setup(MM_URING_ENTRIES, &params);
+	if (uring->fd == -1) {
+		free(uring);
+		return NULL;
+	}
+	if (! (params.features & IORING_FEAT_EXT_ARG))
+		goto error;
+
+	uring->sq_size = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+	uring->cq_size = params.cq_off.cqes +
+	                 params.cq_entries * sizeof(struct io_uring_cqe);
+	if (params.features & IORING_FEAT_SINGLE_MMAP) {
+		if (uring->cq_size > uring->sq_size)
+			uring->sq_size = uring->cq_size;
+		uring->cq_size = uring->sq_size;
+	}
+	uring->sq_ptr = mmap(NULL, uring->sq_size, PROT_READ|PROT_WRITE,
+	                     MAP_SHARED|MAP_POPULATE, uring->fd,
+	                     IORING_OFF_SQ_RING);
+	if (uring->sq_ptr == MAP_FAILED) {
+		uring->sq_ptr = NULL;
+		goto error;
+	}
+	if (params.features & IORING_FEAT_SINGLE_MMAP) {
+		uring->cq_ptr = uring->sq_ptr;
+	} else {
+		uring->cq_ptr = mmap(NULL, uring->cq_size, PROT_READ|PROT_WRITE,
+		                     MAP_SHARED|MAP_POPULATE, uring->fd,
+		                     IORING_OFF_CQ_RING);
+		if (uring->cq_ptr == MAP_FAILED) {
+			uring->cq_ptr = NULL;
+			goto error;
+		}
+	}
+	uring->sqes_size = params.sq_entries * sizeof(struct io_uring_sqe);
+	uring->sqes = mmap(NULL, uring->sqes_size, PROT_READ|PROT_WRITE,
+	                   MAP_SHARED|MAP_POPULATE, uring->fd,
+	                   IORING_OFF_SQES);
+	if (uring->sqes == MAP_FAILED) {
+		uring->sqes = NULL;
+		goto error;
+	}
+
+	char *sq = uring->sq_ptr;
+	uring->sq_head  = (unsigned*)(sq + params.sq_off.head);
+	uring->sq_tail  = (unsigned*)(sq + params.sq_off.tail);
+	uring->sq_mask  = (unsigned*)(sq + params.sq_off.ring_mask);
+	uring->sq_array = (unsigned*)(sq + params.sq_off.array);
+	char *cq = uring->cq_ptr;
+	uring->cq_head  = (unsigned*)(cq + params.cq_off.head);
+	uring->cq_tail  = (unsigned*)(cq + params.cq_off.tail);
+	uring->cq_mask  = (unsigned*)(cq + params.cq_off.ring_mask);
+	uring->cqes     = (struct io_uring_cqe*)(cq + params.cq_off.cqes);
+	return &uring->poll;
+
+error:
+	mm_uring_if.shutdown(&uring->poll);
+	mm_uring_if.free(&uring->poll);
+	return NULL;
+}
+
+static void
+mm_uring_free(mm_poll_t *poll)
+{
+	mm_uring_t *uring = (mm_uring_t*)poll;
+	if (uring->sqes)
+		munmap(uring->sqes, uring->sqes_size);
+	if (uring->cq_ptr && uring->cq_ptr != uring->sq_ptr)
+		munmap(uring->cq_ptr, uring->cq_size);
+	if (uring->sq_ptr)
+		munmap(uring->sq_ptr, uring->sq_size);
+	if (uring->slots)
+		free(uring->slots);
+	free(poll);
+}
+
+static int
+mm_uring_shutdown(mm_poll_t *poll)
+{
+	mm_uring_t *uring = (mm_uring_t*)poll;
+	if (uring->fd != -1) {
+		close(uring->fd);
+		uring->fd = -1;
+	}
+	return 0;
+}
+
+static int
+mm_uring_step(mm_poll_t *poll, int timeout)
+{
+	mm_uring_t *uring = (mm_uring_t*)poll;
+	if (uring->count == 0)
+		return mm_uring_submit(uring);
+
+	/* submit pending requests and wait for completions */
+	struct __kernel_timespec ts;
+	struct io_uring_getevents_arg arg;
+	memset(&arg, 0, sizeof(arg));
+	if (timeout >= 0) {
+		ts.tv_sec  = timeout / 1000;
+		ts.tv_nsec = (timeout % 1000) * 1000000;
+		arg.ts = (uint64_t)(uintptr_t)&ts;
+	}
+	int rc;
+	rc = mm_uring_enter(uring->fd, uring->pending, timeout == 0 ? 0 : 1,
+	                    IORING_ENTER_GETEVENTS|IORING_ENTER_EXT_ARG,
+	                    &arg, sizeof(arg));
+	if (rc == -1) {
+		if (errno != ETIME && errno != EINTR &&
+		    errno != EBUSY && errno != EAGAIN)
+			return -1;
+	}
+	/* requests are consumed before the wait is started */
+	unsigned sq_head = __atomic_load_n(uring->sq_head, __ATOMIC_ACQUIRE);
+	uring->pending = *uring->sq_tail - sq_head;
+
+	int count = 0;
+	for (;;)
+	{
+		unsigned head = *uring->cq_head;
+		unsigned tail = __atomic_load_n(uring->cq_tail, __ATOMIC_ACQUIRE);
+		if (head == tail)
+			break;
+		struct io_uring_cqe *cqe = &uring->cqes[head & *uring->cq_mask];
+		uint64_t data = cqe->user_data;
+		int events = cqe->res;
+		__atomic_store_n(uring->cq_head, head + 1, __ATOMIC_RELEASE);
+
+		if (data == MM_URING_IGNORE)
+			continue;
+		int id = (uint32_t)data;
+		uint32_t gen = data >> 32;
+		if (id >= uring->slots_size)
+			continue;
+		mm_uring_slot_t *slot = &uring->slots[id];
+		if (slot->fd == NULL || slot->gen != gen)
+			continue;
+		slot->armed = 0;
+
+		mm_fd_t *fd = slot->fd;
+		slot->failed = events < 0;
+		if (slot->failed) {
+			/* poll request failed (bad fd, unsupported file or out
+			 * of memory), let callbacks run their io, so the error
+			 * is reported to the waiter */
+			events = POLLIN|POLLOUT|POLLERR;
+		}
+		if (events > 0) {
+			if (fd->on_read) {
+				if (events & POLLIN)
+					fd->on_read(fd);
+			}
+			/* callback might remove or re-arm the fd */
+			if (slot->fd == fd && slot->gen == gen && fd->on_write) {
+				if (events & POLLOUT ||
+				    events & POLLERR ||
+				    events & POLLHUP) {
+					fd->on_write(fd);
+				}
+			}
+			count++;
+		}
+		/* failed poll is not retried, until the fd is updated */
+		if (slot->fd == fd && slot->gen == gen && !slot->armed &&
+		    !slot->failed) {
+			rc = mm_uring_arm(uring, fd);
+			if (rc == -1)
+				return -1;
+		}
+	}
+	return count;
+}
+
+static int
+mm_uring_add(mm_poll_t *poll, mm_fd_t *fd, int mask)
+{
+	mm_uring_t *uring = (mm_uring_t*)poll;
+	if (uring->slots_free == -1) {
+		int size = uring->slots_size == 0 ? 64 : uring->slots_size * 2;
+		void *ptr = realloc(uring->slots, sizeof(mm_uring_slot_t) * size);
+		if (ptr == NULL)
+			return -1;
+		uring->slots = ptr;
+		int i = size - 1;
+		for (; i >= uring->slots_size; i--) {
+			uring->slots[i].fd = NULL;
+			uring->slots[i].gen = 0;
+			uring->slots[i].armed = 0;
+			uring->slots[i].failed = 0;
+			uring->slots[i].next = uring->slots_free;
+			uring->slots_free = i;
+		}
+		uring->slots_size = size;
+	}
+	int id = uring->slots_free;
+	mm_uring_slot_t *slot = &uring->slots[id];
+	uring->slots_free = slot->next;
+	slot->fd = fd;
+	slot->armed = 0;
+	slot->failed = 0;
+	slot->next = -1;
+	fd->poll_id = id;
+	fd->mask = mask;
+	int rc;
+	rc = mm_uring_arm(uring, fd);
+	if (rc == -1) {
+		slot->fd = NULL;
+		slot->gen++;
+		slot->next = uring->slots_free;
+		uring->slots_free = id;
+		return -1;
+	}
+	uring->count++;
+	return 0;
+}
+
+static inline int
+mm_uring_modify(mm_poll_t *poll, mm_fd_t *fd, int mask)
+{
+	mm_uring_t *uring = (mm_uring_t*)poll;
+	int rc;
+	rc = mm_uring_disarm(uring, fd);
+	if (rc == -1)
+		return -1;
+	fd->mask = mask;
+	return mm_uring_arm(uring, fd);
+}
+
+static int
+mm_uring_read(mm_poll_t *poll,
+              mm_fd_t *fd,
+              mm_fd_callback_t on_read, void *arg,
+              int enable)
+{
+	int mask = fd->mask;
+	if (enable)
+		mask |= MM_R;
+	else
+		mask &= ~MM_R;
+	fd->on_read = on_read;
+	fd->on_read_arg = arg;
+	/* disarmed fd is armed again, after its poll has failed */
+	mm_uring_slot_t *slot = &((mm_uring_t*)poll)->slots[fd->poll_id];
+	if (mask == fd->mask && !slot->failed)
+		return 0;
+	return mm_uring_modify(poll, fd, mask);
+}
+
+static int
+mm_uring_write(mm_poll_t *poll,
+               mm_fd_t *fd,
+               mm_fd_callback_t on_write, void *arg,
+               int enable)
+{
+	int mask = fd->mask;
+	if (enable)
+		mask |= MM_W;
+	else
+		mask &= ~MM_W;
+	int errors = fd->on_write != NULL;
+	fd->on_write = on_write;
+	fd->on_write_arg = arg;
+	mm_uring_slot_t *slot = &((mm_uring_t*)poll)->slots[fd->poll_id];
+	if (mask == fd->mask && errors == (on_write != NULL) && !slot->failed)
+		return 0;
+	return mm_uring_modify(poll, fd, mask);
+}
+
+static int
+mm_uring_del(mm_poll_t *poll, mm_fd_t *fd)
+{
+	mm_uring_t *uring = (mm_uring_t*)poll;
+	mm_uring_slot_t *slot = &uring->slots[fd->poll_id];
+	assert(slot->fd == fd);
+	int armed = slot->armed;
+	int rc;
+	rc = mm_uring_disarm(uring, fd);
+	slot->fd = NULL;
+	slot->next = uring->slots_free;
+	uring->slots_free = fd->poll_id;
+	fd->mask = 0;
+	fd->on_write = NULL;
+	fd->on_write_arg = NULL;
+	fd->on_read = NULL;
+	fd->on_read_arg = NULL;
+	uring->count--;
+	assert(uring->count >= 0);
+	if (rc == -1)
+		return -1;
+	/* release the file reference held by the poll request
+	 * before the caller closes the fd */
+	if (armed)
+		return mm_uring_submit(uring);
+	return 0;
+}
+
+mm_pollif_t mm_uring_if =
+{
+	.name     = "io_uring",
+	.create   = mm_uring_create,
+	.free     = mm_uring_free,
+	.shutdown = mm_uring_shutdown,
+	.step     = mm_uring_step,
+	.add      = mm_uring_add,
+	.read     = mm_uring_read,
+	.write    = mm_uring_write,
+	.del      = mm_uring_del
+};
+
+#else
+
+static mm_poll_t*
+mm_uring_create(void)
+{
+	return NULL;
+}
+
+mm_pollif_t mm_uring_if =
+{
+	.name     = "io_uring",
+	.create   = mm_uring_create
+};
+
+#endif /* HAVE_IO_URING */
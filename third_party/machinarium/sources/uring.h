@@ -0,0 +1,12 @@
+#ifndef MM_URING_H
+#define MM_URING_H
+
+/*
+ * machinarium.
+ *
+ * cooperative multitasking engine.
+*/
+
+extern mm_pollif_t mm_uring_if;
+
+#endif /* MM_URING_H */
@@ -23,6 +23,113 @@ mm_write_eventfd(mm_io_t *io, char *buf, int size)
 	return 0;
 }
 
+static void mm_write_cb(mm_fd_t*);
+
+/*
+ * Zero-copy write.
+ *
+ * Messages of at least zerocopy_size bytes are sent with MSG_ZEROCOPY.
+ * Kernel keeps referencing their data after the send call, so they are
+ * moved to the zerocopy queue and released only when the socket error
+ * queue reports completion of the send call id. Completions are
+ * expected in send order.
+ *
+ * machine_flush() waits for the completions too, so the data is not
+ * referenced by the kernel once the io is flushed, closed and freed.
+*/
+
+static inline void
+mm_zerocopy_release(mm_io_t *io, uint32_t id)
+{
+	mm_list_t *i, *n;
+	mm_list_foreach_safe(&io->zerocopy_queue, i, n) {
+		mm_msg_t *msg;
+		msg = mm_container_of(i, mm_msg_t, link);
+		if ((int32_t)(msg->zerocopy_id - id) > 0)
+			break;
+		mm_list_unlink(&msg->link);
+		io->zerocopy_queue_count--;
+		machine_msg_free((machine_msg_t*)msg);
+	}
+}
+
+void mm_zerocopy_free(mm_io_t *io)
+{
+	mm_list_t *i, *n;
+	mm_list_foreach_safe(&io->zerocopy_queue, i, n) {
+		mm_msg_t *msg;
+		msg = mm_container_of(i, mm_msg_t, link);
+		machine_msg_free((machine_msg_t*)msg);
+	}
+	mm_list_init(&io->zerocopy_queue);
+	io->zerocopy_queue_count = 0;
+}
+
+static inline void
+mm_zerocopy_complete(mm_io_t *io)
+{
+	while (io->zerocopy_queue_count > 0) {
+		uint32_t id;
+		int copied;
+		int rc;
+		rc = mm_socket_zerocopy_complete(io->fd, &id, &copied);
+		if (rc == -1)
+			break;
+		if (rc == 0)
+			continue;
+		/* kernel had to copy the data anyway (loopback or
+		 * device without scatter-gather support) */
+		if (copied)
+			io->zerocopy_size = 0;
+		mm_zerocopy_release(io, id);
+	}
+}
+
+void mm_zerocopy_attach(mm_io_t *io)
+{
+	mm_machine_t *machine = mm_self;
+	mm_loop_write_errors(&machine->loop, &io->handle, mm_write_cb, io);
+}
+
+static inline int
+mm_write_iov_count(mm_io_t *io, struct iovec *iov, int *zerocopy)
+{
+	int max = io->write_queue_count;
+	if (max > IOV_MAX)
+		max = IOV_MAX;
+	if (io->zerocopy_size == 0 && !io->zerocopy_partial) {
+		*zerocopy = 0;
+		return max;
+	}
+	/* partially sent message must be finished in the same mode */
+	*zerocopy = io->zerocopy_partial ||
+	            iov[0].iov_len >= (size_t)io->zerocopy_size;
+	int count = 1;
+	while (count < max) {
+		int match;
+		match = io->zerocopy_size > 0 &&
+		        iov[count].iov_len >= (size_t)io->zerocopy_size;
+		if (match != *zerocopy)
+			break;
+		count++;
+	}
+	return count;
+}
+
+static inline void
+mm_write_idle(mm_io_t *io)
+{
+	io->write_iov_pos = 0;
+	mm_buf_reset(&io->write_iov);
+
+	if (io->zerocopy_queue_count > 0) {
+		mm_zerocopy_attach(io);
+		return;
+	}
+	mm_machine_t *machine = mm_self;
+	mm_loop_write_stop(&machine->loop, &io->handle);
+}
+
 static void
 mm_write_cb(mm_fd_t *handle)
 {
@@ -31,17 +138,43 @@ mm_write_cb(mm_fd_t *handle)
 	if (mm_call_is_aborted(call))
 		return;
 
-	int iov_to_write = io->write_queue_count;
-	if (iov_to_write > IOV_MAX)
-		iov_to_write = IOV_MAX;
+	if (io->zerocopy_queue_count > 0) {
+		mm_zerocopy_complete(io);
+		if (io->write_queue_count == 0) {
+			/* error notification without pending writes */
+			int error = mm_socket_error(io->fd);
+			if (error > 0) {
+				io->write_status = error;
+				mm_zerocopy_free(io);
+				if (mm_call_is(call, MM_CALL_FLUSH))
+					call->status = error;
+			}
+			mm_write_idle(io);
+			if (io->zerocopy_queue_count == 0)
+				goto wakeup;
+			return;
+		}
+	}
 
 	struct iovec *iov;
 	iov = (struct iovec*)io->write_iov.start + io->write_iov_pos;
+	int zerocopy;
+	int iov_to_write;
+	iov_to_write = mm_write_iov_count(io, iov, &zerocopy);
 	int rc;
-	rc = mm_socket_writev(io->fd, iov, iov_to_write);
+	if (zerocopy) {
+		rc = mm_socket_writev_zerocopy(io->fd, iov, iov_to_write);
+		if (rc == -1 && errno == ENOBUFS && !io->zerocopy_partial) {
+			/* out of socket option memory for pinned pages */
+			zerocopy = 0;
+			rc = mm_socket_writev(io->fd, iov, iov_to_write);
+		}
+	} else {
+		rc = mm_socket_writev(io->fd, iov, iov_to_write);
+	}
 	if (rc == -1) {
 		int errno_ = errno;
-		if (errno_ == EAGAIN || errno_ == EINTR)
+		if (errno_ == EAGAIN || errno_ == EINTR || errno_ == ENOBUFS)
 			return;
 		io->write_status = errno_;
 		if (mm_call_is(call, MM_CALL_FLUSH))
@@ -50,19 +183,33 @@ mm_write_cb(mm_fd_t *handle)
 		goto wakeup;
 	}
 	int written = rc;
+	uint32_t zerocopy_id = 0;
+	if (zerocopy)
+		zerocopy_id = io->zerocopy_id++;
 
 	while (io->write_queue_count > 0)
 	{
 		if (iov->iov_len > (size_t)written) {
 			iov->iov_base = (char*)iov->iov_base + written;
 			iov->iov_len -= written;
+			if (zerocopy && written > 0)
+				io->zerocopy_partial = 1;
 			break;
 		}
 
 		mm_msg_t *msg;
 		msg = mm_container_of(io->write_queue.next, mm_msg_t, link);
 		mm_list_unlink(&msg->link);
-		machine_msg_free((machine_msg_t*)msg);
+		if (msg == io->write_stage)
+			io->write_stage = NULL;
+		if (zerocopy) {
+			msg->zerocopy_id = zerocopy_id;
+			mm_list_append(&io->zerocopy_queue, &msg->link);
+			io->zerocopy_queue_count++;
+			io->zerocopy_partial = 0;
+		} else {
+			machine_msg_free((machine_msg_t*)msg);
+		}
 
 		io->write_queue_count--;
 		io->write_iov_pos++;
@@ -73,13 +220,11 @@ mm_write_cb(mm_fd_t *handle)
 
 	if (io->write_queue_count == 0)
 	{
-		io->write_iov_pos = 0;
-		mm_buf_reset(&io->write_iov);
-
-		mm_machine_t *machine = mm_self;
-		mm_loop_write_stop(&machine->loop, &io->handle);
-
+		mm_write_idle(io);
 		io->write_status = 0;
+		/* flush completes once zero-copy sends are reported */
+		if (io->zerocopy_queue_count > 0)
+			return;
 		goto wakeup;
 	}
 
@@ -92,12 +237,9 @@ wakeup:
 	}
 }
 
-int
-mm_write(mm_io_t *io, machine_msg_t *obj)
+static inline int
+mm_write_queue(mm_io_t *io, mm_msg_t *msg)
 {
-	mm_machine_t *machine = mm_self;
-	mm_msg_t *msg = mm_cast(mm_msg_t*, obj);
-
 	int rc;
 	rc = mm_buf_ensure(&io->write_iov, sizeof(struct iovec));
 	if (rc == -1) {
@@ -112,16 +254,83 @@ mm_write(mm_io_t *io, machine_msg_t *obj)
 
 	mm_list_append(&io->write_queue, &msg->link);
 	io->write_queue_count++;
+	return 0;
+}
 
+static inline int
+mm_write_start(mm_io_t *io)
+{
+	mm_machine_t *machine = mm_self;
+	int rc;
 	rc = mm_loop_write(&machine->loop, &io->handle, mm_write_cb, io);
 	if (rc == -1) {
 		mm_errno_set(errno);
 		return -1;
 	}
-
 	return 0;
 }
 
+int
+mm_write_stage(mm_io_t *io, char *buf, int size)
+{
+	/* append data to the last queued staging buffer, its iovec
+	 * is always the last one and is extended in place. Staging
+	 * buffer is never reallocated, since it can be partially
+	 * written already */
+	mm_msg_t *stage = io->write_stage;
+	if (stage && mm_buf_unused(&stage->data) < size)
+		stage = NULL;
+	if (stage == NULL) {
+		stage = mm_msgcache_pop(mm_self->msg_cache, MM_WRITE_STAGE_SIZE);
+		if (stage == NULL)
+			return -1;
+		stage->type = 0;
+		int rc;
+		rc = mm_buf_ensure(&stage->data, MM_WRITE_STAGE_SIZE);
+		if (rc == -1) {
+			mm_msg_unref(mm_self->msg_cache, stage);
+			mm_errno_set(ENOMEM);
+			return -1;
+		}
+		rc = mm_write_queue(io, stage);
+		if (rc == -1) {
+			mm_msg_unref(mm_self->msg_cache, stage);
+			return -1;
+		}
+		io->write_stage = stage;
+	}
+	memcpy(stage->data.pos, buf, size);
+	mm_buf_advance(&stage->data, size);
+
+	struct iovec *iov;
+	iov = (struct iovec*)io->write_iov.pos - 1;
+	iov->iov_len += size;
+
+	return mm_write_start(io);
+}
+
+int
+mm_write(mm_io_t *io, machine_msg_t *obj)
+{
+	mm_msg_t *msg = mm_cast(mm_msg_t*, obj);
+	int size = mm_buf_used(&msg->data);
+	int rc;
+	if (size <= MM_WRITE_STAGE_MAX) {
+		rc = mm_write_stage(io, msg->data.start, size);
+		if (rc == -1)
+			return -1;
+		machine_msg_free(obj);
+		return 0;
+	}
+
+	rc = mm_write_queue(io, msg);
+	if (rc == -1)
+		return -1;
+	io->write_stage = NULL;
+
+	return mm_write_start(io);
+}
+
 MACHINE_API int
 machine_write(machine_io_t *obj, machine_msg_t *msg)
 {
@@ -145,7 +354,7 @@ machine_write(machine_io_t *obj, machine_msg_t *msg)
 		machine_msg_free(msg);
 		return rc;
 	}
-	if (mm_tlsio_is_active(&io->tls)) {
+	if (mm_tlsio_write_is_active(&io->tls)) {
 		rc = mm_tlsio_write(&io->tls, buf, buf_size);
 		machine_msg_free(msg);
 		return rc;
@@ -160,7 +369,7 @@ machine_write_batch(machine_io_t *obj, machine_channel_t *obj_channel)
 	mm_errno_set(0);
 	mm_channeltype_t *type;
 	type = mm_cast(mm_channeltype_t*, obj_channel);
-	if (type->is_shared) {
+	if (type->type != MM_CHANNEL_FAST) {
 		mm_errno_set(EINVAL);
 		return -1;
 	}
@@ -210,10 +419,14 @@ machine_flush(machine_io_t *obj, uint32_t time_ms)
 		return -1;
 	}
 
-	if (io->write_queue_count == 0)
+	/* reap zero-copy completions already reported */
+	if (io->write_queue_count == 0 && io->zerocopy_queue_count > 0)
+		mm_zerocopy_complete(io);
+
+	if (io->write_queue_count == 0 && io->zerocopy_queue_count == 0)
 		return 0;
 
-	/* wait for write completion */
+	/* wait for write and zero-copy send completion */
 	mm_call(&io->call, MM_CALL_FLUSH, time_ms);
 
 	int rc;
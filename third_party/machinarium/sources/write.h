@@ -7,11 +7,21 @@
  * cooperative multitasking engine.
 */
 
+/* messages up to this size are copied into the io staging
+ * buffer instead of being queued as separate iovecs */
+#define MM_WRITE_STAGE_MAX  512
+#define MM_WRITE_STAGE_SIZE 8192
+
 int mm_write(mm_io_t*, machine_msg_t*);
+int mm_write_stage(mm_io_t*, char*, int);
+void mm_zerocopy_free(mm_io_t*);
+void mm_zerocopy_attach(mm_io_t*);
 
 static inline int
 mm_write_buf(mm_io_t *io, char *buf, int size)
 {
+	if (size <= MM_WRITE_STAGE_MAX)
+		return mm_write_stage(io, buf, size);
 	machine_msg_t *msg;
 	msg = machine_msg_create(size);
 	if (msg == NULL)